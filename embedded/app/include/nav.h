@@ -1,22 +1,44 @@
 #ifndef __NAV_H__
 #define __NAV_H__
 
+#include <ring.h>
+
 void initNav(void);
 
-void showNavData(void);
+enum { NAV_AXIS_X, NAV_AXIS_Y, NAV_AXIS_Z };
+
+/* How the IMU is mounted. By default nav expects the Xsens flat, with the +X
+ * arrow on its case pointing to the nose of the pod, so speeding up reads
+ * positive on X. Mounted any other way, set NAV_IMU_AXIS to the axis along
+ * the track and NAV_IMU_SIGN to -1 if that axis points to the tail, or the
+ * Kalman filter fuses the wrong acceleration. csvFormatShow() during a push
+ * down the track shows which axis moves */
+#ifndef NAV_IMU_AXIS
+#define NAV_IMU_AXIS    NAV_AXIS_X
+#endif
+#ifndef NAV_IMU_SIGN
+#define NAV_IMU_SIGN    1
+#endif
 
-typedef struct rawMotionNode_t {
-    float *data;
-    int head;
-    int size;
-} rawMotionNode_t;
+void showNavData(void);
 
+/* Unfiltered motion, one sample per retro, stamped with the retro's time */
 typedef struct rawMotion_t {
-   rawMotionNode_t pos;
-   rawMotionNode_t vel;
-   rawMotionNode_t accel;
+   tsRing_t pos;
+   tsRing_t vel;
+   tsRing_t accel;
 } rawMotion_t;
 
+/* Read only, for filters, fault checks and logging */
+const rawMotion_t *getRawMotion(void);
+
+/* How data->motion is filled in, one of the FILTER_* defines in data.h. The
+ * default, FILTER_KALMAN, fuses the IMU with the strips every nav tick. The
+ * others only update on strips. Call before initNav(), which sets up the
+ * filter (call that after SetupIMU(), if there is one). Returns -1 once nav is
+ * running */
+int setNavFilter(int type);
+
 
 
 
@@ -0,0 +1,61 @@
+#ifndef __NAV_KALMAN_H__
+#define __NAV_KALMAN_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/***
+ * navKf_t - Kalman filter for position along the track
+ *
+ * Tracks position, velocity and the IMU's acceleration bias. Every nav tick
+ * navKfPredict() moves the state on using the IMU's acceleration, so
+ * velocity follows braking as it happens instead of waiting up to 10 ft for
+ * the next strip. Every strip crossing gives a known position, and
+ * navKfCorrect() pulls the state back onto it. The correction is also how
+ * the filter learns the bias, which is what stops velocity drifting between
+ * strips.
+ *
+ * With no IMU, pass 0 as the acceleration. The bias state then simply becomes
+ * minus the acceleration, and the filter is a constant acceleration model
+ * fitted to the strips. Use NAV_KF_NO_IMU for that, since acceleration
+ * wanders far more than a bias does.
+ *
+ * Everything is fixed size and nothing allocates. Tune the parameters by
+ * running a logged or simulated run through utils/navReplay.
+ */
+
+typedef struct navKfParams_t {
+    double accelNoise;      /* m/s/s, std dev of the IMU's noise */
+    double biasDrift;       /* m/s/s per root second, how fast the bias wanders */
+    double stripNoise;      /* m, std dev of where a strip crossing really is */
+    double initBias;        /* m/s/s, std dev of the bias at the start */
+} navKfParams_t;
+
+#define NAV_KF_DEFAULTS     { 0.5, 0.02, 0.05, 0.3 }
+#define NAV_KF_NO_IMU       { 0.5, 3.0,  0.05, 5.0 }
+
+typedef struct navKf_t {
+    double x[3];            /* pos m, vel m/s, accel bias m/s/s */
+    double P[3][3];         /* Covariance of x */
+    double accel;           /* Last acceleration with the bias taken out */
+    uint64_t time;          /* uS, when x is for */
+    bool started;
+    navKfParams_t params;
+} navKf_t;
+
+enum { NAV_KF_POS, NAV_KF_VEL, NAV_KF_BIAS };
+
+/* Starts stopped at 0. params is copied */
+void navKfInit(navKf_t *kf, const navKfParams_t *params);
+void navKfReset(navKf_t *kf);
+
+/* Moves the state on to time (uS) using the raw acceleration measured since
+ * the last call. The first call only sets the time */
+void navKfPredict(navKf_t *kf, uint64_t time, double accel);
+
+/* The pod was at pos (m) at time. A time a little before the state's, like
+ * a retro that fired between ticks, is carried forward at the current
+ * velocity. Returns how far off the prediction was */
+double navKfCorrect(navKf_t *kf, uint64_t time, double pos);
+
+#endif
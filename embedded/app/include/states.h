@@ -75,6 +75,10 @@
 #define MIN_SOC_RUN 				10
 #define MIN_SOC_POSTRUN				10
 
+/* Longest the BMS can go without a CAN frame while running, in uS. It
+ * broadcasts several messages every 100ms or faster */
+#define BMS_MAX_AGE_US				250000
+
 /* RMS Acceptable Limits FIXME is this too hot?*/
 #define MIN_IGBT_TEMP				10
 #define MAX_IGBT_TEMP_PRERUN		50
@@ -86,6 +90,10 @@
 #define MAX_GATE_TEMP_RUN			100
 #define MAX_GATE_TEMP_POSTRUN		100
 
+/* Longest the RMS can go without a CAN frame while running, in uS. The fast
+ * broadcast messages come in every 10ms */
+#define RMS_MAX_AGE_US				50000
+
 #define MIN_CONTROL_TEMP			10
 #define MAX_CONTROL_TEMP_IDLE		50
 #define MAX_CONTROL_TEMP_PUMP		88
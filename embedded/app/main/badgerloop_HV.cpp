@@ -23,6 +23,7 @@ extern "C"
     #include "can_devices.h"
     #include "state_machine.h"
     #include "NCD9830DBR2G.h"
+    #include "periodic.h"
 }
 void emergQuitter(int sig, siginfo_t* inf, void *nul) {
     printf("shutdown\n");
@@ -32,6 +33,8 @@ void emergQuitter(int sig, siginfo_t* inf, void *nul) {
     rmsDischarge();
     sleep(1);
     rmsInvDis();
+    /* Only once HV is safe */
+    periodicShowAll();
     exit(0);
 }
 
@@ -68,12 +71,14 @@ int main() {
 	/* Create the big data structures to house pod data */
 	int i = 0;
 	char buffer[100];
+    periodic_t task;
     
     if (init() == 1) {
 		fprintf(stderr, "Error in initialization! Exiting...\r\n");
 		exit(1);
 	}
 
+    periodicInit(&task, "stateMachine", 10000);
 	while(1) {
 	    runStateMachine();
         
@@ -100,13 +105,13 @@ int main() {
         }
         
         if (i >= 50) {
-            sprintf(buffer, "state%d\n", data->state == 1);
+            sprintf(buffer, "state %d\n", data->state == 1);
             signalLV((char *) buffer);
             i = 0;
         } else {
             i += 1;
         }
-        usleep(10000);
+        periodicWait(&task);
 
 		// Control loop
 	}
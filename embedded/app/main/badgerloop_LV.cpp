@@ -17,6 +17,7 @@ extern "C"
     #include "proc_iox.h"
 	#include "imu.h"
     #include <data.h>
+    #include <periodic.h>
 }
 
 int init() {
@@ -35,7 +36,8 @@ int init() {
     
     /* Init telemetry services */
 	
-    SetupLVTelemetry((char *) DASHBOARD_IP, DASHBOARD_PORT);
+    /* The dashboard still reads JSON, HV_Telem_Recv takes the binary packets */
+    SetupLVTelemetry((char *) DASHBOARD_IP, DASHBOARD_PORT, TELEM_JSON, TELEM_BINARY);
 	SetupLVTCPServer();
     data->state = 1;
     return 0;
@@ -48,8 +50,10 @@ int main() {
 		exit(1);
 	}
     int errs = 0;
+    periodic_t task;
+    periodicInit(&task, "lvMain", 100000);
     while(1) {
-		usleep(100000);
+		periodicWait(&task);
         if (errs > 50) brake();
         
         if (data->flags->shouldBrake) {
@@ -19,24 +19,26 @@
 extern data_t *data;
 
 bool checkPrerunBattery(void){
-	if(data->bms->highTemp > MAX_BATT_TEMP_PRERUN){
-		printf("Temp too high: %i\n", data->bms->highTemp);
+	bms_t bms;
+	getBmsSnapshot(&bms);
+	if(bms.highTemp > MAX_BATT_TEMP_PRERUN){
+		printf("Temp too high: %i\n", bms.highTemp);
 		return false;
 	}
-	if(data->bms->packCurrent > MAX_BATT_CURRENT_STILL){
-		printf("Pack Current too high: %f\n", data->bms->packCurrent);
+	if(bms.packCurrent > MAX_BATT_CURRENT_STILL){
+		printf("Pack Current too high: %f\n", bms.packCurrent);
 		return false;
 	}
-	if(data->bms->cellMaxVoltage > MAX_CELL_VOLTAGE || data->bms->cellMinVoltage < MIN_CELL_VOLTAGE){
-		printf("Cell Voltage Error: %f, %f\n", data->bms->cellMinVoltage, data->bms->cellMaxVoltage);
+	if(bms.cellMaxVoltage > MAX_CELL_VOLTAGE || bms.cellMinVoltage < MIN_CELL_VOLTAGE){
+		printf("Cell Voltage Error: %f, %f\n", bms.cellMinVoltage, bms.cellMaxVoltage);
 		return false;
 	}
-	if(data->bms->packVoltage > MAX_PACK_VOLTAGE || data->bms->packVoltage < MIN_PACK_VOLTAGE_PRERUN){
-		printf("Pack Voltage Error: %f\n", data->bms->packVoltage);
+	if(bms.packVoltage > MAX_PACK_VOLTAGE || bms.packVoltage < MIN_PACK_VOLTAGE_PRERUN){
+		printf("Pack Voltage Error: %f\n", bms.packVoltage);
 		return false;
 	}
-	if(data->bms->Soc < MIN_SOC_PRERUN){
-		printf("SOC is less than expected: %i\n", data->bms->Soc);
+	if(bms.Soc < MIN_SOC_PRERUN){
+		printf("SOC is less than expected: %i\n", bms.Soc);
 		return false;
 	}
 	
@@ -44,24 +46,30 @@ bool checkPrerunBattery(void){
 }
 
 bool checkRunBattery(void){
-	if(data->bms->highTemp > MAX_BATT_TEMP_RUN){
-		printf("Temp too high: %i\n", data->bms->highTemp);
+	bms_t bms;
+	getBmsSnapshot(&bms);
+	if(isStale(&bms.rx, BMS_MAX_AGE_US)){
+		printf("BMS data stale: %llu us old\n", (unsigned long long) rxAge(&bms.rx));
 		return false;
 	}
-	if(data->bms->packCurrent > MAX_BATT_CURRENT_MOVING){
-		printf("Pack Current too high: %f\n", data->bms->packCurrent);
+	if(bms.highTemp > MAX_BATT_TEMP_RUN){
+		printf("Temp too high: %i\n", bms.highTemp);
 		return false;
 	}
-	if(data->bms->cellMaxVoltage > MAX_CELL_VOLTAGE || data->bms->cellMinVoltage < MIN_CELL_VOLTAGE){
-		printf("Cell Voltage Error: %f, %f\n", data->bms->cellMinVoltage, data->bms->cellMaxVoltage);
+	if(bms.packCurrent > MAX_BATT_CURRENT_MOVING){
+		printf("Pack Current too high: %f\n", bms.packCurrent);
 		return false;
 	}
-	if(data->bms->packVoltage > MAX_PACK_VOLTAGE || data->bms->packVoltage < MIN_PACK_VOLTAGE_RUN){
-		printf("Pack Voltage Error: %f\n", data->bms->packVoltage);
+	if(bms.cellMaxVoltage > MAX_CELL_VOLTAGE || bms.cellMinVoltage < MIN_CELL_VOLTAGE){
+		printf("Cell Voltage Error: %f, %f\n", bms.cellMinVoltage, bms.cellMaxVoltage);
 		return false;
 	}
-	if(data->bms->Soc < MIN_SOC_RUN){
-		printf("SOC is less than expected: %i", data->bms->Soc);
+	if(bms.packVoltage > MAX_PACK_VOLTAGE || bms.packVoltage < MIN_PACK_VOLTAGE_RUN){
+		printf("Pack Voltage Error: %f\n", bms.packVoltage);
+		return false;
+	}
+	if(bms.Soc < MIN_SOC_RUN){
+		printf("SOC is less than expected: %i", bms.Soc);
 		return false;
 	}
 	
@@ -69,24 +77,26 @@ bool checkRunBattery(void){
 }
 
 bool checkBrakingBattery(void){
-	if(data->bms->highTemp > MAX_BATT_TEMP_RUN){
-		printf("Temp too high: %i\n", data->bms->highTemp);
+	bms_t bms;
+	getBmsSnapshot(&bms);
+	if(bms.highTemp > MAX_BATT_TEMP_RUN){
+		printf("Temp too high: %i\n", bms.highTemp);
 		return false;
 	}
-	if(data->bms->packCurrent > MAX_BATT_CURRENT_STILL){
-		printf("Pack Current too high: %f\n", data->bms->packCurrent);
+	if(bms.packCurrent > MAX_BATT_CURRENT_STILL){
+		printf("Pack Current too high: %f\n", bms.packCurrent);
 		return false;
 	}
-	if(data->bms->cellMaxVoltage > MAX_CELL_VOLTAGE || data->bms->cellMinVoltage < MIN_CELL_VOLTAGE){
-		printf("Cell Voltage Error: %f, %f\n", data->bms->cellMinVoltage, data->bms->cellMaxVoltage);
+	if(bms.cellMaxVoltage > MAX_CELL_VOLTAGE || bms.cellMinVoltage < MIN_CELL_VOLTAGE){
+		printf("Cell Voltage Error: %f, %f\n", bms.cellMinVoltage, bms.cellMaxVoltage);
 		return false;
 	}
-	if(data->bms->packVoltage > MAX_PACK_VOLTAGE || data->bms->packVoltage < MIN_PACK_VOLTAGE_RUN){
-		printf("Pack Voltage Error: %f\n", data->bms->packVoltage);
+	if(bms.packVoltage > MAX_PACK_VOLTAGE || bms.packVoltage < MIN_PACK_VOLTAGE_RUN){
+		printf("Pack Voltage Error: %f\n", bms.packVoltage);
 		return false;
 	}
-	if(data->bms->Soc < MIN_SOC_RUN){
-		printf("SOC is less than expected: %i", data->bms->Soc);
+	if(bms.Soc < MIN_SOC_RUN){
+		printf("SOC is less than expected: %i", bms.Soc);
 		return false;
 	}
 	
@@ -94,24 +104,26 @@ bool checkBrakingBattery(void){
 }
 
 bool checkStoppedBattery(void){
-	if(data->bms->highTemp > MAX_BATT_TEMP_RUN){
-		printf("Temp too high: %i\n", data->bms->highTemp);
+	bms_t bms;
+	getBmsSnapshot(&bms);
+	if(bms.highTemp > MAX_BATT_TEMP_RUN){
+		printf("Temp too high: %i\n", bms.highTemp);
 		return false;
 	}
-	if(data->bms->packCurrent > MAX_BATT_CURRENT_STILL){
-		printf("Pack Current too high: %f\n", data->bms->packCurrent);
+	if(bms.packCurrent > MAX_BATT_CURRENT_STILL){
+		printf("Pack Current too high: %f\n", bms.packCurrent);
 		return false;
 	}
-	if(data->bms->cellMaxVoltage > MAX_CELL_VOLTAGE || data->bms->cellMinVoltage < MIN_CELL_VOLTAGE){
-		printf("Cell Voltage Error: %f, %f\n", data->bms->cellMinVoltage, data->bms->cellMaxVoltage);
+	if(bms.cellMaxVoltage > MAX_CELL_VOLTAGE || bms.cellMinVoltage < MIN_CELL_VOLTAGE){
+		printf("Cell Voltage Error: %f, %f\n", bms.cellMinVoltage, bms.cellMaxVoltage);
 		return false;
 	}
-	if(data->bms->packVoltage > MAX_PACK_VOLTAGE || data->bms->packVoltage < MIN_PACK_VOLTAGE_RUN){
-		printf("Pack Voltage Error: %f\n", data->bms->packVoltage);
+	if(bms.packVoltage > MAX_PACK_VOLTAGE || bms.packVoltage < MIN_PACK_VOLTAGE_RUN){
+		printf("Pack Voltage Error: %f\n", bms.packVoltage);
 		return false;
 	}
-	if(data->bms->Soc < MIN_SOC_RUN){
-		printf("SOC is less than expected: %i", data->bms->Soc);
+	if(bms.Soc < MIN_SOC_RUN){
+		printf("SOC is less than expected: %i", bms.Soc);
 		return false;
 	}
 	
@@ -119,24 +131,26 @@ bool checkStoppedBattery(void){
 }
 
 bool checkCrawlBattery(void){
-	if(data->bms->highTemp > MAX_BATT_TEMP_RUN){
-		printf("Temp too high: %i\n", data->bms->highTemp);
+	bms_t bms;
+	getBmsSnapshot(&bms);
+	if(bms.highTemp > MAX_BATT_TEMP_RUN){
+		printf("Temp too high: %i\n", bms.highTemp);
 		return false;
 	}
-	if(data->bms->packCurrent > MAX_BATT_CURRENT_MOVING){
-		printf("Pack Current too high: %f\n", data->bms->packCurrent);
+	if(bms.packCurrent > MAX_BATT_CURRENT_MOVING){
+		printf("Pack Current too high: %f\n", bms.packCurrent);
 		return false;
 	}
-	if(data->bms->cellMaxVoltage > MAX_CELL_VOLTAGE || data->bms->cellMinVoltage < MIN_CELL_VOLTAGE){
-		printf("Cell Voltage Error: %f, %f\n", data->bms->cellMinVoltage, data->bms->cellMaxVoltage);
+	if(bms.cellMaxVoltage > MAX_CELL_VOLTAGE || bms.cellMinVoltage < MIN_CELL_VOLTAGE){
+		printf("Cell Voltage Error: %f, %f\n", bms.cellMinVoltage, bms.cellMaxVoltage);
 		return false;
 	}
-	if(data->bms->packVoltage > MAX_PACK_VOLTAGE || data->bms->packVoltage < MIN_PACK_VOLTAGE_POSTRUN){
-		printf("Pack Voltage Error: %f\n", data->bms->packVoltage);
+	if(bms.packVoltage > MAX_PACK_VOLTAGE || bms.packVoltage < MIN_PACK_VOLTAGE_POSTRUN){
+		printf("Pack Voltage Error: %f\n", bms.packVoltage);
 		return false;
 	}
-	if(data->bms->Soc < MIN_SOC_POSTRUN){
-		printf("SOC is less than expected: %i", data->bms->Soc);
+	if(bms.Soc < MIN_SOC_POSTRUN){
+		printf("SOC is less than expected: %i", bms.Soc);
 		return false;
 	}
 	
@@ -144,24 +158,26 @@ bool checkCrawlBattery(void){
 }
 
 bool checkPostrunBattery(void){
-	if(data->bms->highTemp > MAX_BATT_TEMP_RUN){
-		printf("Temp too high: %i\n", data->bms->highTemp);
+	bms_t bms;
+	getBmsSnapshot(&bms);
+	if(bms.highTemp > MAX_BATT_TEMP_RUN){
+		printf("Temp too high: %i\n", bms.highTemp);
 		return false;
 	}
-	if(data->bms->packCurrent > MAX_BATT_CURRENT_STILL){
-		printf("Pack Current too high: %f\n", data->bms->packCurrent);
+	if(bms.packCurrent > MAX_BATT_CURRENT_STILL){
+		printf("Pack Current too high: %f\n", bms.packCurrent);
 		return false;
 	}
-	if(data->bms->cellMaxVoltage > MAX_CELL_VOLTAGE || data->bms->cellMinVoltage < MIN_CELL_VOLTAGE){
-		printf("Cell Voltage Error: %f, %f\n", data->bms->cellMinVoltage, data->bms->cellMaxVoltage);
+	if(bms.cellMaxVoltage > MAX_CELL_VOLTAGE || bms.cellMinVoltage < MIN_CELL_VOLTAGE){
+		printf("Cell Voltage Error: %f, %f\n", bms.cellMinVoltage, bms.cellMaxVoltage);
 		return false;
 	}
-	if(data->bms->packVoltage > MAX_PACK_VOLTAGE || data->bms->packVoltage < MIN_PACK_VOLTAGE_POSTRUN){
-		printf("Pack Voltage Error: %f\n", data->bms->packVoltage);
+	if(bms.packVoltage > MAX_PACK_VOLTAGE || bms.packVoltage < MIN_PACK_VOLTAGE_POSTRUN){
+		printf("Pack Voltage Error: %f\n", bms.packVoltage);
 		return false;
 	}
-	if(data->bms->Soc < MIN_SOC_POSTRUN){
-		printf("SOC is less than expected: %i", data->bms->Soc);
+	if(bms.Soc < MIN_SOC_POSTRUN){
+		printf("SOC is less than expected: %i", bms.Soc);
 		return false;
 	}
 	
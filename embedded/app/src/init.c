@@ -71,6 +71,7 @@ int initMetaData() {
 }
 
 int initPressureData() {
+    data->pressure->lock.seq = 0;
     data->pressure->primTank = 0;
 	data->pressure->primLine = 0;
 	data->pressure->primAct  = 0;
@@ -82,6 +83,7 @@ int initPressureData() {
 }
 
 int initMotionData() {
+	data->motion->lock.seq = 0;
 	data->motion->pos = 0;
 	data->motion->vel = 0;
 	data->motion->accel = 0;
@@ -90,6 +92,9 @@ int initMotionData() {
 }
 
 int initBmsData() {
+	data->bms->rx.time = 0;
+	data->bms->rx.seq = 0;
+	data->bms->lock.seq = 0;
 	data->bms->packCurrent = 0;
 	data->bms->packVoltage = 0;
 	data->bms->packDCL = 0;
@@ -113,6 +118,9 @@ int initBmsData() {
 }
 
 int initRmsData() {
+	data->rms->rx.time = 0;
+	data->rms->rx.seq = 0;
+	data->rms->lock.seq = 0;
 	data->rms->igbtTemp = 0;
 	data->rms->gateDriverBoardTemp = 0;
 	data->rms->controlBoardTemp = 0;
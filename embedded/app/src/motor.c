@@ -8,6 +8,7 @@
 #include <unistd.h>
 #include <hv_iox.h>
 #include <data.h>
+#include <periodic.h>
 /***
  * The high level interface for the motor
  */
@@ -50,6 +51,8 @@ void SetupMotor() {
 
 static void *motorHbLoop(void *arg) {
     (void) arg;
+    periodic_t task;
+    periodicInit(&task, "motorHb", HB_PERIOD);
     while(1) {
         if (motorEnabled)
             rmsSendHbMsg(2);
@@ -57,7 +60,7 @@ static void *motorHbLoop(void *arg) {
             rmsSendHbMsg(2);
         else
             rmsIdleHb();
-        usleep(10000);
+        periodicWait(&task);
     }
     
     return NULL;
@@ -4,9 +4,12 @@
 #include <stdlib.h>
 #include <pthread.h>
 #include <data.h>
+#include <filters.h>
 #include <imu.h>
 #include <nav.h>
+#include <navKalman.h>
 #include <connStat.h>
+#include <periodic.h>
 
 #define FEET_TO_METERS(x) ((x) * 0.3048)
 #define USEC_TO_SEC(x)    ((x) / 1000000)
@@ -16,37 +19,42 @@
 #define EXPECTED_DECEL 9.8  /* m/s/s */
 
 #define WINDOW_SIZE    2
+#define NAV_HISTORY    64      /* Retros of raw motion kept */
+#define NAV_PERIOD     10000   /* uS */
+
+#ifdef DEBUG_NAV
+/* One line per tick in the format utils/navReplay reads */
+#define NAV_LOG(t, a, c, r) printf("%llu,%f,%d,%llu\n", (unsigned long long) (t), (a), (c), \
+        (unsigned long long) (r))
+#else
+#define NAV_LOG(t, a, c, r)
+#endif
 
 static pthread_t navThread;
-static pthread_mutex_t lock;
 
 static void navLoop(void *arg);
-static void insertRing(rawMotionNode_t *node, float val);
 
 static rawMotion_t rawData;
+static rollMean_t posMean, velMean, accelMean;     /* FILTER_ROLLING */
+static navKf_t kf;
+static int navFilter = FILTER_KALMAN;
+static volatile bool clearKf = false;     /* resetNav() is for the nav thread */
+static bool navStarted = false;           /* kf and navFilter are the nav thread's from then */
 
 void initNav() {
 
-    rawData.pos.size    = WINDOW_SIZE;
-    rawData.pos.head    = 0;
-    rawData.pos.data    = (float *) malloc(sizeof(float) * rawData.pos.size);
-    if (rawData.pos.data == NULL) fprintf(stderr, "Nav data malloc fail\n");
-
-    rawData.vel.size    = WINDOW_SIZE;
-    rawData.vel.head    = 0;
-    rawData.vel.data    = (float *) malloc(sizeof(float) * rawData.vel.size);
-    if (rawData.vel.data == NULL) fprintf(stderr, "Nav data malloc fail\n");
-
-    rawData.accel.size  = WINDOW_SIZE;
-    rawData.accel.head  = 0;
-    rawData.accel.data  = (float *) malloc(sizeof(float) * rawData.accel.size);
-    if (rawData.accel.data == NULL) fprintf(stderr, "Nav data malloc fail\n");
-
-
-    if (pthread_mutex_init(&lock, NULL) != 0) {
-        fprintf(stderr, "Error creating nav mutex\n");
+    if (tsRingInit(&rawData.pos, NAV_HISTORY) != 0 ||
+            tsRingInit(&rawData.vel, NAV_HISTORY) != 0 ||
+            tsRingInit(&rawData.accel, NAV_HISTORY) != 0 ||
+            rollMeanInit(&posMean, WINDOW_SIZE) != 0 ||
+            rollMeanInit(&velMean, WINDOW_SIZE) != 0 ||
+            rollMeanInit(&accelMean, WINDOW_SIZE) != 0) {
+        fprintf(stderr, "Nav data malloc fail\n");
     }
+    navKfParams_t withImu = NAV_KF_DEFAULTS, noImu = NAV_KF_NO_IMU;
+    navKfInit(&kf, IMUReady() ? &withImu : &noImu);
 
+    navStarted = true;
     if (pthread_create(&navThread, NULL, (void *)(navLoop), NULL) != 0) {
         fprintf(stderr, "Error creating nav thread\n");
     }
@@ -69,97 +77,163 @@ void csvFormatShow() {
            data->motion->pos, data->motion->vel, data->motion->accel);
 }
 
-/* Returns m/s/s */
-static inline float accelFromRetro(float currVel) {
-   return (currVel - data->motion->vel) /
-       USEC_TO_SEC((float)data->timers->lastRetro - (float)data->timers->oldRetro); 
+/* IMU acceleration down the track, m/s/s, see NAV_IMU_AXIS */
+static float imuTrackAccel() {
+    float accel;
+    switch (NAV_IMU_AXIS) {
+        case NAV_AXIS_Y: accel = getAccelY(); break;
+        case NAV_AXIS_Z: accel = getAccelZ(); break;
+        default:         accel = getAccelX(); break;
+    }
+    return NAV_IMU_SIGN * accel;
 }
 
-/* Returns m/s */
-static inline float velFromRetro(float currPos) {
-   return (currPos - data->motion->pos) /
-       USEC_TO_SEC((float)data->timers->lastRetro - (float)data->timers->oldRetro); 
+/* Change per second since the ring's newest sample, taken before the new
+ * one is pushed. The raw rings only ever hold retro values, so this doesn't
+ * depend on which filter is writing data->motion */
+static float rateFromLast(const tsRing_t *ring, uint64_t time, float curr) {
+    tsSample_t prev;
+    if (tsRingAt(ring, 0, &prev) != 0 || time <= prev.time) return 0;
+    return (curr - prev.val) / USEC_TO_SEC((float)(time - prev.time));
 }
 
 
 void updateRawMotionData() {
     float vel, accel, pos;
+    uint64_t time = data->timers->lastRetro;
 
     pos = data->motion->retroCount * STRIP_DISTANCE;
-    vel = velFromRetro(pos);
-    accel = accelFromRetro(vel);
+    vel = rateFromLast(&rawData.pos, time, pos);
+    accel = rateFromLast(&rawData.vel, time, vel);
+    /* resetNav() may have cleared the rings from another thread */
+    if (tsRingCount(&rawData.pos) == 0) {
+        rollMeanReset(&posMean);
+        rollMeanReset(&velMean);
+        rollMeanReset(&accelMean);
+    }
+    rollMeanPush(&posMean, pos);
+    rollMeanPush(&velMean, vel);
+    rollMeanPush(&accelMean, accel);
     /* note: we want to reset xsens pos. too, stop drift*/
-    pthread_mutex_lock(&lock);
-    insertRing(&rawData.pos, pos);
-    insertRing(&rawData.vel, vel);
-    insertRing(&rawData.accel, accel);  /* Would be interesting to see diff w/IMU */
-    pthread_mutex_unlock(&lock);
+    tsRingPush(&rawData.pos, time, pos);
+    tsRingPush(&rawData.vel, time, vel);
+    tsRingPush(&rawData.accel, time, accel);  /* Would be interesting to see diff w/IMU */
+}
+
+const rawMotion_t *getRawMotion() {
+    return &rawData;
 }
 
-/* Should be holding mutex already */
-static void insertRing(rawMotionNode_t *node, float val) {
-    node->data[node->head] = val;
-    node->head = (node->head + 1) % node->size;
+/* Newest sample blended with the one before it, or just the newest if
+ * there is only one */
+static float expLatest(const tsRing_t *ring, float weight) {
+    tsSample_t curr = {0, 0}, prev;
+    tsRingLatest(ring, &curr);
+    if (tsRingAt(ring, 1, &prev) != 0) return curr.val;
+    return expFilterFloat(curr.val, prev.val, weight);
+}
+
+static float latest(const tsRing_t *ring) {
+    tsSample_t curr = {0, 0};
+    tsRingLatest(ring, &curr);
+    return curr.val;
+}
+
+int setNavFilter(int type) {
+    if (navStarted) {
+        fprintf(stderr, "Nav filter can't change once nav is running\n");
+        return -1;
+    }
+    navFilter = type;
+    return 0;
 }
 
 /* Only choose one of these two */
 void filterMotion(int filterType) {
     float pos, vel, accel;
-    pthread_mutex_lock(&lock);
+    if (tsRingCount(&rawData.pos) == 0) return;
     if (filterType == FILTER_ROLLING) {
-        pos = rollingAvgFloat(rawData.pos.data, rawData.pos.size);
-        vel = rollingAvgFloat(rawData.vel.data, rawData.vel.size);
-        accel = rollingAvgFloat(rawData.accel.data, rawData.accel.size);
+        pos = rollMeanGet(&posMean);
+        vel = rollMeanGet(&velMean);
+        accel = rollMeanGet(&accelMean);
     } else if (filterType == FILTER_EXP) {
-        pos = expFilterFloat(rawData.pos.data[rawData.pos.head], 
-                rawData.pos.data[rawData.pos.head == 0 ? rawData.pos.size - 1 : rawData.pos.head - 1],
-                .9);
-        vel = expFilterFloat(rawData.vel.data[rawData.vel.head], 
-                rawData.vel.data[rawData.vel.head == 0 ? rawData.vel.size - 1 : rawData.vel.head - 1],
-                .9);
-        accel = expFilterFloat(rawData.accel.data[rawData.accel.head], 
-                    rawData.accel.data[rawData.accel.head == 0 ? rawData.accel.size - 1 : rawData.accel.head - 1],
-                    .9);
+        pos = expLatest(&rawData.pos, .9);
+        vel = expLatest(&rawData.vel, .9);
+        accel = expLatest(&rawData.accel, .9);
     } else {
-        pos = rawData.pos.data[rawData.pos.head];
-        vel = rawData.vel.data[rawData.vel.head];
-        accel = rawData.accel.data[rawData.accel.head];
+        pos = latest(&rawData.pos);
+        vel = latest(&rawData.vel);
+        accel = latest(&rawData.accel);
     }
-    pthread_mutex_unlock(&lock);
+    seqWriteBegin(&data->motion->lock);
     data->motion->pos = pos;
     data->motion->vel = vel;
     data->motion->accel = accel;
+    seqWriteEnd(&data->motion->lock);
 }
 
 void resetNav();
 void resetNav() {
+    seqWriteBegin(&data->motion->lock);
     data->motion->pos = 0;
     data->motion->vel = 0;
     data->motion->accel = 0;
     data->motion->retroCount = 0;
+    seqWriteEnd(&data->motion->lock);
+    tsRingClear(&rawData.pos);
+    tsRingClear(&rawData.vel);
+    tsRingClear(&rawData.accel);
+    clearKf = true;
 
     /* reset rest */
 }
 
 /* TODO Open Qs
  *      1. Find out how bad drift is
- *      2. Are we going in X or Y plane
+ *      2. Are we going in X or Y plane (set by NAV_IMU_AXIS)
  */
 void navLoop(void *unused) {
     (void) unused;
     
-    int lastRetroCount = 0;
+    int lastRetroCount = 0, retroCount;
+    uint64_t now;
+    float accel;
+    periodic_t task;
     data->motion->missedRetro = 0;
+    periodicInit(&task, "nav", NAV_PERIOD);
     csvFormatHeader();
     while (1) {
-        if (lastRetroCount != data->motion->retroCount) {
+        now = getuSTimestamp();
+        accel = IMUReady() ? imuTrackAccel() : 0;
+        retroCount = data->motion->retroCount;
+        NAV_LOG(now, accel, retroCount, data->timers->lastRetro);
+        if (clearKf) {
+            clearKf = false;
+            navKfReset(&kf);
+        }
+
+        if (lastRetroCount != retroCount) {
             updateRawMotionData();
-            filterMotion(FILTER_NONE);
+            if (navFilter == FILTER_KALMAN) {
+                navKfCorrect(&kf, data->timers->lastRetro, retroCount * STRIP_DISTANCE);
+            } else {
+                filterMotion(navFilter);
+            }
+        }
+
+        /* Runs every tick, not just on strips */
+        if (navFilter == FILTER_KALMAN) {
+            navKfPredict(&kf, now, accel);
+            seqWriteBegin(&data->motion->lock);
+            data->motion->pos = kf.x[NAV_KF_POS];
+            data->motion->vel = kf.x[NAV_KF_VEL];
+            data->motion->accel = kf.accel;
+            seqWriteEnd(&data->motion->lock);
         }
     
-        lastRetroCount = data->motion->retroCount;
+        lastRetroCount = retroCount;
     /*    showNavData();   */
     /*    csvFormatShow(); */
-        usleep(10000);  /* Runs at 10ms */
+        periodicWait(&task);
     }
 }
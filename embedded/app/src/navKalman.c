@@ -0,0 +1,100 @@
+#include <string.h>
+#include <navKalman.h>
+
+#define USEC_TO_SEC(x)  ((x) / 1000000.0)
+
+void navKfInit(navKf_t *kf, const navKfParams_t *params) {
+    kf->params = *params;
+    navKfReset(kf);
+}
+
+void navKfReset(navKf_t *kf) {
+    memset(kf->x, 0, sizeof(kf->x));
+    memset(kf->P, 0, sizeof(kf->P));
+    /* Sitting still at the start of the track, only the bias is unknown */
+    kf->P[NAV_KF_BIAS][NAV_KF_BIAS] = kf->params.initBias * kf->params.initBias;
+    kf->accel = 0;
+    kf->time = 0;
+    kf->started = false;
+}
+
+void navKfPredict(navKf_t *kf, uint64_t time, double accel) {
+    double F[3][3], FP[3][3], G[3];
+    double dt, a, q;
+    int i, j, k;
+
+    if (!kf->started || time <= kf->time) {
+        if (!kf->started) kf->time = time;
+        kf->started = true;
+        kf->accel = accel - kf->x[NAV_KF_BIAS];
+        return;
+    }
+    dt = USEC_TO_SEC((double) (time - kf->time));
+    kf->time = time;
+
+    a = accel - kf->x[NAV_KF_BIAS];
+    kf->x[NAV_KF_POS] += kf->x[NAV_KF_VEL] * dt + 0.5 * a * dt * dt;
+    kf->x[NAV_KF_VEL] += a * dt;
+    kf->accel = a;
+
+    /* How each state depends on the last one, the bias is taken off accel */
+    memset(F, 0, sizeof(F));
+    F[0][0] = 1; F[0][1] = dt; F[0][2] = -0.5 * dt * dt;
+    F[1][1] = 1; F[1][2] = -dt;
+    F[2][2] = 1;
+
+    /* P = F P F' + Q */
+    for (i = 0; i < 3; i++) {
+        for (j = 0; j < 3; j++) {
+            FP[i][j] = 0;
+            for (k = 0; k < 3; k++) FP[i][j] += F[i][k] * kf->P[k][j];
+        }
+    }
+    for (i = 0; i < 3; i++) {
+        for (j = 0; j < 3; j++) {
+            kf->P[i][j] = 0;
+            for (k = 0; k < 3; k++) kf->P[i][j] += FP[i][k] * F[j][k];
+        }
+    }
+
+    /* IMU noise comes in through the acceleration, bias drift on its own */
+    G[0] = 0.5 * dt * dt;
+    G[1] = dt;
+    G[2] = 0;
+    q = kf->params.accelNoise * kf->params.accelNoise;
+    for (i = 0; i < 3; i++) {
+        for (j = 0; j < 3; j++) kf->P[i][j] += G[i] * G[j] * q;
+    }
+    kf->P[2][2] += kf->params.biasDrift * kf->params.biasDrift * dt;
+}
+
+double navKfCorrect(navKf_t *kf, uint64_t time, double pos) {
+    double K[3], P0[3], S, innov;
+    int i, j;
+
+    if (time > kf->time) {
+        navKfPredict(kf, time, kf->accel + kf->x[NAV_KF_BIAS]);
+    } else {
+        pos += kf->x[NAV_KF_VEL] * USEC_TO_SEC((double) (kf->time - time));
+    }
+
+    /* Only position is measured, so H = [1 0 0] and S is a scalar */
+    S = kf->P[0][0] + kf->params.stripNoise * kf->params.stripNoise;
+    for (i = 0; i < 3; i++) {
+        K[i] = kf->P[i][0] / S;
+        P0[i] = kf->P[0][i];
+    }
+    innov = pos - kf->x[NAV_KF_POS];
+    for (i = 0; i < 3; i++) kf->x[i] += K[i] * innov;
+
+    /* P = (I - K H) P, then keep it symmetric against rounding */
+    for (i = 0; i < 3; i++) {
+        for (j = 0; j < 3; j++) kf->P[i][j] -= K[i] * P0[j];
+    }
+    for (i = 0; i < 3; i++) {
+        for (j = i + 1; j < 3; j++) {
+            kf->P[i][j] = kf->P[j][i] = 0.5 * (kf->P[i][j] + kf->P[j][i]);
+        }
+    }
+    return innov;
+}
@@ -17,31 +17,33 @@
 #include "pressure_fault_checking.h"
 
 bool checkIdlePressures(void) {
-    if (data->pressure->primTank < PS1_BOTTOM_LIMIT_IDLE || data->pressure->primTank > PS1_TOP_LIMIT_IDLE) {
+    pressure_t pressure;
+    getPressureSnapshot(&pressure);
+    if (pressure.primTank < PS1_BOTTOM_LIMIT_IDLE || pressure.primTank > PS1_TOP_LIMIT_IDLE) {
 		fprintf(stderr, "primTank pressure failing\n");
 		return false;
 	}
-	if (data->pressure->primLine < PS2_BOTTOM_LIMIT_IDLE || data->pressure->primLine > PS2_TOP_LIMIT_IDLE) {
+	if (pressure.primLine < PS2_BOTTOM_LIMIT_IDLE || pressure.primLine > PS2_TOP_LIMIT_IDLE) {
 		fprintf(stderr, "primLine pressure failing\n");
 		return false;
 	}
-	if (data->pressure->primAct < PS3_BOTTOM_LIMIT_IDLE || data->pressure->primAct > PS3_TOP_LIMIT_IDLE) {
+	if (pressure.primAct < PS3_BOTTOM_LIMIT_IDLE || pressure.primAct > PS3_TOP_LIMIT_IDLE) {
 		fprintf(stderr, "primAct pressure failing\n");
 		return false;
 	}
-	if (data->pressure->secTank < SEC_PS1_BOTTOM_LIMIT_IDLE || data->pressure->secTank > SEC_PS1_TOP_LIMIT_IDLE) {
+	if (pressure.secTank < SEC_PS1_BOTTOM_LIMIT_IDLE || pressure.secTank > SEC_PS1_TOP_LIMIT_IDLE) {
 		fprintf(stderr, "Secondary primTank pressure failing\n");
 		return false;
 	}
-	if (data->pressure->secLine < SEC_PS2_BOTTOM_LIMIT_IDLE || data->pressure->secLine > SEC_PS2_TOP_LIMIT_IDLE) {
+	if (pressure.secLine < SEC_PS2_BOTTOM_LIMIT_IDLE || pressure.secLine > SEC_PS2_TOP_LIMIT_IDLE) {
 		fprintf(stderr, "Secondary primLine pressure failing\n");
 		return false;
 	}
-	if (data->pressure->secAct < SEC_PS3_BOTTOM_LIMIT_IDLE || data->pressure->secAct > SEC_PS3_TOP_LIMIT_IDLE) {
+	if (pressure.secAct < SEC_PS3_BOTTOM_LIMIT_IDLE || pressure.secAct > SEC_PS3_TOP_LIMIT_IDLE) {
 		fprintf(stderr, "Secondary primAct pressure failing\n");
 		return false;
 	}
-	if (data->pressure->pv < PV_BOTTOM_LIMIT || data->pressure->pv > PV_TOP_LIMIT) {
+	if (pressure.pv < PV_BOTTOM_LIMIT || pressure.pv > PV_TOP_LIMIT) {
         fprintf(stderr, "Pressure vessel depressurizing\n");
         return false;
     }
@@ -50,31 +52,33 @@ bool checkIdlePressures(void) {
 }
 
 bool checkPrerunPressures(void) {
-    if (data->pressure->primTank < PS1_BOTTOM_LIMIT_PRE || data->pressure->primTank > PS1_TOP_LIMIT_PRE) {
+    pressure_t pressure;
+    getPressureSnapshot(&pressure);
+    if (pressure.primTank < PS1_BOTTOM_LIMIT_PRE || pressure.primTank > PS1_TOP_LIMIT_PRE) {
 		fprintf(stderr, "primTank pressure failing\n");
 		return false;
 	}
-	if (data->pressure->primLine < PS2_BOTTOM_LIMIT_PRE || data->pressure->primLine > PS2_TOP_LIMIT_PRE) {
+	if (pressure.primLine < PS2_BOTTOM_LIMIT_PRE || pressure.primLine > PS2_TOP_LIMIT_PRE) {
 		fprintf(stderr, "primLine pressure failing\n");
 		return false;
 	}
-	if (data->pressure->primAct < PS3_BOTTOM_LIMIT_PRE || data->pressure->primAct > PS3_TOP_LIMIT_PRE) {
+	if (pressure.primAct < PS3_BOTTOM_LIMIT_PRE || pressure.primAct > PS3_TOP_LIMIT_PRE) {
 		fprintf(stderr, "primAct pressure failing\n");
 		return false;
 	}
-	if (data->pressure->secTank < SEC_PS1_BOTTOM_LIMIT_PRE || data->pressure->secTank > SEC_PS1_TOP_LIMIT_PRE) {
+	if (pressure.secTank < SEC_PS1_BOTTOM_LIMIT_PRE || pressure.secTank > SEC_PS1_TOP_LIMIT_PRE) {
 		fprintf(stderr, "Secondary primTank pressure failing\n");
 		return false;
 	}
-	if (data->pressure->secLine < SEC_PS2_BOTTOM_LIMIT_PRE || data->pressure->secLine > SEC_PS2_TOP_LIMIT_PRE) {
+	if (pressure.secLine < SEC_PS2_BOTTOM_LIMIT_PRE || pressure.secLine > SEC_PS2_TOP_LIMIT_PRE) {
 		fprintf(stderr, "Secondary primLine pressure failing\n");
 		return false;
 	}
-	if (data->pressure->secAct < SEC_PS3_BOTTOM_LIMIT || data->pressure->secAct > SEC_PS3_TOP_LIMIT) {
+	if (pressure.secAct < SEC_PS3_BOTTOM_LIMIT || pressure.secAct > SEC_PS3_TOP_LIMIT) {
 		fprintf(stderr, "Secondary primAct pressure failing\n");
 		return false;
 	}
-	if (data->pressure->pv < PV_BOTTOM_LIMIT || data->pressure->pv > PV_TOP_LIMIT) {
+	if (pressure.pv < PV_BOTTOM_LIMIT || pressure.pv > PV_TOP_LIMIT) {
         fprintf(stderr, "Pressure vessel depressurizing\n");
         return false;
     }
@@ -83,31 +87,33 @@ bool checkPrerunPressures(void) {
 }
 
 bool checkBrakingPressures(void) {
-    if (data->pressure->primTank < PS1_BOTTOM_LIMIT_PRE || data->pressure->primTank > PS1_TOP_LIMIT_PRE) {
+    pressure_t pressure;
+    getPressureSnapshot(&pressure);
+    if (pressure.primTank < PS1_BOTTOM_LIMIT_PRE || pressure.primTank > PS1_TOP_LIMIT_PRE) {
 		fprintf(stderr, "primTank pressure failing\n");
 		return false;
 	}
-	if (data->pressure->primLine < PS2_BOTTOM_LIMIT_PRE || data->pressure->primLine > PS2_TOP_LIMIT_PRE) {
+	if (pressure.primLine < PS2_BOTTOM_LIMIT_PRE || pressure.primLine > PS2_TOP_LIMIT_PRE) {
 		fprintf(stderr, "primLine pressure failing\n");
 		return false;
 	}
-	if (data->pressure->primAct < PS3_BOTTOM_LIMIT_BRAKING || data->pressure->primAct > PS3_TOP_LIMIT_BRAKING) {
+	if (pressure.primAct < PS3_BOTTOM_LIMIT_BRAKING || pressure.primAct > PS3_TOP_LIMIT_BRAKING) {
 		fprintf(stderr, "primAct pressure failing\n");
 		return false;
 	}
-	if (data->pressure->secTank < SEC_PS1_BOTTOM_LIMIT_PRE || data->pressure->secTank > SEC_PS1_TOP_LIMIT_PRE) {
+	if (pressure.secTank < SEC_PS1_BOTTOM_LIMIT_PRE || pressure.secTank > SEC_PS1_TOP_LIMIT_PRE) {
 		fprintf(stderr, "Secondary primTank pressure failing\n");
 		return false;
 	}
-	if (data->pressure->secLine < SEC_PS2_BOTTOM_LIMIT_PRE || data->pressure->secLine > SEC_PS2_TOP_LIMIT_PRE) {
+	if (pressure.secLine < SEC_PS2_BOTTOM_LIMIT_PRE || pressure.secLine > SEC_PS2_TOP_LIMIT_PRE) {
 		fprintf(stderr, "Secondary primLine pressure failing\n");
 		return false;
 	}
-	if (data->pressure->secAct < SEC_PS3_BOTTOM_LIMIT || data->pressure->secAct > SEC_PS3_TOP_LIMIT) {
+	if (pressure.secAct < SEC_PS3_BOTTOM_LIMIT || pressure.secAct > SEC_PS3_TOP_LIMIT) {
 		fprintf(stderr, "Secondary primAct pressure failing\n");
 		return false;
 	}
-	if (data->pressure->pv < PV_BOTTOM_LIMIT || data->pressure->pv > PV_TOP_LIMIT) {
+	if (pressure.pv < PV_BOTTOM_LIMIT || pressure.pv > PV_TOP_LIMIT) {
         fprintf(stderr, "Pressure vessel depressurizing\n");
         return false;
     }
@@ -117,31 +123,33 @@ bool checkBrakingPressures(void) {
 }
 
 bool checkCrawlPostrunPressures(void) {
-    if (data->pressure->primTank < PS1_BOTTOM_LIMIT_CRAWLPOST || data->pressure->primTank > PS1_TOP_LIMIT_CRAWLPOST) {
+    pressure_t pressure;
+    getPressureSnapshot(&pressure);
+    if (pressure.primTank < PS1_BOTTOM_LIMIT_CRAWLPOST || pressure.primTank > PS1_TOP_LIMIT_CRAWLPOST) {
 		fprintf(stderr, "primTank pressure failing\n");
 		return false;
 	}
-	if (data->pressure->primLine < PS2_BOTTOM_LIMIT_CRAWLPOST || data->pressure->primLine > PS2_TOP_LIMIT_CRAWLPOST) {
+	if (pressure.primLine < PS2_BOTTOM_LIMIT_CRAWLPOST || pressure.primLine > PS2_TOP_LIMIT_CRAWLPOST) {
 		fprintf(stderr, "primLine pressure failing\n");
 		return false;
 	}
-	if (data->pressure->primAct < PS3_BOTTOM_LIMIT_CRAWLPOST || data->pressure->primAct > PS3_TOP_LIMIT_CRAWLPOST) {
+	if (pressure.primAct < PS3_BOTTOM_LIMIT_CRAWLPOST || pressure.primAct > PS3_TOP_LIMIT_CRAWLPOST) {
 		fprintf(stderr, "primAct pressure failing\n");
 		return false;
 	}
-	if (data->pressure->secTank < SEC_PS1_BOTTOM_LIMIT_CRAWLPOST || data->pressure->secTank > SEC_PS1_TOP_LIMIT_CRAWLPOST) {
+	if (pressure.secTank < SEC_PS1_BOTTOM_LIMIT_CRAWLPOST || pressure.secTank > SEC_PS1_TOP_LIMIT_CRAWLPOST) {
 		fprintf(stderr, "Secondary primTank pressure failing\n");
 		return false;
 	}
-	if (data->pressure->secLine < SEC_PS2_BOTTOM_LIMIT_CRAWLPOST || data->pressure->secLine > SEC_PS2_TOP_LIMIT_CRAWLPOST) {
+	if (pressure.secLine < SEC_PS2_BOTTOM_LIMIT_CRAWLPOST || pressure.secLine > SEC_PS2_TOP_LIMIT_CRAWLPOST) {
 		fprintf(stderr, "Secondary primLine pressure failing\n");
 		return false;
 	}
-	if (data->pressure->secAct < SEC_PS3_BOTTOM_LIMIT || data->pressure->secAct > SEC_PS3_TOP_LIMIT) {
+	if (pressure.secAct < SEC_PS3_BOTTOM_LIMIT || pressure.secAct > SEC_PS3_TOP_LIMIT) {
 		fprintf(stderr, "Secondary primAct pressure failing\n");
 		return false;
 	}
-	if (data->pressure->pv < PV_BOTTOM_LIMIT || data->pressure->pv > PV_TOP_LIMIT) {
+	if (pressure.pv < PV_BOTTOM_LIMIT || pressure.pv > PV_TOP_LIMIT) {
         fprintf(stderr, "Pressure vessel depressurizing\n");
         return false;
     }
@@ -19,62 +19,64 @@
 extern data_t *data;
 
 bool checkPrerunRMS(void){
-	if(data->rms->igbtTemp < MIN_IGBT_TEMP || data->rms->igbtTemp > MAX_IGBT_TEMP_PRERUN){
-		printf("IGBT Prerun Temp Failure: %i\n", data->rms->igbtTemp);
+	rms_t rms;
+	getRmsSnapshot(&rms);
+	if(rms.igbtTemp < MIN_IGBT_TEMP || rms.igbtTemp > MAX_IGBT_TEMP_PRERUN){
+		printf("IGBT Prerun Temp Failure: %i\n", rms.igbtTemp);
 		return false;
 	}
     
-    if(data->rms->dcBusVoltage < DC_BUS_VOLTAGE_MIN || data->rms->dcBusVoltage > DC_BUS_VOLTAGE_MAX){
+    if(rms.dcBusVoltage < DC_BUS_VOLTAGE_MIN || rms.dcBusVoltage > DC_BUS_VOLTAGE_MAX){
 
-		printf("DC Bus Voltage Failure: %i\n", data->rms->dcBusVoltage);
+		printf("DC Bus Voltage Failure: %i\n", rms.dcBusVoltage);
 		return false;
 	}
 
 	// IDLE
 	if(data->state == 1){
-		if(data->rms->dcBusCurrent < DC_BUS_CURRENT_MIN || data->rms->dcBusCurrent > DC_BUS_CURRENT_MAX_IDLE){
-			printf("DC Bus Current Idle Failure: %i\n", data->rms->dcBusCurrent);
+		if(rms.dcBusCurrent < DC_BUS_CURRENT_MIN || rms.dcBusCurrent > DC_BUS_CURRENT_MAX_IDLE){
+			printf("DC Bus Current Idle Failure: %i\n", rms.dcBusCurrent);
 			return false;
 		}
-	if(data->rms->gateDriverBoardTemp < MIN_GATE_TEMP || data->rms->gateDriverBoardTemp > MAX_GATE_TEMP_PRERUN){
-			printf("Gate Driver Temp Failure: %i\n", data->rms->gateDriverBoardTemp);
+	if(rms.gateDriverBoardTemp < MIN_GATE_TEMP || rms.gateDriverBoardTemp > MAX_GATE_TEMP_PRERUN){
+			printf("Gate Driver Temp Failure: %i\n", rms.gateDriverBoardTemp);
 			return false;
 		}
-		if(data->rms->controlBoardTemp < MIN_CONTROL_TEMP || data->rms->controlBoardTemp > MAX_CONTROL_TEMP_IDLE){
-			printf("Control Temp Failure: %i\n", data->rms->controlBoardTemp);
+		if(rms.controlBoardTemp < MIN_CONTROL_TEMP || rms.controlBoardTemp > MAX_CONTROL_TEMP_IDLE){
+			printf("Control Temp Failure: %i\n", rms.controlBoardTemp);
 			return false;
 		}
 	}
 	// READY PUMPDOWN SPECIFIC
 	else if(data->state == 2){
-	if(data->rms->gateDriverBoardTemp < MIN_GATE_TEMP || data->rms->gateDriverBoardTemp > MAX_GATE_TEMP_PRERUN){
-			printf("Gate Driver Temp Failure: %i\n", data->rms->gateDriverBoardTemp);
+	if(rms.gateDriverBoardTemp < MIN_GATE_TEMP || rms.gateDriverBoardTemp > MAX_GATE_TEMP_PRERUN){
+			printf("Gate Driver Temp Failure: %i\n", rms.gateDriverBoardTemp);
 			return false;
 		}
-		if(data->rms->controlBoardTemp < MIN_CONTROL_TEMP || data->rms->controlBoardTemp > MAX_CONTROL_TEMP_PUMP){ //changes on spreadsheet
-			printf("Control Temp Failure: %i\n", data->rms->controlBoardTemp);
+		if(rms.controlBoardTemp < MIN_CONTROL_TEMP || rms.controlBoardTemp > MAX_CONTROL_TEMP_PUMP){ //changes on spreadsheet
+			printf("Control Temp Failure: %i\n", rms.controlBoardTemp);
 			return false;
 		}
 	}
 	// PUMPDOWN SPECIFIC
 	else if(data->state == 3){
-	if(data->rms->gateDriverBoardTemp < MIN_GATE_TEMP || data->rms->gateDriverBoardTemp > MAX_GATE_TEMP_PRERUN){
-			printf("Gate Driver Temp Failure: %i\n", data->rms->gateDriverBoardTemp);
+	if(rms.gateDriverBoardTemp < MIN_GATE_TEMP || rms.gateDriverBoardTemp > MAX_GATE_TEMP_PRERUN){
+			printf("Gate Driver Temp Failure: %i\n", rms.gateDriverBoardTemp);
 			return false;
 		}
-		if(data->rms->controlBoardTemp < MIN_CONTROL_TEMP || data->rms->controlBoardTemp > MAX_CONTROL_TEMP_PUMP){
-			printf("Control Temp Failure: %i\n", data->rms->controlBoardTemp);
+		if(rms.controlBoardTemp < MIN_CONTROL_TEMP || rms.controlBoardTemp > MAX_CONTROL_TEMP_PUMP){
+			printf("Control Temp Failure: %i\n", rms.controlBoardTemp);
 			return false;
 		}
 	}
 	// PRE-PROPULSE SPECIFIC
 	else if(data->state == 4){
-	if(data->rms->gateDriverBoardTemp < MIN_GATE_TEMP || data->rms->gateDriverBoardTemp > MAX_GATE_TEMP_RUN){ //changes on spreadsheet
-			printf("Gate Driver Temp Failure: %i\n", data->rms->gateDriverBoardTemp);
+	if(rms.gateDriverBoardTemp < MIN_GATE_TEMP || rms.gateDriverBoardTemp > MAX_GATE_TEMP_RUN){ //changes on spreadsheet
+			printf("Gate Driver Temp Failure: %i\n", rms.gateDriverBoardTemp);
 			return false;
 		}
-		if(data->rms->controlBoardTemp < MIN_CONTROL_TEMP || data->rms->controlBoardTemp > MAX_CONTROL_TEMP_PUMP){
-			printf("Control Temp Failure: %i\n", data->rms->controlBoardTemp);
+		if(rms.controlBoardTemp < MIN_CONTROL_TEMP || rms.controlBoardTemp > MAX_CONTROL_TEMP_PUMP){
+			printf("Control Temp Failure: %i\n", rms.controlBoardTemp);
 			return false;
 		}
 	}
@@ -83,20 +85,26 @@ bool checkPrerunRMS(void){
 }
 
 bool checkRunRMS(void){
-	if(data->rms->igbtTemp < MIN_IGBT_TEMP || data->rms->igbtTemp > MAX_IGBT_TEMP_RUN){
-		printf("IGBT Prerun Temp Failure: %i\n", data->rms->igbtTemp);
+	rms_t rms;
+	getRmsSnapshot(&rms);
+	if(isStale(&rms.rx, RMS_MAX_AGE_US)){
+		printf("RMS data stale: %llu us old\n", (unsigned long long) rxAge(&rms.rx));
 		return false;
 	}
-	if(data->rms->controlBoardTemp < MIN_CONTROL_TEMP || data->rms->controlBoardTemp > MAX_CONTROL_TEMP_RUN){
-		printf("Control Temp Failure: %i\n", data->rms->controlBoardTemp);
+	if(rms.igbtTemp < MIN_IGBT_TEMP || rms.igbtTemp > MAX_IGBT_TEMP_RUN){
+		printf("IGBT Prerun Temp Failure: %i\n", rms.igbtTemp);
 		return false;
 	}
-if(data->rms->dcBusVoltage < DC_BUS_VOLTAGE_MIN || data->rms->dcBusVoltage > DC_BUS_VOLTAGE_MAX){
-		printf("DC Bus Voltage Failure: %i\n", data->rms->dcBusVoltage);
+	if(rms.controlBoardTemp < MIN_CONTROL_TEMP || rms.controlBoardTemp > MAX_CONTROL_TEMP_RUN){
+		printf("Control Temp Failure: %i\n", rms.controlBoardTemp);
 		return false;
 	}
-if(data->rms->gateDriverBoardTemp < MIN_GATE_TEMP || data->rms->gateDriverBoardTemp > MAX_GATE_TEMP_RUN){
-		printf("Gate Driver Temp Failure: %i\n", data->rms->gateDriverBoardTemp);
+if(rms.dcBusVoltage < DC_BUS_VOLTAGE_MIN || rms.dcBusVoltage > DC_BUS_VOLTAGE_MAX){
+		printf("DC Bus Voltage Failure: %i\n", rms.dcBusVoltage);
+		return false;
+	}
+if(rms.gateDriverBoardTemp < MIN_GATE_TEMP || rms.gateDriverBoardTemp > MAX_GATE_TEMP_RUN){
+		printf("Gate Driver Temp Failure: %i\n", rms.gateDriverBoardTemp);
 		return false;
 	}
 	
@@ -104,16 +112,18 @@ if(data->rms->gateDriverBoardTemp < MIN_GATE_TEMP || data->rms->gateDriverBoardT
 }
 
 bool checkBrakingRMS(void){
-	if(data->rms->igbtTemp < MIN_IGBT_TEMP || data->rms->igbtTemp > MAX_IGBT_TEMP_RUN){
-		printf("IGBT Prerun Temp Failure: %i\n", data->rms->igbtTemp);
+	rms_t rms;
+	getRmsSnapshot(&rms);
+	if(rms.igbtTemp < MIN_IGBT_TEMP || rms.igbtTemp > MAX_IGBT_TEMP_RUN){
+		printf("IGBT Prerun Temp Failure: %i\n", rms.igbtTemp);
 		return false;
 	}
-	if(data->rms->controlBoardTemp < MIN_CONTROL_TEMP || data->rms->controlBoardTemp > MAX_CONTROL_TEMP_RUN){
-		printf("Control Temp Failure: %i\n", data->rms->controlBoardTemp);
+	if(rms.controlBoardTemp < MIN_CONTROL_TEMP || rms.controlBoardTemp > MAX_CONTROL_TEMP_RUN){
+		printf("Control Temp Failure: %i\n", rms.controlBoardTemp);
 		return false;
 	}
-if(data->rms->gateDriverBoardTemp < MIN_GATE_TEMP || data->rms->gateDriverBoardTemp > MAX_GATE_TEMP_RUN){
-		printf("Gate Driver Temp Failure: %i\n", data->rms->gateDriverBoardTemp);
+if(rms.gateDriverBoardTemp < MIN_GATE_TEMP || rms.gateDriverBoardTemp > MAX_GATE_TEMP_RUN){
+		printf("Gate Driver Temp Failure: %i\n", rms.gateDriverBoardTemp);
 		return false;
 	}
 	
@@ -121,16 +131,18 @@ if(data->rms->gateDriverBoardTemp < MIN_GATE_TEMP || data->rms->gateDriverBoardT
 }
 
 bool checkStoppedRMS(void){
-	if(data->rms->igbtTemp < MIN_IGBT_TEMP || data->rms->igbtTemp > MAX_IGBT_TEMP_POSTRUN){
-		printf("IGBT Prerun Temp Failure: %i\n", data->rms->igbtTemp);
+	rms_t rms;
+	getRmsSnapshot(&rms);
+	if(rms.igbtTemp < MIN_IGBT_TEMP || rms.igbtTemp > MAX_IGBT_TEMP_POSTRUN){
+		printf("IGBT Prerun Temp Failure: %i\n", rms.igbtTemp);
 		return false;
 	}
-	if(data->rms->controlBoardTemp < MIN_CONTROL_TEMP || data->rms->controlBoardTemp > MAX_CONTROL_TEMP_RUN){
-		printf("Control Temp Failure: %i\n", data->rms->controlBoardTemp);
+	if(rms.controlBoardTemp < MIN_CONTROL_TEMP || rms.controlBoardTemp > MAX_CONTROL_TEMP_RUN){
+		printf("Control Temp Failure: %i\n", rms.controlBoardTemp);
 		return false;
 	}
-if(data->rms->gateDriverBoardTemp < MIN_GATE_TEMP || data->rms->gateDriverBoardTemp > MAX_GATE_TEMP_RUN){
-		printf("Gate Driver Temp Failure: %i\n", data->rms->gateDriverBoardTemp);
+if(rms.gateDriverBoardTemp < MIN_GATE_TEMP || rms.gateDriverBoardTemp > MAX_GATE_TEMP_RUN){
+		printf("Gate Driver Temp Failure: %i\n", rms.gateDriverBoardTemp);
 		return false;
 	}
 	
@@ -138,20 +150,22 @@ if(data->rms->gateDriverBoardTemp < MIN_GATE_TEMP || data->rms->gateDriverBoardT
 }
 
 bool checkCrawlRMS(void){
-	if(data->rms->igbtTemp < MIN_IGBT_TEMP || data->rms->igbtTemp > MAX_IGBT_TEMP_POSTRUN){
-		printf("IGBT Prerun Temp Failure: %i\n", data->rms->igbtTemp);
+	rms_t rms;
+	getRmsSnapshot(&rms);
+	if(rms.igbtTemp < MIN_IGBT_TEMP || rms.igbtTemp > MAX_IGBT_TEMP_POSTRUN){
+		printf("IGBT Prerun Temp Failure: %i\n", rms.igbtTemp);
 		return false;
 	}
-	if(data->rms->controlBoardTemp < MIN_CONTROL_TEMP || data->rms->controlBoardTemp > MAX_CONTROL_TEMP_RUN){
-		printf("Control Temp Failure: %i\n", data->rms->controlBoardTemp);
+	if(rms.controlBoardTemp < MIN_CONTROL_TEMP || rms.controlBoardTemp > MAX_CONTROL_TEMP_RUN){
+		printf("Control Temp Failure: %i\n", rms.controlBoardTemp);
 		return false;
 	}
-if(data->rms->dcBusCurrent < DC_BUS_CURRENT_MIN || data->rms->dcBusCurrent > DC_BUS_CURRENT_MAX_CRAWL){
-		printf("DC Bus Current Pumpdown Failure: %i\n", data->rms->dcBusCurrent);
+if(rms.dcBusCurrent < DC_BUS_CURRENT_MIN || rms.dcBusCurrent > DC_BUS_CURRENT_MAX_CRAWL){
+		printf("DC Bus Current Pumpdown Failure: %i\n", rms.dcBusCurrent);
 		return false;
 	}
-if(data->rms->gateDriverBoardTemp < MIN_GATE_TEMP || data->rms->gateDriverBoardTemp > MAX_GATE_TEMP_RUN){
-		printf("Gate Driver Temp Failure: %i\n", data->rms->gateDriverBoardTemp);
+if(rms.gateDriverBoardTemp < MIN_GATE_TEMP || rms.gateDriverBoardTemp > MAX_GATE_TEMP_RUN){
+		printf("Gate Driver Temp Failure: %i\n", rms.gateDriverBoardTemp);
 		return false;
 	}
 	
@@ -159,16 +173,18 @@ if(data->rms->gateDriverBoardTemp < MIN_GATE_TEMP || data->rms->gateDriverBoardT
 }
 
 bool checkPostRMS(void){
-	if(data->rms->igbtTemp < MIN_IGBT_TEMP || data->rms->igbtTemp > MAX_IGBT_TEMP_POSTRUN){
-		printf("IGBT Prerun Temp Failure: %i\n", data->rms->igbtTemp);
+	rms_t rms;
+	getRmsSnapshot(&rms);
+	if(rms.igbtTemp < MIN_IGBT_TEMP || rms.igbtTemp > MAX_IGBT_TEMP_POSTRUN){
+		printf("IGBT Prerun Temp Failure: %i\n", rms.igbtTemp);
 		return false;
 	}
-	if(data->rms->controlBoardTemp < MIN_CONTROL_TEMP || data->rms->controlBoardTemp > MAX_CONTROL_TEMP_RUN){
-		printf("Control Temp Failure: %i\n", data->rms->controlBoardTemp);
+	if(rms.controlBoardTemp < MIN_CONTROL_TEMP || rms.controlBoardTemp > MAX_CONTROL_TEMP_RUN){
+		printf("Control Temp Failure: %i\n", rms.controlBoardTemp);
 		return false;
 	}
-if(data->rms->gateDriverBoardTemp < MIN_GATE_TEMP || data->rms->gateDriverBoardTemp > MAX_GATE_TEMP_POSTRUN){
-		printf("Gate Driver Temp Failure: %i\n", data->rms->gateDriverBoardTemp);
+if(rms.gateDriverBoardTemp < MIN_GATE_TEMP || rms.gateDriverBoardTemp > MAX_GATE_TEMP_POSTRUN){
+		printf("Gate Driver Temp Failure: %i\n", rms.gateDriverBoardTemp);
 		return false;
 	}
 	
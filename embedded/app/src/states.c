@@ -140,6 +140,12 @@ stateTransition_t * propulsionAction() {
 
     if (checkNetwork() != 0) return stateMachine.currState->fault;
 
+    /* No retros, nothing to tell us when to brake */
+    if (data->flags->retroFault) {
+        fprintf(stderr, "Retros down\n");
+        return stateMachine.currState->fault;
+    }
+
     // CHECK FAULT CRITERIA
     // CHECK PRESSURE -- PreRun function still valid here
     if (!checkPrerunPressures()) { 
@@ -150,12 +156,12 @@ stateTransition_t * propulsionAction() {
     if(!checkRunBattery()){
         printf("Failed battery\n");
         bErrs += 1;
-    } bErrs = 0;
+    } else bErrs = 0;
     
     if(!checkRunRMS()){
         printf("run rms failed\n");
         rErrs += 1;
-    } rErrs = 0;
+    } else rErrs = 0;
 
     if (getuSTimestamp() - data->timers->startTime > 30000000/*MAX_RUN_TIME*/){
         fprintf(stderr, "Prop timeout\n");
@@ -2,6 +2,8 @@
 #define __DATA_H__
 
 #include <stdint.h>
+#include <string.h>
+#include <sched.h>
 #include <time.h>
 #include <retro.h>
 #include <stdbool.h>
@@ -9,6 +11,7 @@
 #define FILTER_NONE     0
 #define FILTER_ROLLING  1
 #define FILTER_EXP      2
+#define FILTER_KALMAN   3
 
 /* Functions for initializing the entire struct, and individual parts of it */
 int initData(void);
@@ -50,6 +53,7 @@ typedef struct flags_t {
     bool brakePrimRetr;
     bool brakeSecRetr;
     bool clrMotionData;
+    bool retroFault;        /* LV can't read the retros any more */
 } flags_t;
 
 
@@ -106,10 +110,93 @@ static inline uint64_t getSTimestamp() {
 
 
 
+/***
+ * rxStamp_t - When a group of values (e.g. everything from the BMS) was last
+ *  updated from the bus. time is the monotonic receive time in uS, taken by
+ *  the kernel when the frame came in, and seq counts every update so a reader
+ *  can tell it is looking at new data. Written only by the CAN thread.
+ */
+typedef struct rxStamp_t {
+    uint64_t time;
+    uint32_t seq;
+} rxStamp_t;
+
+static inline void stampRx(rxStamp_t *stamp, uint64_t rxTime) {
+    __atomic_store_n(&stamp->time, rxTime, __ATOMIC_RELEASE);
+    __atomic_store_n(&stamp->seq, stamp->seq + 1, __ATOMIC_RELEASE);
+}
+
+/* Microseconds since the group was last updated */
+static inline uint64_t rxAge(const rxStamp_t *stamp) {
+    uint64_t last = __atomic_load_n(&stamp->time, __ATOMIC_ACQUIRE);
+    uint64_t now = getuSTimestamp();
+    return now > last ? now - last : 0;
+}
+
+/* True if nothing has been received for a group in maxAgeUs, or ever */
+static inline bool isStale(const rxStamp_t *stamp, uint64_t maxAgeUs) {
+    return __atomic_load_n(&stamp->time, __ATOMIC_ACQUIRE) == 0 ||
+        rxAge(stamp) > maxAgeUs;
+}
+
+/***
+ * seqlock_t - Lets a struct be read as a whole while other threads update it,
+ *  without anyone blocking on a mutex. Writers bracket every update with
+ *  seqWriteBegin/seqWriteEnd, which leave the counter odd while it is in
+ *  progress. Readers copy the struct and try again if the counter was odd or
+ *  moved while they copied, see the get*Snapshot functions at the bottom.
+ *
+ *  Writers only wait on each other, and only while another update is going.
+ *  Nothing may sleep or block inside a write.
+ */
+typedef struct seqlock_t {
+    uint32_t seq;
+} seqlock_t;
+
+static inline void seqWriteBegin(seqlock_t *lock) {
+    uint32_t seq = __atomic_load_n(&lock->seq, __ATOMIC_RELAXED);
+    while ((seq & 1) || !__atomic_compare_exchange_n(&lock->seq, &seq, seq + 1,
+                true, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        /* Single core, let whoever is mid write finish */
+        if (seq & 1) sched_yield();
+        seq = __atomic_load_n(&lock->seq, __ATOMIC_RELAXED);
+    }
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void seqWriteEnd(seqlock_t *lock) {
+    __atomic_store_n(&lock->seq, lock->seq + 1, __ATOMIC_RELEASE);
+}
+
+static inline uint32_t seqReadBegin(const seqlock_t *lock) {
+    uint32_t seq;
+    while ((seq = __atomic_load_n(&lock->seq, __ATOMIC_ACQUIRE)) & 1) {
+        sched_yield();
+    }
+    return seq;
+}
+
+/* True if a write happened since seqReadBegin returned start */
+static inline bool seqReadRetry(const seqlock_t *lock, uint32_t start) {
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&lock->seq, __ATOMIC_RELAXED) != start;
+}
+
+/* Copies size bytes of src, which lock protects, into dst in one piece */
+static inline void seqRead(const seqlock_t *lock, void *dst, const void *src, size_t size) {
+    uint32_t seq;
+    do {
+        seq = seqReadBegin(lock);
+        memcpy(dst, src, size);
+    } while (seqReadRetry(lock, seq));
+}
+
+
 /***
  * pressure_t - Pressure data from the braking system
  */
 typedef struct pressure_t {
+    seqlock_t lock;
     double primTank;
     double primLine;
     double primAct;
@@ -130,6 +217,7 @@ typedef struct pressure_t {
  * All values should be assumed metric (m, m/s, m/s/s)
  */
 typedef struct motion_t {
+    seqlock_t lock;
     float pos;
     float vel;
     float accel;
@@ -142,6 +230,8 @@ typedef struct motion_t {
  *
  */
 typedef struct bms_t {
+    rxStamp_t rx;
+    seqlock_t lock;
     float packCurrent;
     float packVoltage;
     int imdStatus;
@@ -171,6 +261,8 @@ typedef struct bms_t {
  * Read in and filled in via CAN from the motor
  */
 typedef struct rms_t {
+    rxStamp_t rx;
+    seqlock_t lock;
     uint16_t igbtTemp;
     uint16_t gateDriverBoardTemp;
     uint16_t controlBoardTemp;
@@ -199,4 +291,25 @@ typedef struct rms_t {
 
 
 extern data_t *data;
+
+/***
+ * Consistent copies of the structs above, for anything that looks at more
+ *  than one field of them at a time. When nothing is writing each is just a
+ *  memcpy of the struct.
+ */
+static inline void getMotionSnapshot(motion_t *out) {
+    seqRead(&data->motion->lock, out, data->motion, sizeof(*out));
+}
+
+static inline void getPressureSnapshot(pressure_t *out) {
+    seqRead(&data->pressure->lock, out, data->pressure, sizeof(*out));
+}
+
+static inline void getBmsSnapshot(bms_t *out) {
+    seqRead(&data->bms->lock, out, data->bms, sizeof(*out));
+}
+
+static inline void getRmsSnapshot(rms_t *out) {
+    seqRead(&data->rms->lock, out, data->rms, sizeof(*out));
+}
 #endif
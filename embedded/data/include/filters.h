@@ -0,0 +1,77 @@
+#ifndef __FILTERS_H__
+#define __FILTERS_H__
+
+#include <stdint.h>
+
+/***
+ * Rolling mean and variance in O(1) per sample
+ *
+ * rollingAvgFloat() adds up the whole window every time it is called. These
+ * keep the last size samples and a running sum instead: each push adds the
+ * new sample and takes away the one falling out of the window, so the cost
+ * doesn't grow with the window.
+ *
+ *      rollMean_t f;
+ *      rollMeanInit(&f, 200);
+ *      while (1) {
+ *          mean = rollMeanPush(&f, readSensor());
+ *      }
+ *
+ * Until size samples have been pushed the mean is of however many there are.
+ * A running double sum slowly picks up rounding error as values come and go,
+ * so it is Kahan compensated and the window is re-summed from scratch every
+ * ROLL_RESUM_EVERY pushes, which keeps the error bounded however long it runs.
+ *
+ * The variance is updated with the sliding window form of Welford's method and
+ * is the population variance of the samples in the window.
+ *
+ * rollMeanFix_t is the same over int32_t samples in whatever fixed point
+ * scale the caller likes. Integer sums are exact so it never needs re-summing.
+ * Keep samples within +/-2^20 and the window to 1024 or less so the sum of
+ * squares can't overflow.
+ *
+ * None of these lock, so push, get and reset from one thread only.
+ */
+
+#define ROLL_RESUM_EVERY    4096
+#define ROLL_FIX_MAX_SIZE   1024
+
+typedef struct rollMean_t {
+    double *vals;
+    uint32_t size;
+    uint32_t count;         /* Samples in the window, at most size */
+    uint32_t idx;           /* Where the next sample goes */
+    uint32_t sinceResum;
+    double sum;
+    double comp;            /* Kahan compensation, what sum is missing */
+    double m2;              /* Sum of squared differences from the mean */
+} rollMean_t;
+
+typedef struct rollMeanFix_t {
+    int32_t *vals;
+    uint32_t size;
+    uint32_t count;
+    uint32_t idx;
+    int64_t sum;
+    int64_t sumSq;
+} rollMeanFix_t;
+
+int rollMeanInit(rollMean_t *f, uint32_t size);
+void rollMeanFree(rollMean_t *f);
+void rollMeanReset(rollMean_t *f);
+
+/* Adds a sample and returns the new mean */
+double rollMeanPush(rollMean_t *f, double val);
+double rollMeanGet(const rollMean_t *f);
+double rollMeanVar(const rollMean_t *f);
+
+int rollMeanFixInit(rollMeanFix_t *f, uint32_t size);
+void rollMeanFixFree(rollMeanFix_t *f);
+void rollMeanFixReset(rollMeanFix_t *f);
+
+/* Means are rounded to the nearest step, variance is truncated */
+int32_t rollMeanFixPush(rollMeanFix_t *f, int32_t val);
+int32_t rollMeanFixGet(const rollMeanFix_t *f);
+int64_t rollMeanFixVar(const rollMeanFix_t *f);
+
+#endif
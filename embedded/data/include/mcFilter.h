@@ -0,0 +1,123 @@
+#ifndef __MC_FILTER_H__
+#define __MC_FILTER_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/***
+ * Multi-channel filters
+ *
+ * Filters MCF_CHANNELS channels that are sampled together, like the pressure
+ * transducers, in one go. Every filter keeps its state structure-of-arrays:
+ * all channels' values for one sample sit next to each other, so one update
+ * is a handful of 4-wide vector operations (NEON on the BeagleBone, SSE on a
+ * laptop) rather than eight calls to a scalar filter.
+ *
+ * Channels are float since the Cortex-A8's NEON unit has no double precision,
+ * which is plenty for 8-bit ADCs. Fill an mcfVec_t by channel and push it:
+ *
+ *      mcfMa_t avg;
+ *      mcfVec_t in, out;
+ *      mcfMaInit(&avg);
+ *      in.ch[0] = readFirst();
+ *      ...
+ *      mcfMaPush(&avg, &in);
+ *      mcfMaGet(&avg, &out);
+ *
+ * Window sizes are fixed at compile time so the loops have constant bounds.
+ * They size the structs, and mcFilter.c is built on its own, so every file
+ * has to see the same ones. Change them only with MCF_SIZES in the Makefile,
+ * which passes them to every file, e.g.
+ *
+ *      make MCF_SIZES="MCF_MA_WINDOW=100 MCF_MEDIAN_N=7"
+ *
+ * Defining them any other way is an error.
+ *
+ * mcfMa_t      Moving average over MCF_MA_WINDOW samples, a running sum that
+ *              is re-summed once per window to drop rounding error
+ * mcfEma_t     Exponential moving average, y += alpha * (x - y)
+ * mcfMedian_t  Median of the last MCF_MEDIAN_N samples, for knocking out
+ *              single sample spikes
+ * mcfBiquad_t  Second order IIR, transposed direct form II
+ *
+ * Nothing here locks, push and get from one thread.
+ */
+
+#if (defined(MCF_CHANNELS) || defined(MCF_MA_WINDOW) || defined(MCF_MEDIAN_N)) && \
+        !defined(MCF_GLOBAL_SIZES)
+#error "Set MCF_ sizes with MCF_SIZES in the Makefile, mcFilter.c has to see the same ones"
+#endif
+
+#ifndef MCF_CHANNELS
+#define MCF_CHANNELS    8
+#endif
+#ifndef MCF_MA_WINDOW
+#define MCF_MA_WINDOW   200
+#endif
+#ifndef MCF_MEDIAN_N
+#define MCF_MEDIAN_N    5
+#endif
+
+#define MCF_LANE_WIDTH  4
+#define MCF_LANES       (MCF_CHANNELS / MCF_LANE_WIDTH)
+
+_Static_assert(MCF_CHANNELS % MCF_LANE_WIDTH == 0, "MCF_CHANNELS must be a multiple of 4");
+_Static_assert(MCF_MEDIAN_N % 2 == 1, "MCF_MEDIAN_N must be odd");
+
+typedef float mcfLane_t __attribute__((vector_size(16)));
+typedef int32_t mcfMask_t __attribute__((vector_size(16)));
+
+/* One value per channel */
+typedef union mcfVec_t {
+    mcfLane_t lane[MCF_LANES];
+    float ch[MCF_CHANNELS];
+} mcfVec_t;
+
+typedef struct mcfMa_t {
+    mcfVec_t hist[MCF_MA_WINDOW];
+    mcfVec_t sum;
+    uint32_t idx;
+    uint32_t count;
+    uint32_t sinceResum;
+} mcfMa_t;
+
+typedef struct mcfEma_t {
+    mcfLane_t alpha;
+    mcfVec_t y;
+    bool primed;
+} mcfEma_t;
+
+typedef struct mcfMedian_t {
+    mcfVec_t hist[MCF_MEDIAN_N];
+    uint32_t idx;
+    bool primed;
+} mcfMedian_t;
+
+typedef struct mcfBiquad_t {
+    mcfLane_t b0, b1, b2, a1, a2;   /* a0 normalised to 1 */
+    mcfVec_t z1, z2;
+    bool primed;
+} mcfBiquad_t;
+
+/* Until the window fills the mean is of the samples pushed so far */
+void mcfMaInit(mcfMa_t *f);
+void mcfMaPush(mcfMa_t *f, const mcfVec_t *x);
+void mcfMaGet(const mcfMa_t *f, mcfVec_t *out);
+
+/* alpha is the weight of the new sample, 0 < alpha <= 1. The first sample
+ * is taken as is */
+void mcfEmaInit(mcfEma_t *f, float alpha);
+void mcfEmaPush(mcfEma_t *f, const mcfVec_t *x, mcfVec_t *out);
+
+/* The first sample fills the window, so there is output straight away */
+void mcfMedianInit(mcfMedian_t *f);
+void mcfMedianPush(mcfMedian_t *f, const mcfVec_t *x, mcfVec_t *out);
+
+/* The same coefficients for every channel. The state starts out settled on
+ * the first sample so there is no step response from zero */
+void mcfBiquadInit(mcfBiquad_t *f, float b0, float b1, float b2, float a1, float a2);
+/* Butterworth low pass, Q of 1/sqrt(2) */
+int mcfBiquadLowpass(mcfBiquad_t *f, float cutoffHz, float sampleHz);
+void mcfBiquadPush(mcfBiquad_t *f, const mcfVec_t *x, mcfVec_t *out);
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef __PERIODIC_H__
+#define __PERIODIC_H__
+
+#include <stdint.h>
+#include <time.h>
+
+/***
+ * Fixed rate loops
+ *
+ * A periodic_t keeps an absolute deadline on CLOCK_MONOTONIC (the same clock
+ * as getuSTimestamp()) and periodicWait() sleeps until it with
+ * clock_nanosleep(TIMER_ABSTIME), then moves it on by exactly one period.
+ * How long the loop body took no longer adds to the period, so a 10 mS loop
+ * really runs 100 times a second:
+ *
+ *      periodic_t task;
+ *      periodicInit(&task, "nav", 10000);
+ *      while (1) {
+ *          doWork();
+ *          periodicWait(&task);
+ *      }
+ *
+ * If the body runs past one or more deadlines, those periods are counted as
+ * overruns and skipped rather than run back to back to catch up. Every task
+ * also keeps a histogram of how late it woke up, see periodicShowAll().
+ */
+
+#define PERIODIC_MAX_TASKS  16
+#define PERIODIC_HIST_BINS  8
+
+/* Upper edge of each wakeup latency bin in uS, the last bin is everything over */
+#define PERIODIC_HIST_EDGES { 50, 100, 250, 500, 1000, 2500, 5000, UINT64_MAX }
+
+typedef struct periodic_t {
+    const char *name;
+    uint64_t periodUs;
+    struct timespec deadline;   /* Next wakeup */
+    uint64_t runs;
+    uint64_t overruns;          /* Periods skipped because the body ran long */
+    uint64_t latencySumUs;      /* Of how late each wakeup was */
+    uint64_t latencyMaxUs;
+    uint32_t hist[PERIODIC_HIST_BINS];
+} periodic_t;
+
+/* Starts the first period now and registers the task for periodicShowAll().
+ * task must stay valid for the life of the program, name too */
+int periodicInit(periodic_t *task, const char *name, uint64_t periodUs);
+
+/* Sleeps until the next deadline. Returns how many periods were missed since
+ * the last call, 0 if the loop kept up, -1 on error */
+int periodicWait(periodic_t *task);
+
+/* Zeroes the stats without touching the schedule */
+void periodicResetStats(periodic_t *task);
+
+void periodicShowStats(const periodic_t *task);
+/* Takes no lock, so a signal handler can call it even if it interrupted
+ * periodicInit() */
+void periodicShowAll(void);
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef __RING_H__
+#define __RING_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/***
+ * tsRing_t - History of one channel as timestamped samples
+ *
+ * One thread pushes, any number of threads read, and nobody takes a lock.
+ * The newest samples overwrite the oldest once the ring is full. Readers can
+ * look at a window of the most recent samples in place with tsRingWindow(),
+ * then check tsRingWindowValid() once they are done with it. If it returns
+ * false the writer lapped them while they were reading, and they should
+ * try again. tsRingMean() and tsRingLatest() already do this.
+ *
+ * The size is rounded up to a power of two. A window can hold at most
+ * size - 1 samples, because the writer may be filling the slot after it.
+ */
+
+typedef struct tsSample_t {
+    uint64_t time;      /* uS, same clock as getuSTimestamp() */
+    double val;
+} tsSample_t;
+
+typedef struct tsRing_t {
+    tsSample_t *buf;
+    uint32_t size;
+    uint32_t mask;
+    uint64_t head;      /* Samples ever pushed, only the writer changes it */
+    uint64_t base;      /* Samples before this were cleared */
+} tsRing_t;
+
+/* The most recent samples, oldest first. They may wrap around the end of the
+ * buffer, so they come as up to two contiguous spans */
+typedef struct tsWindow_t {
+    const tsSample_t *span[2];
+    uint32_t len[2];
+    uint64_t start;     /* Sequence number of the oldest sample in the window */
+} tsWindow_t;
+
+int tsRingInit(tsRing_t *ring, uint32_t size);
+void tsRingFree(tsRing_t *ring);
+
+/* Writer only */
+void tsRingPush(tsRing_t *ring, uint64_t time, double val);
+
+/* Drops every sample pushed so far, from any thread */
+void tsRingClear(tsRing_t *ring);
+
+/* How many samples are held, at most size */
+uint32_t tsRingCount(const tsRing_t *ring);
+
+/* Returns how many samples are in the window, up to n */
+uint32_t tsRingWindow(const tsRing_t *ring, uint32_t n, tsWindow_t *win);
+bool tsRingWindowValid(const tsRing_t *ring, const tsWindow_t *win);
+
+/* Newest sample, returns -1 if the ring is empty */
+int tsRingLatest(const tsRing_t *ring, tsSample_t *out);
+
+/* The newest sample that is at least back samples old, 0 being the newest.
+ * Returns -1 if the ring doesn't go back that far */
+int tsRingAt(const tsRing_t *ring, uint32_t back, tsSample_t *out);
+
+/* Mean of the last n samples, or of all of them if there are fewer. 0 if
+ * the ring is empty */
+double tsRingMean(const tsRing_t *ring, uint32_t n);
+
+#endif
@@ -1,3 +1,7 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <filters.h>
+
 /* For both rolling averages, do not make the window bigger than the array of vals passed in */
 float rollingAvgFloat(float *vals, int windowSize) {
     int i = 0;
@@ -30,3 +34,146 @@ int expFilterInt(int currVal, int prevVal, float weight) {
     
     return (term1 + term2);
 }
+
+
+int rollMeanInit(rollMean_t *f, uint32_t size) {
+    if (size == 0) size = 1;
+    f->vals = (double *) malloc(size * sizeof(double));
+    if (f->vals == NULL) {
+        fprintf(stderr, "Filter malloc fail\n");
+        return -1;
+    }
+    f->size = size;
+    rollMeanReset(f);
+    return 0;
+}
+
+void rollMeanFree(rollMean_t *f) {
+    free(f->vals);
+    f->vals = NULL;
+}
+
+void rollMeanReset(rollMean_t *f) {
+    f->count = 0;
+    f->idx = 0;
+    f->sinceResum = 0;
+    f->sum = 0;
+    f->comp = 0;
+    f->m2 = 0;
+}
+
+/* Kahan summation, keeps the low bits a plain += would throw away */
+static inline void kahanAdd(rollMean_t *f, double val) {
+    double y = val - f->comp;
+    double t = f->sum + y;
+    f->comp = (t - f->sum) - y;
+    f->sum = t;
+}
+
+/* Throws away the accumulated error, two passes over the window */
+static void resum(rollMean_t *f) {
+    double sum = 0, m2 = 0, mean, d;
+    uint32_t i;
+    for (i = 0; i < f->count; i++) sum += f->vals[i];
+    mean = f->count ? sum / f->count : 0;
+    for (i = 0; i < f->count; i++) {
+        d = f->vals[i] - mean;
+        m2 += d * d;
+    }
+    f->sum = sum;
+    f->comp = 0;
+    f->m2 = m2;
+    f->sinceResum = 0;
+}
+
+double rollMeanPush(rollMean_t *f, double val) {
+    double oldMean = f->count ? f->sum / f->count : 0;
+    double newMean, out;
+
+    if (f->count < f->size) {
+        f->count++;
+        kahanAdd(f, val);
+        newMean = f->sum / f->count;
+        f->m2 += (val - oldMean) * (val - newMean);
+    } else {
+        out = f->vals[f->idx];
+        kahanAdd(f, val - out);
+        newMean = f->sum / f->count;
+        f->m2 += (val - out) * (val - newMean + out - oldMean);
+    }
+    f->vals[f->idx] = val;
+    if (++f->idx == f->size) f->idx = 0;
+
+    if (++f->sinceResum >= ROLL_RESUM_EVERY) {
+        resum(f);
+        newMean = f->sum / f->count;
+    }
+    return newMean;
+}
+
+double rollMeanGet(const rollMean_t *f) {
+    return f->count ? f->sum / f->count : 0;
+}
+
+double rollMeanVar(const rollMean_t *f) {
+    /* Rounding can leave m2 just under zero when every sample is the same */
+    if (f->count == 0 || f->m2 < 0) return 0;
+    return f->m2 / f->count;
+}
+
+int rollMeanFixInit(rollMeanFix_t *f, uint32_t size) {
+    if (size == 0) size = 1;
+    if (size > ROLL_FIX_MAX_SIZE) {
+        fprintf(stderr, "Fixed point window of %u is over %d\n", size, ROLL_FIX_MAX_SIZE);
+        return -1;
+    }
+    f->vals = (int32_t *) malloc(size * sizeof(int32_t));
+    if (f->vals == NULL) {
+        fprintf(stderr, "Filter malloc fail\n");
+        return -1;
+    }
+    f->size = size;
+    rollMeanFixReset(f);
+    return 0;
+}
+
+void rollMeanFixFree(rollMeanFix_t *f) {
+    free(f->vals);
+    f->vals = NULL;
+}
+
+void rollMeanFixReset(rollMeanFix_t *f) {
+    f->count = 0;
+    f->idx = 0;
+    f->sum = 0;
+    f->sumSq = 0;
+}
+
+int32_t rollMeanFixPush(rollMeanFix_t *f, int32_t val) {
+    int32_t out;
+    if (f->count < f->size) {
+        f->count++;
+    } else {
+        out = f->vals[f->idx];
+        f->sum -= out;
+        f->sumSq -= (int64_t) out * out;
+    }
+    f->sum += val;
+    f->sumSq += (int64_t) val * val;
+    f->vals[f->idx] = val;
+    if (++f->idx == f->size) f->idx = 0;
+    return rollMeanFixGet(f);
+}
+
+int32_t rollMeanFixGet(const rollMeanFix_t *f) {
+    int64_t n = f->count;
+    if (n == 0) return 0;
+    /* Round half away from zero, plain division truncates toward it */
+    return (int32_t) (f->sum >= 0 ? (f->sum + n / 2) / n : (f->sum - n / 2) / n);
+}
+
+int64_t rollMeanFixVar(const rollMeanFix_t *f) {
+    int64_t n = f->count;
+    if (n == 0) return 0;
+    return (f->sumSq - f->sum * f->sum / n) / n;
+}
@@ -0,0 +1,141 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <mcFilter.h>
+
+static inline mcfLane_t broadcast(float val) {
+    mcfLane_t v = { val, val, val, val };
+    return v;
+}
+
+void mcfMaInit(mcfMa_t *f) {
+    memset(f, 0, sizeof(*f));
+}
+
+/* Throws away the rounding error the running sum has picked up */
+static void maResum(mcfMa_t *f) {
+    int i, l;
+    for (l = 0; l < MCF_LANES; l++) f->sum.lane[l] = broadcast(0);
+    for (i = 0; i < MCF_MA_WINDOW; i++) {
+        for (l = 0; l < MCF_LANES; l++) f->sum.lane[l] += f->hist[i].lane[l];
+    }
+    f->sinceResum = 0;
+}
+
+void mcfMaPush(mcfMa_t *f, const mcfVec_t *x) {
+    mcfVec_t *slot = &f->hist[f->idx];
+    int l;
+
+    /* Slots are zero until the window fills, so taking them away is fine */
+    for (l = 0; l < MCF_LANES; l++) {
+        f->sum.lane[l] += x->lane[l] - slot->lane[l];
+        slot->lane[l] = x->lane[l];
+    }
+    if (++f->idx == MCF_MA_WINDOW) f->idx = 0;
+    if (f->count < MCF_MA_WINDOW) f->count++;
+    if (++f->sinceResum == MCF_MA_WINDOW) maResum(f);
+}
+
+void mcfMaGet(const mcfMa_t *f, mcfVec_t *out) {
+    mcfLane_t scale = broadcast(f->count ? 1.0f / f->count : 0);
+    int l;
+    for (l = 0; l < MCF_LANES; l++) out->lane[l] = f->sum.lane[l] * scale;
+}
+
+void mcfEmaInit(mcfEma_t *f, float alpha) {
+    memset(f, 0, sizeof(*f));
+    f->alpha = broadcast(alpha);
+}
+
+void mcfEmaPush(mcfEma_t *f, const mcfVec_t *x, mcfVec_t *out) {
+    int l;
+    if (!f->primed) {
+        f->y = *x;
+        f->primed = true;
+    } else {
+        for (l = 0; l < MCF_LANES; l++) f->y.lane[l] += f->alpha * (x->lane[l] - f->y.lane[l]);
+    }
+    if (out) *out = f->y;
+}
+
+void mcfMedianInit(mcfMedian_t *f) {
+    memset(f, 0, sizeof(*f));
+}
+
+/* Puts the smaller of each channel in a and the larger in b, without
+ * branching so it stays in vector registers */
+static inline void sort2(mcfLane_t *a, mcfLane_t *b) {
+    mcfMask_t lt = *a < *b;
+    mcfMask_t ia = (mcfMask_t) *a, ib = (mcfMask_t) *b;
+    *a = (mcfLane_t) ((lt & ia) | (~lt & ib));
+    *b = (mcfLane_t) ((lt & ib) | (~lt & ia));
+}
+
+void mcfMedianPush(mcfMedian_t *f, const mcfVec_t *x, mcfVec_t *out) {
+    mcfVec_t sorted[MCF_MEDIAN_N];
+    int i, pass, l;
+
+    if (!f->primed) {
+        for (i = 0; i < MCF_MEDIAN_N; i++) f->hist[i] = *x;
+        f->primed = true;
+    }
+    f->hist[f->idx] = *x;
+    if (++f->idx == MCF_MEDIAN_N) f->idx = 0;
+
+    /* Odd-even transposition sort, N passes sorts N values in every lane */
+    memcpy(sorted, f->hist, sizeof(sorted));
+    for (pass = 0; pass < MCF_MEDIAN_N; pass++) {
+        for (i = pass & 1; i + 1 < MCF_MEDIAN_N; i += 2) {
+            for (l = 0; l < MCF_LANES; l++) sort2(&sorted[i].lane[l], &sorted[i + 1].lane[l]);
+        }
+    }
+    *out = sorted[MCF_MEDIAN_N / 2];
+}
+
+void mcfBiquadInit(mcfBiquad_t *f, float b0, float b1, float b2, float a1, float a2) {
+    memset(f, 0, sizeof(*f));
+    f->b0 = broadcast(b0);
+    f->b1 = broadcast(b1);
+    f->b2 = broadcast(b2);
+    f->a1 = broadcast(a1);
+    f->a2 = broadcast(a2);
+}
+
+/* Coefficients from the Audio EQ Cookbook */
+int mcfBiquadLowpass(mcfBiquad_t *f, float cutoffHz, float sampleHz) {
+    double w0, alpha, cosw0, a0;
+    if (cutoffHz <= 0 || cutoffHz >= sampleHz / 2) {
+        fprintf(stderr, "Low pass cutoff %f Hz is not below Nyquist for %f Hz\n", cutoffHz, sampleHz);
+        return -1;
+    }
+    w0 = 2 * M_PI * cutoffHz / sampleHz;
+    cosw0 = cos(w0);
+    alpha = sin(w0) / (2 * M_SQRT1_2);
+    a0 = 1 + alpha;
+    mcfBiquadInit(f, (1 - cosw0) / 2 / a0, (1 - cosw0) / a0, (1 - cosw0) / 2 / a0,
+            -2 * cosw0 / a0, (1 - alpha) / a0);
+    return 0;
+}
+
+void mcfBiquadPush(mcfBiquad_t *f, const mcfVec_t *x, mcfVec_t *out) {
+    mcfLane_t in, y, gain;
+    int l;
+
+    if (!f->primed) {
+        /* The state a settled filter would have with x as its input forever */
+        gain = (f->b0 + f->b1 + f->b2) / (broadcast(1) + f->a1 + f->a2);
+        for (l = 0; l < MCF_LANES; l++) {
+            y = gain * x->lane[l];
+            f->z2.lane[l] = f->b2 * x->lane[l] - f->a2 * y;
+            f->z1.lane[l] = f->b1 * x->lane[l] - f->a1 * y + f->z2.lane[l];
+        }
+        f->primed = true;
+    }
+    for (l = 0; l < MCF_LANES; l++) {
+        in = x->lane[l];
+        y = f->b0 * in + f->z1.lane[l];
+        f->z1.lane[l] = f->b1 * in - f->a1 * y + f->z2.lane[l];
+        f->z2.lane[l] = f->b2 * in - f->a2 * y;
+        out->lane[l] = y;
+    }
+}
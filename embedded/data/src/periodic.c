@@ -0,0 +1,111 @@
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include "periodic.h"
+
+#define NS_PER_US   1000ULL
+#define NS_PER_S    1000000000ULL
+
+static const uint64_t histEdges[PERIODIC_HIST_BINS] = PERIODIC_HIST_EDGES;
+
+static periodic_t *tasks[PERIODIC_MAX_TASKS];
+static int numTasks = 0;
+static pthread_mutex_t tasksLock = PTHREAD_MUTEX_INITIALIZER;
+
+static inline uint64_t tsToNs(const struct timespec *ts) {
+    return (uint64_t) ts->tv_sec * NS_PER_S + ts->tv_nsec;
+}
+
+static inline void nsToTs(uint64_t ns, struct timespec *ts) {
+    ts->tv_sec = ns / NS_PER_S;
+    ts->tv_nsec = ns % NS_PER_S;
+}
+
+int periodicInit(periodic_t *task, const char *name, uint64_t periodUs) {
+    if (periodUs == 0) {
+        fprintf(stderr, "Periodic task %s needs a period\n", name);
+        return -1;
+    }
+    memset(task, 0, sizeof(*task));
+    task->name = name;
+    task->periodUs = periodUs;
+    clock_gettime(CLOCK_MONOTONIC, &task->deadline);
+
+    /* The lock is only between registrations. The task goes in tasks[]
+     * before numTasks counts it, so periodicShowAll() can read without it */
+    pthread_mutex_lock(&tasksLock);
+    if (numTasks < PERIODIC_MAX_TASKS) {
+        tasks[numTasks] = task;
+        __atomic_store_n(&numTasks, numTasks + 1, __ATOMIC_RELEASE);
+    } else {
+        fprintf(stderr, "Too many periodic tasks, %s won't be shown\n", name);
+    }
+    pthread_mutex_unlock(&tasksLock);
+    return 0;
+}
+
+int periodicWait(periodic_t *task) {
+    struct timespec now;
+    uint64_t periodNs = task->periodUs * NS_PER_US;
+    uint64_t deadline = tsToNs(&task->deadline) + periodNs;
+    uint64_t nowNs, lateUs;
+    int missed = 0, ret, i;
+
+    /* Ran past one or more deadlines, skip them instead of bursting to catch up */
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    nowNs = tsToNs(&now);
+    if (nowNs > deadline) {
+        missed = (nowNs - deadline) / periodNs + 1;
+        deadline += missed * periodNs;
+        task->overruns += missed;
+    }
+    nsToTs(deadline, &task->deadline);
+
+    do {
+        ret = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &task->deadline, NULL);
+    } while (ret == EINTR);
+    if (ret != 0) {
+        fprintf(stderr, "Periodic task %s: clock_nanosleep failed (%d)\n", task->name, ret);
+        return -1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    nowNs = tsToNs(&now);
+    lateUs = nowNs > deadline ? (nowNs - deadline) / NS_PER_US : 0;
+    task->runs++;
+    task->latencySumUs += lateUs;
+    if (lateUs > task->latencyMaxUs) task->latencyMaxUs = lateUs;
+    for (i = 0; i < PERIODIC_HIST_BINS - 1 && lateUs >= histEdges[i]; i++);
+    task->hist[i]++;
+    return missed;
+}
+
+void periodicResetStats(periodic_t *task) {
+    task->runs = 0;
+    task->overruns = 0;
+    task->latencySumUs = 0;
+    task->latencyMaxUs = 0;
+    memset(task->hist, 0, sizeof(task->hist));
+}
+
+void periodicShowStats(const periodic_t *task) {
+    int i;
+    printf("%-12s %6lluuS: %llu runs, %llu overruns, latency avg %llu max %lluuS\n",
+            task->name, (unsigned long long) task->periodUs,
+            (unsigned long long) task->runs, (unsigned long long) task->overruns,
+            (unsigned long long) (task->runs ? task->latencySumUs / task->runs : 0),
+            (unsigned long long) task->latencyMaxUs);
+    printf("%-12s latency uS:", "");
+    for (i = 0; i < PERIODIC_HIST_BINS - 1; i++) {
+        printf(" <%llu:%u", (unsigned long long) histEdges[i], task->hist[i]);
+    }
+    printf(" more:%u\n", task->hist[PERIODIC_HIST_BINS - 1]);
+}
+
+void periodicShowAll() {
+    int i, n = __atomic_load_n(&numTasks, __ATOMIC_ACQUIRE);
+    for (i = 0; i < n; i++) {
+        periodicShowStats(tasks[i]);
+    }
+}
@@ -0,0 +1,104 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "ring.h"
+
+int tsRingInit(tsRing_t *ring, uint32_t size) {
+    uint32_t pow2 = 2;
+    while (pow2 < size) pow2 <<= 1;
+
+    ring->buf = (tsSample_t *) calloc(pow2, sizeof(tsSample_t));
+    if (ring->buf == NULL) {
+        fprintf(stderr, "Ring malloc fail\n");
+        return -1;
+    }
+    ring->size = pow2;
+    ring->mask = pow2 - 1;
+    ring->head = 0;
+    ring->base = 0;
+    return 0;
+}
+
+void tsRingFree(tsRing_t *ring) {
+    free(ring->buf);
+    ring->buf = NULL;
+}
+
+void tsRingPush(tsRing_t *ring, uint64_t time, double val) {
+    uint64_t head = ring->head;
+    tsSample_t *slot = &ring->buf[head & ring->mask];
+    slot->time = time;
+    slot->val = val;
+    /* Publish the sample only once it is all there */
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+/* Nothing is overwritten, so a window taken before this stays valid */
+void tsRingClear(tsRing_t *ring) {
+    __atomic_store_n(&ring->base, __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE),
+            __ATOMIC_RELEASE);
+}
+
+/* Samples that haven't been cleared, capped at max */
+static inline uint64_t available(const tsRing_t *ring, uint64_t head, uint64_t max) {
+    uint64_t base = __atomic_load_n(&ring->base, __ATOMIC_ACQUIRE);
+    uint64_t n = head > base ? head - base : 0;
+    return n < max ? n : max;
+}
+
+uint32_t tsRingCount(const tsRing_t *ring) {
+    uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    return available(ring, head, ring->size);
+}
+
+uint32_t tsRingWindow(const tsRing_t *ring, uint32_t n, tsWindow_t *win) {
+    uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    uint32_t first, idx;
+
+    if (n > ring->size - 1) n = ring->size - 1;
+    n = available(ring, head, n);
+    win->start = head - n;
+    idx = win->start & ring->mask;
+    first = ring->size - idx;
+    if (first > n) first = n;
+
+    win->span[0] = &ring->buf[idx];
+    win->len[0] = first;
+    win->span[1] = ring->buf;
+    win->len[1] = n - first;
+    return n;
+}
+
+bool tsRingWindowValid(const tsRing_t *ring, const tsWindow_t *win) {
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    /* The writer may already be filling slot head, which was win->start once */
+    return head - win->start < ring->size;
+}
+
+int tsRingAt(const tsRing_t *ring, uint32_t back, tsSample_t *out) {
+    tsWindow_t win;
+    do {
+        if (tsRingWindow(ring, back + 1, &win) != back + 1) return -1;
+        *out = win.len[0] ? win.span[0][0] : win.span[1][0];
+    } while (!tsRingWindowValid(ring, &win));
+    return 0;
+}
+
+int tsRingLatest(const tsRing_t *ring, tsSample_t *out) {
+    return tsRingAt(ring, 0, out);
+}
+
+double tsRingMean(const tsRing_t *ring, uint32_t n) {
+    tsWindow_t win;
+    double sum;
+    uint32_t i, j;
+
+    do {
+        n = tsRingWindow(ring, n, &win);
+        sum = 0;
+        for (j = 0; j < 2; j++) {
+            for (i = 0; i < win.len[j]; i++) sum += win.span[j][i].val;
+        }
+    } while (!tsRingWindowValid(ring, &win));
+    return n ? sum / n : 0;
+}
@@ -2,6 +2,7 @@
 #define __BBGPIO_H__
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #define RISING_EDGE  "rising"
 #define FALLING_EDGE "falling"
@@ -10,10 +11,15 @@
 #define OUT_DIR		 "out"
 #define IN_DIR		 "in"
 
+#define BB_GPIO_BANKS	 4
+#define BB_GPIO_MAX	 (BB_GPIO_BANKS * 32)
+
 int bbGetAbsPinNum(unsigned int bank, unsigned int num);
 
 int bbGpioExport(unsigned int gpio);
 
+int bbGpioUnexport(unsigned int gpio);
+
 int bbGpioSetEdge(unsigned int gpio, char * edge);
 
 int bbGpioSetDir(unsigned int gpio, char * dir);
@@ -26,8 +32,83 @@ char * bbGpioGetDir(unsigned int gpio);
 
 bool bbGpioGetValue(unsigned int gpio);
 
+/* For poll()ing on edges, a separate fd from the one the functions above use */
 int bbGpioFdOpen(unsigned int gpio);
 
 int bbGpioFdClose(int fd);
 
+/***
+ * Pin handles
+ *
+ * The functions above open each pin's sysfs files the first time they are
+ * used and then keep them open, so setting or reading a value is one pwrite()
+ * or pread() rather than building a path and open(), read/write(), close().
+ * A bbGpioPin_t skips even the lookup, for anything that toggles a pin in a
+ * loop:
+ *
+ *		bbGpioPin_t pin;
+ *		bbGpioPinOpen(&pin, 66);
+ *		bbGpioPinSet(&pin, true);
+ *
+ * The pin has to be exported first. Handles share the cached fds, so don't
+ * close them, bbGpioCloseAll() closes everything after pins are unexported.
+ * Exporting or unexporting a pin closes its cached fds, so open its handles
+ * again afterwards.
+ */
+
+typedef struct bbGpioPin_t {
+	unsigned int gpio;
+	int fd;				/* The pin's value file */
+	volatile uint32_t *bank;	/* Registers, if bbGpioMmapInit() was called first */
+	uint32_t mask;
+} bbGpioPin_t;
+
+int bbGpioPinOpen(bbGpioPin_t *pin, unsigned int gpio);
+int bbGpioPinSet(const bbGpioPin_t *pin, bool val);
+/* 1 or 0, -1 on error */
+int bbGpioPinGet(const bbGpioPin_t *pin);
+void bbGpioCloseAll(void);
+
+/* Look for gpioN directories somewhere other than /sys/class/gpio, for tests */
+void bbGpioSetSysfsRoot(const char *root);
+
+/***
+ * Register access
+ *
+ * Even a cached sysfs write is a syscall and a trip through the GPIO
+ * subsystem. bbGpioMmapInit() maps the four AM335x GPIO banks out of
+ * /dev/mem (needs root), after which a pin is set or cleared with a single
+ * store to SETDATAOUT or CLEARDATAOUT, and all 32 pins of a bank are read in
+ * one load of DATAIN. Pin numbers are the same bank * 32 + pin as sysfs.
+ *
+ * Pin handles opened after mapping use the registers automatically. The
+ * kernel still owns the pins, so export them and set the direction through
+ * sysfs first, and don't have the kernel driving the same pins at the same
+ * time. bbGpioMmapSetDir() is a read-modify-write of OE, so only use it
+ * while nothing else is changing directions in that bank.
+ *
+ * bbGpioMmapInitMock() puts plain memory where the banks would be, for
+ * testing off the BeagleBone. Nothing drives DATAIN there, poke it through
+ * bbGpioMmapBank().
+ */
+
+/* Register offsets within a bank */
+#define BB_GPIO_OE				0x134	/* 1 is input */
+#define BB_GPIO_DATAIN			0x138
+#define BB_GPIO_DATAOUT			0x13C
+#define BB_GPIO_CLEARDATAOUT	0x190
+#define BB_GPIO_SETDATAOUT		0x194
+
+int bbGpioMmapInit(void);
+int bbGpioMmapInitMock(void);
+void bbGpioMmapRelease(void);
+bool bbGpioMmapReady(void);
+volatile uint32_t *bbGpioMmapBank(unsigned int bank);
+
+/* No checks on gpio, these are meant to be as cheap as possible */
+void bbGpioMmapSet(unsigned int gpio, bool val);
+bool bbGpioMmapGet(unsigned int gpio);
+uint32_t bbGpioMmapReadBank(unsigned int bank);
+void bbGpioMmapSetDir(unsigned int gpio, bool output);
+
 #endif /* __BBGPIO_H__ */
@@ -2,6 +2,7 @@
 #define __CAN_H__
 
 #include <linux/can.h>
+#include <linux/can/raw.h>
 #include <sys/socket.h>
 #include <net/if.h>
 #include <sys/ioctl.h>
@@ -17,14 +18,53 @@
  #define CAN_INTF "can0"
 #endif
 
+/* How long a blocking receive waits before giving the caller a chance to run */
+#define CAN_RX_TIMEOUT_MS 100
+
+/* Most frames moved by a single batched read or send */
+#define CAN_BATCH_SIZE    32
+
+/* A received frame along with when the kernel took it off the bus, in uS on
+ * the same CLOCK_MONOTONIC base as getuSTimestamp() */
+typedef struct canFrameTs_t {
+    struct can_frame frame;
+    uint64_t rxTime;
+} canFrameTs_t;
+
 extern volatile bool NEW_CAN_MESSAGE;
 
 int initCan();
 
+/* Only frames matching one of these filters make it out of the kernel. Call
+ * before initCan() to have them in place from the start, the array must stay
+ * valid for as long as the socket is open. No filters means every frame */
+int canSetFilters(const struct can_filter *filters, int numFilters);
+
+/* Frames read by us, and frames the interface saw that the filters dropped,
+ * both counted from initCan() */
+void canGetRxStats(uint64_t *delivered, uint64_t *filtered);
+
 int canRead(struct can_frame *can_mesg);
 
+/* Blocks until a frame is pending on the bus (1), the timeout expires (0),
+ * or an error occurs (-1). Pair with canRead() to drain everything pending */
+int canWait(int timeoutMs);
+
+/* Closes the socket and opens it again with the same filters, for when
+ * canWait() keeps failing. Returns 0 on success */
+int canReopen();
+
+/* Doesn't block, returns -1 if the frame wasn't queued */
 int canSend(uint32_t id, uint8_t *data, uint8_t size);
 
+/* Reads up to maxFrames (capped at CAN_BATCH_SIZE) pending frames in one
+ * syscall without blocking. Returns the number read, 0 if none were waiting */
+int canReadBatch(canFrameTs_t *frames, int maxFrames);
+
+/* Sends numFrames frames in as few syscalls as possible, returns the
+ * number the kernel accepted */
+int canSendBatch(struct can_frame *frames, int numFrames);
+
 /* Potential ideas for a future API */
 // bool start_can_read();
 
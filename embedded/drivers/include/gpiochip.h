@@ -0,0 +1,56 @@
+#ifndef __GPIOCHIP_H__
+#define __GPIOCHIP_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/***
+ * GPIO edge events through the gpiochip character device
+ *
+ * The sysfs interface in bbgpio.h only says that an edge happened, so the
+ * time has to be taken whenever the waiting thread gets to run. Here the
+ * kernel stamps every edge in its interrupt handler, on CLOCK_MONOTONIC (the
+ * clock getuSTimestamp() uses), and queues it. Any number of lines on one chip
+ * can be watched through a single fd, and their events come out of it in the
+ * order they happened.
+ *
+ *      unsigned int offsets[2] = { 2, 5 };
+ *      int fd = gpioRequestEdges(2, offsets, 2, GPIO_EDGE_RISING, "retro");
+ *      gpioEvent_t ev[16];
+ *      n = gpioReadEvents(fd, ev, 16, 100);
+ *
+ * This needs the v2 uAPI (Linux 5.10+). On older headers gpioRequestEdges()
+ * returns -1 and callers should fall back to sysfs, see gpioEventsSupported().
+ */
+
+#define GPIO_EDGE_RISING    1
+#define GPIO_EDGE_FALLING   2
+#define GPIO_EDGE_BOTH      (GPIO_EDGE_RISING | GPIO_EDGE_FALLING)
+
+#define GPIO_EVENT_BUF      64      /* Edges the kernel holds per request */
+
+typedef struct gpioEvent_t {
+    uint64_t time;          /* uS, when the kernel saw the edge */
+    unsigned int offset;    /* Line on the chip */
+    bool rising;
+    uint32_t seqno;         /* Counts up across every line, gaps mean lost events */
+} gpioEvent_t;
+
+bool gpioEventsSupported(void);
+
+/* A sysfs GPIO number on the BeagleBone is chip * 32 + offset */
+void gpioChipLine(unsigned int gpio, unsigned int *chip, unsigned int *offset);
+
+/* Returns an fd for events on the lines, -1 on error */
+int gpioRequestEdges(unsigned int chip, const unsigned int *offsets, int numLines,
+        int edges, const char *consumer);
+
+/* Waits up to timeoutMs (-1 forever) for events and returns how many were
+ * read into ev, 0 on timeout and -1 on error. fd doesn't have to be a GPIO,
+ * anything that reads back struct gpio_v2_line_event works, which is how the
+ * tests feed in made up edges */
+int gpioReadEvents(int fd, gpioEvent_t *ev, int max, int timeoutMs);
+
+int gpioRelease(int fd);
+
+#endif
@@ -13,6 +13,8 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <sys/ioctl.h>
+#include <stdint.h>
+#include <stdbool.h>
 
 typedef struct {
 	int fd;
@@ -21,12 +23,65 @@ typedef struct {
 	int openMode;
 } i2c_settings;
 
+/***
+ * Every i2c_settings on a bus shares one fd, opened by the first
+ * i2c_begin(). Each call below is one transaction that holds the bus until
+ * it's done, so two threads can never interleave on it. Transfers go out
+ * through I2C_RDWR with the address in every message, so switching devices
+ * costs nothing, and write_read_i2c() sets a register and reads it back with
+ * a repeated start instead of a stop in between. While the bus is busy,
+ * callers queue. Devices given I2C_PRIO_HIGH (pressure, limit switches,
+ * solenoids) always go ahead of the rest, so at worst they wait for the one
+ * transfer already on the bus, like an IMU read.
+ */
 
+#define I2C_MAX_BUSES   3
+#define I2C_MAX_MSGS    42      /* What the kernel takes in one I2C_RDWR */
 
+#define I2C_PRIO_NORMAL 0
+#define I2C_PRIO_HIGH   1
+#define I2C_NUM_PRIOS   2
+
+/* Per device, all in uS */
+typedef struct i2cStats_t {
+	uint64_t count;
+	uint64_t errors;
+	uint64_t waitTotal;     /* Queued behind other devices */
+	uint64_t waitMax;
+	uint64_t xferTotal;     /* On the bus */
+	uint64_t xferMax;
+} i2cStats_t;
 
 int i2c_begin(i2c_settings *i2c);
 int write_byte_i2c(i2c_settings *i2c, unsigned char reg);
 int write_data_i2c(i2c_settings *i2c, unsigned char reg, char value);
+/* reg then len bytes in one transaction, for devices that step through
+ * registers on their own */
+int write_block_i2c(i2c_settings *i2c, unsigned char reg, const unsigned char *values, int len);
 int read_i2c(i2c_settings *i2c, unsigned char *readBuffer, int bufferSize);
+/* Both in one transaction, with a repeated start and no stop between */
+int write_read_i2c(i2c_settings *i2c, const unsigned char *writeBuffer, int writeSize,
+		unsigned char *readBuffer, int readSize);
+
+/* Any mix of up to I2C_MAX_MSGS reads and writes as one transaction. The
+ * addresses are filled in. 0 on success */
+int i2cTransfer(i2c_settings *i2c, struct i2c_msg *msgs, int numMsgs);
+/* Also gives when it got the bus and finished, uS on the same clock as
+ * getuSTimestamp(). Time spent queued isn't included */
+int i2cTransferTimed(i2c_settings *i2c, struct i2c_msg *msgs, int numMsgs,
+		uint64_t *startTime, uint64_t *endTime);
+
+/* Applies to every i2c_settings with the same bus and address */
+int i2cSetPriority(i2c_settings *i2c, int priority);
+int i2cGetStats(i2c_settings *i2c, i2cStats_t *stats);
+void i2cResetStats(i2c_settings *i2c);
+
+/* How many transactions have gone out on any bus */
+unsigned long i2cTransactionCount(void);
+
+/* The bus uses a dup of fd instead of /dev/i2c-N, -1 to stop. Every message
+ * is then a plain write() or read(), which lets a test stand a socket in for
+ * the bus and play the device */
+void i2cUseFd(int bus, int fd);
 
 #endif 
\ No newline at end of file
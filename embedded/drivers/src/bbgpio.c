@@ -9,12 +9,85 @@
 #include <bbgpio.h>
 #include <unistd.h>
 #include <string.h>
+#include <pthread.h>
 
 
 #define BUFF_SIZE 256
 #define SYSFS_GPIO "/sys/class/gpio"
 #define NUM_BANKS 3
 
+/* Files under gpioN that get opened once and kept */
+#define ATTR_VALUE	0
+#define ATTR_DIR	1
+#define ATTR_EDGE	2
+#define NUM_ATTRS	3
+
+static const char *attrNames[NUM_ATTRS] = { "value", "direction", "edge" };
+static const char *sysfsRoot = SYSFS_GPIO;
+
+/* fd + 1 for each pin's attribute, so 0 means not open yet */
+static int attrFds[BB_GPIO_MAX][NUM_ATTRS];
+static pthread_mutex_t attrLock = PTHREAD_MUTEX_INITIALIZER;
+
+void bbGpioSetSysfsRoot(const char *root) {
+	sysfsRoot = root;
+}
+
+/* Opens an attribute the first time it is used and keeps the fd after that.
+ * Writing to direction doesn't invalidate value's fd, so nothing needs
+ * reopening while the pin stays exported */
+static int attrFd(unsigned int gpio, int attr) {
+	char buff[BUFF_SIZE];
+	int fd;
+
+	if (gpio >= BB_GPIO_MAX) {
+		fprintf(stderr, "No GPIO %u\n", gpio);
+		return -1;
+	}
+	fd = __atomic_load_n(&attrFds[gpio][attr], __ATOMIC_ACQUIRE);
+	if (fd) return fd - 1;
+
+	pthread_mutex_lock(&attrLock);
+	fd = attrFds[gpio][attr];
+	if (fd == 0) {
+		snprintf(buff, sizeof(buff), "%s/gpio%u/%s", sysfsRoot, gpio, attrNames[attr]);
+		fd = open(buff, O_RDWR | O_CLOEXEC);
+		/* Only root can write some of them, reading still works */
+		if (fd < 0) fd = open(buff, O_RDONLY | O_CLOEXEC);
+		if (fd >= 0) __atomic_store_n(&attrFds[gpio][attr], fd + 1, __ATOMIC_RELEASE);
+	} else {
+		fd--;
+	}
+	pthread_mutex_unlock(&attrLock);
+	return fd;
+}
+
+/* Exporting or unexporting makes a new gpioN directory, so the pin's cached
+ * fds would point at the old files */
+static void attrDrop(unsigned int gpio) {
+	int attr;
+	if (gpio >= BB_GPIO_MAX) return;
+	pthread_mutex_lock(&attrLock);
+	for (attr = 0; attr < NUM_ATTRS; attr++) {
+		if (attrFds[gpio][attr]) close(attrFds[gpio][attr] - 1);
+		__atomic_store_n(&attrFds[gpio][attr], 0, __ATOMIC_RELEASE);
+	}
+	pthread_mutex_unlock(&attrLock);
+}
+
+/* Whole sysfs attributes are always read and written from the start */
+static int attrWrite(unsigned int gpio, int attr, const char *val) {
+	int fd = attrFd(gpio, attr);
+	if (fd < 0 || pwrite(fd, val, strlen(val), 0) < 0) return -1;
+	return 0;
+}
+
+static int attrReadFirst(unsigned int gpio, int attr, char *c) {
+	int fd = attrFd(gpio, attr);
+	if (fd < 0 || pread(fd, c, 1, 0) != 1) return -1;
+	return 0;
+}
+
 
 /* For converting when a pin is listed as GPIOX_Y,
  *   where X is the bank, and Y is the num
@@ -28,13 +101,18 @@ int bbGetAbsPinNum(unsigned int bank, unsigned int num) {
 	return bank * 32 + num;
 }
 
-int bbGpioExport(unsigned int gpio) {
-	int fd = open(SYSFS_GPIO "/export", O_WRONLY);
+/* Writes the pin number to export or unexport */
+static int exportWrite(const char *file, unsigned int gpio) {
+	int fd;
 	int len = 0;
 	char buff[BUFF_SIZE];
 
+	attrDrop(gpio);
+	snprintf(buff, sizeof(buff), "%s/%s", sysfsRoot, file);
+	fd = open(buff, O_WRONLY);
+
 	if (fd < 0) {
-		fprintf(stderr, "Failed to export pin %d", gpio);
+		fprintf(stderr, "Failed to %s pin %d\n", file, gpio);
 		return -1;
 	}
 
@@ -44,79 +122,48 @@ int bbGpioExport(unsigned int gpio) {
 	return 0;
 }
 
-int bbGpioSetEdge(unsigned int gpio, char *edge) {
-	int fd;
-	char buff[BUFF_SIZE];
-
-	snprintf(buff, sizeof(buff), SYSFS_GPIO "/gpio%d/edge", gpio);
+int bbGpioExport(unsigned int gpio) {
+	return exportWrite("export", gpio);
+}
 
-	fd = open(buff, O_WRONLY);
+int bbGpioUnexport(unsigned int gpio) {
+	return exportWrite("unexport", gpio);
+}
 
-	if (fd < 0) {
+int bbGpioSetEdge(unsigned int gpio, char *edge) {
+	if (attrWrite(gpio, ATTR_EDGE, edge) != 0) {
 		fprintf(stderr, "Failed to set edge on pin %d", gpio);
 		return -1;
 	}
-
-	write(fd, edge, strlen(edge) + 1);
-	close(fd);
 	return 0;
 }
 
 
 int bbGpioSetDir(unsigned int gpio, char *dir) {
-	int fd;
-	char buff[BUFF_SIZE];
-
-	snprintf(buff, sizeof(buff), SYSFS_GPIO "/gpio%d/direction", gpio);
-
-	fd = open(buff, O_WRONLY);
-
-	if (fd < 0) {
+	if (attrWrite(gpio, ATTR_DIR, dir) != 0) {
 		fprintf(stderr, "Failed to set direction on pin %d", gpio);
 		return -1;
 	}
-
-	write(fd, dir, strlen(dir) + 1);
-	close(fd);
 	return 0;
 }
 
 int bbGpioSetValue(unsigned int gpio, bool val) {
-	int fd;
-	char buff[BUFF_SIZE];
-
-	snprintf(buff, sizeof(buff), SYSFS_GPIO "/gpio%d/value", gpio);
-
-	fd = open(buff, O_WRONLY);
-
-	if (fd < 0) {
+	if (attrWrite(gpio, ATTR_VALUE, val ? "1" : "0") != 0) {
 		fprintf(stderr, "Failed to set value on pin %d\n", gpio);
 		return -1;
 	}
-	if (val) write(fd, "1", 2);
-	else write(fd, "0", 2);
-	close(fd);
 	return 0;
 }
 
 /* Figure out the edge by checking the first character */
 char * bbGpioGetEdge(unsigned int gpio) {
-	int fd;
-	char buff[BUFF_SIZE];
 	char firstCharOfEdge;
 
-	snprintf(buff, sizeof(buff), SYSFS_GPIO "/gpio%d/edge", gpio);
-
-	fd = open(buff, O_RDONLY);
-
-	if (fd < 0) {
+	if (attrReadFirst(gpio, ATTR_EDGE, &firstCharOfEdge) != 0) {
 		fprintf(stderr, "Failed to get edge on pin %d\n", gpio);
 		return "error";
 	}
 
-	read(fd, &firstCharOfEdge, 1);
-	close(fd);
-
 	if (firstCharOfEdge == RISING_EDGE[0]) {
 		return RISING_EDGE;
 	} else if (firstCharOfEdge == FALLING_EDGE[0]) {
@@ -134,20 +181,12 @@ char * bbGpioGetEdge(unsigned int gpio) {
  * and thus we know that the first character for each is unique, and we only
  * read that */
 char * bbGpioGetDir(unsigned int gpio) {
-	int fd;
-	char buff[BUFF_SIZE];
 	char firstCharOfDir;	/* Extra explicit because of this hacky method */
 
-	snprintf(buff, sizeof(buff), SYSFS_GPIO "/gpio%d/direction", gpio);
-
-	fd = open(buff, O_RDONLY);
-
-	if (fd < 0) {
+	if (attrReadFirst(gpio, ATTR_DIR, &firstCharOfDir) != 0) {
 		fprintf(stderr, "Failed to get direction on pin %d\n", gpio);
 		return "error";
 	}
-	read(fd, &firstCharOfDir, 1);
-	close(fd);
 
 	if (firstCharOfDir == OUT_DIR[0]) {
 		return OUT_DIR;
@@ -160,30 +199,65 @@ char * bbGpioGetDir(unsigned int gpio) {
 }
 
 bool bbGpioGetValue(unsigned int gpio) {
-	int fd;
-	char buff[BUFF_SIZE];
 	char val;
 
-	snprintf(buff, sizeof(buff), SYSFS_GPIO "/gpio%d/value", gpio);
-
-	fd = open(buff, O_RDONLY);
-
-	if (fd < 0) {
+	if (attrReadFirst(gpio, ATTR_VALUE, &val) != 0) {
 		fprintf(stderr, "Failed to get value on pin %d\n", gpio);
 		return -1;
 	}
-	read(fd, &val, 1);
-	close(fd);
+	return val == '1';
+}
+
+int bbGpioPinOpen(bbGpioPin_t *pin, unsigned int gpio) {
+	pin->gpio = gpio;
+	pin->bank = NULL;
+	pin->mask = 1u << (gpio % 32);
+	if (bbGpioMmapReady() && gpio < BB_GPIO_MAX) {
+		pin->bank = bbGpioMmapBank(gpio / 32);
+		pin->fd = -1;
+		return 0;
+	}
+	pin->fd = attrFd(gpio, ATTR_VALUE);
+	if (pin->fd < 0) {
+		fprintf(stderr, "GPIO %u might not be exported\n", gpio);
+		return -1;
+	}
+	return 0;
+}
 
+int bbGpioPinSet(const bbGpioPin_t *pin, bool val) {
+	if (pin->bank) {
+		pin->bank[(val ? BB_GPIO_SETDATAOUT : BB_GPIO_CLEARDATAOUT) / sizeof(uint32_t)] = pin->mask;
+		return 0;
+	}
+	return pwrite(pin->fd, val ? "1" : "0", 1, 0) == 1 ? 0 : -1;
+}
+
+int bbGpioPinGet(const bbGpioPin_t *pin) {
+	char val;
+	if (pin->bank) return (pin->bank[BB_GPIO_DATAIN / sizeof(uint32_t)] & pin->mask) != 0;
+	if (pread(pin->fd, &val, 1, 0) != 1) return -1;
 	return val == '1';
 }
 
+void bbGpioCloseAll() {
+	int gpio, attr;
+	pthread_mutex_lock(&attrLock);
+	for (gpio = 0; gpio < BB_GPIO_MAX; gpio++) {
+		for (attr = 0; attr < NUM_ATTRS; attr++) {
+			if (attrFds[gpio][attr]) close(attrFds[gpio][attr] - 1);
+			attrFds[gpio][attr] = 0;
+		}
+	}
+	pthread_mutex_unlock(&attrLock);
+}
+
 int bbGpioFdOpen(unsigned int gpio) {
 	int fd;
 
 	/* add a validate function */
 	char buf[BUFF_SIZE];
-	snprintf(buf, sizeof(buf), SYSFS_GPIO "/gpio%d/value", gpio);
+	snprintf(buf, sizeof(buf), "%s/gpio%d/value", sysfsRoot, gpio);
 
 	fd = open(buf, O_RDONLY | O_NONBLOCK);
 	if (fd < 0) {
@@ -0,0 +1,99 @@
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <bbgpio.h>
+
+/* AM335x TRM, chapter 2 (memory map) and 25.4 (GPIO registers) */
+#define BANK_SIZE   0x1000
+static const off_t bankAddrs[BB_GPIO_BANKS] = { 0x44E07000, 0x4804C000, 0x481AC000, 0x481AE000 };
+
+static volatile uint32_t *banks[BB_GPIO_BANKS];
+static void *mockMap = NULL;
+
+#define REG(bank, off)  (banks[bank][(off) / sizeof(uint32_t)])
+
+int bbGpioMmapInit() {
+    int fd, i;
+
+    if (bbGpioMmapReady()) return 0;
+    fd = open("/dev/mem", O_RDWR | O_SYNC | O_CLOEXEC);
+    if (fd < 0) {
+        fprintf(stderr, "Failed to open /dev/mem: %s\n", strerror(errno));
+        return -1;
+    }
+    for (i = 0; i < BB_GPIO_BANKS; i++) {
+        void *map = mmap(NULL, BANK_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, bankAddrs[i]);
+        if (map == MAP_FAILED) {
+            fprintf(stderr, "Failed to map GPIO bank %d: %s\n", i, strerror(errno));
+            close(fd);
+            bbGpioMmapRelease();
+            return -1;
+        }
+        banks[i] = (volatile uint32_t *) map;
+    }
+    /* The mappings outlive the fd */
+    close(fd);
+    return 0;
+}
+
+int bbGpioMmapInitMock() {
+    int i;
+
+    if (bbGpioMmapReady()) return 0;
+    mockMap = mmap(NULL, BANK_SIZE * BB_GPIO_BANKS, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mockMap == MAP_FAILED) {
+        mockMap = NULL;
+        fprintf(stderr, "Failed to map mock GPIO banks\n");
+        return -1;
+    }
+    for (i = 0; i < BB_GPIO_BANKS; i++) {
+        banks[i] = (volatile uint32_t *) ((char *) mockMap + i * BANK_SIZE);
+        /* Everything is an input out of reset */
+        REG(i, BB_GPIO_OE) = 0xFFFFFFFF;
+    }
+    return 0;
+}
+
+void bbGpioMmapRelease() {
+    int i;
+    if (mockMap) {
+        munmap(mockMap, BANK_SIZE * BB_GPIO_BANKS);
+        mockMap = NULL;
+    } else {
+        for (i = 0; i < BB_GPIO_BANKS; i++) {
+            if (banks[i]) munmap((void *) banks[i], BANK_SIZE);
+        }
+    }
+    memset((void *) banks, 0, sizeof(banks));
+}
+
+bool bbGpioMmapReady() {
+    return banks[0] != NULL;
+}
+
+volatile uint32_t *bbGpioMmapBank(unsigned int bank) {
+    return bank < BB_GPIO_BANKS ? banks[bank] : NULL;
+}
+
+void bbGpioMmapSet(unsigned int gpio, bool val) {
+    /* SET and CLEAR only touch the bits written as 1, no read-modify-write */
+    REG(gpio / 32, val ? BB_GPIO_SETDATAOUT : BB_GPIO_CLEARDATAOUT) = 1u << (gpio % 32);
+}
+
+bool bbGpioMmapGet(unsigned int gpio) {
+    return (REG(gpio / 32, BB_GPIO_DATAIN) >> (gpio % 32)) & 1;
+}
+
+uint32_t bbGpioMmapReadBank(unsigned int bank) {
+    return REG(bank, BB_GPIO_DATAIN);
+}
+
+void bbGpioMmapSetDir(unsigned int gpio, bool output) {
+    uint32_t mask = 1u << (gpio % 32);
+    if (output) REG(gpio / 32, BB_GPIO_OE) &= ~mask;
+    else REG(gpio / 32, BB_GPIO_OE) |= mask;
+}
@@ -1,3 +1,4 @@
+#define _GNU_SOURCE     /* recvmmsg/sendmmsg */
 #include <linux/can.h>
 #include <net/if.h>
 #include <sys/ioctl.h>
@@ -11,6 +12,12 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h> 
+#include <poll.h>
+#include <errno.h>
+#include <time.h>
+
+/* Room for the SO_TIMESTAMPNS control message on every received frame */
+#define CAN_CMSG_SIZE CMSG_SPACE(sizeof(struct timespec))
 
 
 static struct sockaddr_can addr;
@@ -19,6 +26,15 @@ static struct ifreq ifr;  // Used to look at flags on the network interface
 volatile bool NEW_CAN_MESSAGE = false;
 
 static int can_sock;
+static bool canOpen = false;
+
+/* Kernel side RX filters, see canSetFilters() */
+static const struct can_filter *rxFilters = NULL;
+static int numRxFilters = 0;
+
+/* Frames handed to us vs. everything the interface saw since initCan() */
+static uint64_t framesDelivered = 0;
+static uint64_t ifaceRxBase = 0;
 static const struct itimerval new_val = {
     {0, 10000},
     {0, 10000}
@@ -44,6 +60,17 @@ static int init_can_connection(int *s) {
     addr.can_ifindex = ifr.ifr_ifindex;
 
     bind(*s, (struct sockaddr *)&addr, sizeof(addr));
+
+    if (numRxFilters > 0 && setsockopt(*s, SOL_CAN_RAW, CAN_RAW_FILTER, rxFilters,
+                numRxFilters * sizeof(struct can_filter)) != 0) {
+        fprintf(stderr, "Failed to install CAN rx filters\n\r");
+    }
+
+    /* Have the kernel stamp every frame, batched reads rely on it */
+    int enable = 1;
+    if (setsockopt(*s, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable)) != 0) {
+        fprintf(stderr, "Failed to enable CAN rx timestamps\n\r");
+    }
     return 0;
 }
 
@@ -56,15 +83,157 @@ static int init_can_timer(const struct itimerval *new, struct itimerval *old) {
     return 0;
 }
 
+/* Total frames the interface has received, filtered or not */
+static uint64_t readIfaceRxPackets() {
+    char path[64];
+    unsigned long long val = 0;
+    snprintf(path, sizeof(path), "/sys/class/net/%s/statistics/rx_packets", CAN_INTF);
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL) return 0;
+    if (fscanf(fp, "%llu", &val) != 1) val = 0;
+    fclose(fp);
+    return val;
+}
+
+int canSetFilters(const struct can_filter *filters, int numFilters) {
+    rxFilters = filters;
+    numRxFilters = numFilters;
+    if (!canOpen) return 0;   /* init_can_connection() will pick them up */
+
+    if (setsockopt(can_sock, SOL_CAN_RAW, CAN_RAW_FILTER, filters,
+                numFilters * sizeof(struct can_filter)) != 0) {
+        fprintf(stderr, "Failed to install CAN rx filters\n\r");
+        return 1;
+    }
+    return 0;
+}
+
+void canGetRxStats(uint64_t *delivered, uint64_t *filtered) {
+    uint64_t total = readIfaceRxPackets() - ifaceRxBase;
+    *delivered = framesDelivered;
+    *filtered = total > framesDelivered ? total - framesDelivered : 0;
+}
+
 inline int canRead(struct can_frame *recvd_msg) {
     int nBytes = recv(can_sock, recvd_msg, sizeof(struct can_frame), MSG_DONTWAIT);
     /* This is actually ok if it fails here, it just means no new info */
     if (nBytes < 0) {
         return 1;
     }
+    framesDelivered++;
     return 0;
 }
 
+int canWait(int timeoutMs) {
+    struct pollfd pfd;
+    pfd.fd = can_sock;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    int ret = poll(&pfd, 1, timeoutMs);
+    if (ret < 0) {
+        /* The read timer's SIGALRM lands here regularly, not an actual error */
+        if (errno == EINTR) return 0;
+        return -1;
+    }
+    if (ret > 0 && (pfd.revents & POLLIN)) return 1;
+    /* These come back straight away every time, so they're not a timeout */
+    if (ret > 0 && (pfd.revents & (POLLERR | POLLHUP | POLLNVAL))) return -1;
+    return 0;
+}
+
+int canReopen() {
+    int s;
+    if (init_can_connection(&s)) {
+        if (s >= 0) close(s);
+        return 1;
+    }
+    /* Swap it in under the same fd, so threads sending right now never see a
+     * closed one */
+    if (dup2(s, can_sock) < 0) {
+        close(s);
+        return 1;
+    }
+    close(s);
+    return 0;
+}
+
+
+static inline uint64_t tsToUs(struct timespec *ts) {
+    return (uint64_t) ts->tv_sec * 1000000 + ts->tv_nsec / 1000;
+}
+
+/* SO_TIMESTAMPNS reports CLOCK_REALTIME, shift it onto CLOCK_MONOTONIC so it
+ * can be compared against the rest of the pods timers */
+static uint64_t kernelToMonotonic(struct msghdr *msg, uint64_t nowMono, uint64_t nowReal) {
+    struct cmsghdr *cmsg;
+    for (cmsg = CMSG_FIRSTHDR(msg); cmsg != NULL; cmsg = CMSG_NXTHDR(msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_TIMESTAMPNS) {
+            struct timespec ts;
+            memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+            uint64_t age = nowReal - tsToUs(&ts);
+            return age > nowMono ? nowMono : nowMono - age;
+        }
+    }
+    return nowMono;    /* No stamp, best we can do is now */
+}
+
+int canReadBatch(canFrameTs_t *frames, int maxFrames) {
+    struct mmsghdr msgs[CAN_BATCH_SIZE];
+    struct iovec iovs[CAN_BATCH_SIZE];
+    char cmsgBufs[CAN_BATCH_SIZE][CAN_CMSG_SIZE];
+    struct timespec mono, real;
+    int i, n;
+
+    if (maxFrames > CAN_BATCH_SIZE) maxFrames = CAN_BATCH_SIZE;
+    if (maxFrames <= 0) return 0;
+
+    memset(msgs, 0, sizeof(struct mmsghdr) * maxFrames);
+    for (i = 0; i < maxFrames; i++) {
+        iovs[i].iov_base = &frames[i].frame;
+        iovs[i].iov_len = sizeof(struct can_frame);
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        msgs[i].msg_hdr.msg_control = cmsgBufs[i];
+        msgs[i].msg_hdr.msg_controllen = CAN_CMSG_SIZE;
+    }
+
+    n = recvmmsg(can_sock, msgs, maxFrames, MSG_DONTWAIT, NULL);
+    /* Same as canRead, nothing pending is not an error */
+    if (n <= 0) return 0;
+    framesDelivered += n;
+
+    clock_gettime(CLOCK_MONOTONIC, &mono);
+    clock_gettime(CLOCK_REALTIME, &real);
+    for (i = 0; i < n; i++) {
+        frames[i].rxTime = kernelToMonotonic(&msgs[i].msg_hdr, tsToUs(&mono), tsToUs(&real));
+    }
+    return n;
+}
+
+int canSendBatch(struct can_frame *frames, int numFrames) {
+    struct mmsghdr msgs[CAN_BATCH_SIZE];
+    struct iovec iovs[CAN_BATCH_SIZE];
+    int sent = 0;
+
+    while (sent < numFrames) {
+        int i, n, chunk = numFrames - sent;
+        if (chunk > CAN_BATCH_SIZE) chunk = CAN_BATCH_SIZE;
+
+        memset(msgs, 0, sizeof(struct mmsghdr) * chunk);
+        for (i = 0; i < chunk; i++) {
+            iovs[i].iov_base = &frames[sent + i];
+            iovs[i].iov_len = sizeof(struct can_frame);
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        n = sendmmsg(can_sock, msgs, chunk, MSG_DONTWAIT);
+        if (n <= 0) break;  /* TX queue is full, let the caller decide */
+        sent += n;
+    }
+    return sent;
+}
+
 
 inline int canSend(uint32_t id, uint8_t *data, uint8_t size) {
     struct can_frame tx_msg;
@@ -75,9 +244,11 @@ inline int canSend(uint32_t id, uint8_t *data, uint8_t size) {
     for(i = 0; i < size; i++) {
         tx_msg.data[i] = data[i];
     }
-    send(can_sock, &tx_msg, sizeof(struct can_frame), MSG_DONTWAIT);
-
-    return 0;   // Not much we do with error codes here
+    /* -1 if the TX queue is full or the bus is down */
+    if (send(can_sock, &tx_msg, sizeof(struct can_frame), MSG_DONTWAIT) != sizeof(struct can_frame)) {
+        return -1;
+    }
+    return 0;
 }
 
 
@@ -86,6 +257,8 @@ int initCan() {
         fprintf(stderr, "Failed to init\n\r");
         return 1;
     }
+    canOpen = true;
+    ifaceRxBase = readIfaceRxPackets();
     if (init_can_timer(&new_val, NULL)) {
         fprintf(stderr, "Failed to set read timer\n\r");
         return 1;
@@ -0,0 +1,113 @@
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/gpio.h>
+#include <gpiochip.h>
+
+#define GPIOCHIP_DEV    "/dev/gpiochip%u"
+#define NS_TO_US(x)     ((x) / 1000)
+
+void gpioChipLine(unsigned int gpio, unsigned int *chip, unsigned int *offset) {
+    *chip = gpio / 32;
+    *offset = gpio % 32;
+}
+
+#ifdef GPIO_V2_GET_LINE_IOCTL
+
+bool gpioEventsSupported() {
+    return true;
+}
+
+int gpioRequestEdges(unsigned int chip, const unsigned int *offsets, int numLines,
+        int edges, const char *consumer) {
+    struct gpio_v2_line_request req;
+    char path[32];
+    int chipFd, i;
+
+    if (numLines <= 0 || numLines > GPIO_V2_LINES_MAX) {
+        fprintf(stderr, "Can't request %d GPIO lines at once\n", numLines);
+        return -1;
+    }
+
+    snprintf(path, sizeof(path), GPIOCHIP_DEV, chip);
+    chipFd = open(path, O_RDONLY | O_CLOEXEC);
+    if (chipFd < 0) {
+        fprintf(stderr, "Failed to open %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    memset(&req, 0, sizeof(req));
+    for (i = 0; i < numLines; i++) req.offsets[i] = offsets[i];
+    req.num_lines = numLines;
+    req.event_buffer_size = GPIO_EVENT_BUF;
+    strncpy(req.consumer, consumer, sizeof(req.consumer) - 1);
+    req.config.flags = GPIO_V2_LINE_FLAG_INPUT;
+    if (edges & GPIO_EDGE_RISING) req.config.flags |= GPIO_V2_LINE_FLAG_EDGE_RISING;
+    if (edges & GPIO_EDGE_FALLING) req.config.flags |= GPIO_V2_LINE_FLAG_EDGE_FALLING;
+
+    if (ioctl(chipFd, GPIO_V2_GET_LINE_IOCTL, &req) < 0) {
+        fprintf(stderr, "Failed to request edges on %s: %s\n", path, strerror(errno));
+        close(chipFd);
+        return -1;
+    }
+    /* The line fd stays valid on its own */
+    close(chipFd);
+    return req.fd;
+}
+
+int gpioReadEvents(int fd, gpioEvent_t *ev, int max, int timeoutMs) {
+    struct gpio_v2_line_event raw[GPIO_EVENT_BUF];
+    struct pollfd pfd;
+    ssize_t len;
+    int ret, n, i;
+
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    ret = poll(&pfd, 1, timeoutMs);
+    if (ret <= 0) return ret < 0 && errno != EINTR ? -1 : 0;
+
+    if (max > GPIO_EVENT_BUF) max = GPIO_EVENT_BUF;
+    len = read(fd, raw, max * sizeof(raw[0]));
+    if (len < 0) return errno == EAGAIN || errno == EINTR ? 0 : -1;
+    /* Readable with nothing to read, the other end is gone */
+    if (len == 0) return -1;
+
+    /* The kernel only ever hands back whole events */
+    n = len / sizeof(raw[0]);
+    for (i = 0; i < n; i++) {
+        ev[i].time = NS_TO_US(raw[i].timestamp_ns);
+        ev[i].offset = raw[i].offset;
+        ev[i].rising = raw[i].id == GPIO_V2_LINE_EVENT_RISING_EDGE;
+        ev[i].seqno = raw[i].seqno;
+    }
+    return n;
+}
+
+#else
+
+bool gpioEventsSupported() {
+    return false;
+}
+
+int gpioRequestEdges(unsigned int chip, const unsigned int *offsets, int numLines,
+        int edges, const char *consumer) {
+    (void) chip; (void) offsets; (void) numLines; (void) edges; (void) consumer;
+    fprintf(stderr, "Built without GPIO v2 uAPI headers, no edge events\n");
+    return -1;
+}
+
+int gpioReadEvents(int fd, gpioEvent_t *ev, int max, int timeoutMs) {
+    (void) fd; (void) ev; (void) max; (void) timeoutMs;
+    return -1;
+}
+
+#endif
+
+int gpioRelease(int fd) {
+    return close(fd);
+}
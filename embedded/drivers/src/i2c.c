@@ -4,28 +4,251 @@
 * Based on work by: gijs
 */
 
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
 #include "i2c.h"
 
-int i2c_begin(i2c_settings *i2c) {
+#define MAX_BLOCK       32
+#define MAX_ADDRESS     128
+
+typedef struct i2cWaiter_t {
+	struct i2cWaiter_t *next;
+	bool granted;
+} i2cWaiter_t;
+
+typedef struct i2cDev_t {
+	int priority;
+	i2cStats_t stats;
+} i2cDev_t;
+
+/* Everything about one bus, only touched with lock held */
+typedef struct i2cBus_t {
+	pthread_mutex_t lock;
+	pthread_cond_t turn;
+	int fd;
+	bool fake;              /* fd is a stand in from i2cUseFd() */
+	bool plain;             /* No I2C_RDWR, so write() and read() after I2C_SLAVE */
+	int slaveAddress;       /* What I2C_SLAVE was last set to */
+	bool busy;              /* Someone is on the bus */
+	i2cWaiter_t *head[I2C_NUM_PRIOS];
+	i2cWaiter_t *tail[I2C_NUM_PRIOS];
+	i2cDev_t devs[MAX_ADDRESS];
+} i2cBus_t;
+
+static i2cBus_t buses[I2C_MAX_BUSES];
+static pthread_once_t busesOnce = PTHREAD_ONCE_INIT;
+static unsigned long transactions = 0;
+
+static void initBuses(void) {
+	int i;
+	for (i = 0; i < I2C_MAX_BUSES; i++) {
+		pthread_mutex_init(&buses[i].lock, NULL);
+		pthread_cond_init(&buses[i].turn, NULL);
+		buses[i].fd = -1;
+		buses[i].slaveAddress = -1;
+	}
+}
+
+static i2cBus_t *getBus(int bus) {
+	pthread_once(&busesOnce, initBuses);
+	if (bus < 0 || bus >= I2C_MAX_BUSES) {
+		fprintf(stderr, "No I2C bus %d\n", bus);
+		return NULL;
+	}
+	return &buses[bus];
+}
+
+static uint64_t nowUs(void) {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (uint64_t) t.tv_sec * 1000000 + t.tv_nsec / 1000;
+}
+
+unsigned long i2cTransactionCount() {
+	return __atomic_load_n(&transactions, __ATOMIC_RELAXED);
+}
+
+void i2cUseFd(int bus, int fd) {
+	i2cBus_t *b = getBus(bus);
+	if (b == NULL) return;
+	pthread_mutex_lock(&b->lock);
+	if (b->fd >= 0) close(b->fd);
+	b->fd = fd < 0 ? -1 : dup(fd);
+	b->fake = fd >= 0;
+	b->plain = fd >= 0;
+	b->slaveAddress = -1;
+	pthread_mutex_unlock(&b->lock);
+}
+
+/* Call with the bus lock held. Left closed if it fails, so the next
+ * i2c_begin() tries again */
+static void openBus(i2cBus_t *b, int bus, int openMode) {
 	char filename[20];
-	sprintf(filename, "/dev/i2c-%d", i2c->bus);
-	i2c->fd = open(filename, i2c->openMode);
-	if (i2c->fd < 0) {
+	unsigned long funcs = 0;
+
+	sprintf(filename, "/dev/i2c-%d", bus);
+	b->fd = open(filename, openMode);
+	if (b->fd < 0) {
 		fprintf(stderr, "Error - Could not open file\n");
-		// Commenting out the returns allows the tests to proceed on my laptop where I do not have an I2C driver
-		// return -1; // Uncomment this when doing Bone Dev - EU
+		return;
+	}
+	b->plain = ioctl(b->fd, I2C_FUNCS, &funcs) < 0 || !(funcs & I2C_FUNC_I2C);
+	b->slaveAddress = -1;
+}
+
+int i2c_begin(i2c_settings *i2c) {
+	i2cBus_t *b = getBus(i2c->bus);
+	if (b == NULL) return -1;
+	pthread_mutex_lock(&b->lock);
+	if (b->fd < 0 && !b->fake) openBus(b, i2c->bus, i2c->openMode);
+	i2c->fd = b->fd;
+	pthread_mutex_unlock(&b->lock);
+	/* Like before, carry on without a bus so the tests still run on a laptop.
+	 * Every transfer fails instead */
+	return 0;
+}
+
+int i2cSetPriority(i2c_settings *i2c, int priority) {
+	i2cBus_t *b = getBus(i2c->bus);
+	if (b == NULL || priority < 0 || priority >= I2C_NUM_PRIOS) return -1;
+	pthread_mutex_lock(&b->lock);
+	b->devs[i2c->deviceAddress & (MAX_ADDRESS - 1)].priority = priority;
+	pthread_mutex_unlock(&b->lock);
+	return 0;
+}
+
+int i2cGetStats(i2c_settings *i2c, i2cStats_t *stats) {
+	i2cBus_t *b = getBus(i2c->bus);
+	if (b == NULL) return -1;
+	pthread_mutex_lock(&b->lock);
+	*stats = b->devs[i2c->deviceAddress & (MAX_ADDRESS - 1)].stats;
+	pthread_mutex_unlock(&b->lock);
+	return 0;
+}
+
+void i2cResetStats(i2c_settings *i2c) {
+	i2cBus_t *b = getBus(i2c->bus);
+	if (b == NULL) return;
+	pthread_mutex_lock(&b->lock);
+	memset(&b->devs[i2c->deviceAddress & (MAX_ADDRESS - 1)].stats, 0, sizeof(i2cStats_t));
+	pthread_mutex_unlock(&b->lock);
+}
+
+/* Waits for the bus. Whoever gives it up hands it straight to the oldest
+ * waiter of the highest priority, so a safety read never queues behind
+ * more than the one transfer already going */
+static void acquire(i2cBus_t *b, int prio) {
+	i2cWaiter_t me = { NULL, false };
+	pthread_mutex_lock(&b->lock);
+	if (!b->busy) {
+		b->busy = true;
+	} else {
+		if (b->tail[prio]) b->tail[prio]->next = &me;
+		else b->head[prio] = &me;
+		b->tail[prio] = &me;
+		while (!me.granted) pthread_cond_wait(&b->turn, &b->lock);
+	}
+	pthread_mutex_unlock(&b->lock);
+}
+
+/* Call with the bus lock held */
+static void release(i2cBus_t *b) {
+	i2cWaiter_t *next;
+	int p;
+	for (p = I2C_NUM_PRIOS - 1; p >= 0; p--) {
+		next = b->head[p];
+		if (next == NULL) continue;
+		b->head[p] = next->next;
+		if (b->head[p] == NULL) b->tail[p] = NULL;
+		next->granted = true;
+		pthread_cond_broadcast(&b->turn);
+		return;
 	}
+	b->busy = false;
+}
 
-	if (ioctl(i2c->fd, I2C_SLAVE, i2c->deviceAddress) < 0) {
-		fprintf(stderr, "Error - Could not set I2C Address\n");
-		// return -1; // Uncomment this when doing Bone Dev - EU
+/* Without I2C_RDWR every message is its own write() or read(), with a stop
+ * in between. Still atomic as far as other users of the bus can tell */
+static int transferPlain(i2cBus_t *b, int address, struct i2c_msg *msgs, int numMsgs) {
+	int i, n;
+	if (!b->fake && address != b->slaveAddress) {
+		if (ioctl(b->fd, I2C_SLAVE, address) < 0) return -1;
+		b->slaveAddress = address;
+	}
+	for (i = 0; i < numMsgs; i++) {
+		if (msgs[i].flags & I2C_M_RD) n = read(b->fd, msgs[i].buf, msgs[i].len);
+		else n = write(b->fd, msgs[i].buf, msgs[i].len);
+		if (n != msgs[i].len) return -1;
 	}
 	return 0;
 }
 
+int i2cTransfer(i2c_settings *i2c, struct i2c_msg *msgs, int numMsgs) {
+	return i2cTransferTimed(i2c, msgs, numMsgs, NULL, NULL);
+}
+
+int i2cTransferTimed(i2c_settings *i2c, struct i2c_msg *msgs, int numMsgs,
+		uint64_t *startTime, uint64_t *endTime) {
+	struct i2c_rdwr_ioctl_data rdwr = { msgs, numMsgs };
+	i2cBus_t *b = getBus(i2c->bus);
+	i2cDev_t *dev;
+	uint64_t queued, started, done;
+	int i, ret, prio;
+
+	if (b == NULL || numMsgs < 1 || numMsgs > I2C_MAX_MSGS) return -1;
+	for (i = 0; i < numMsgs; i++) msgs[i].addr = i2c->deviceAddress;
+	dev = &b->devs[i2c->deviceAddress & (MAX_ADDRESS - 1)];
+	prio = __atomic_load_n(&dev->priority, __ATOMIC_RELAXED);
+
+	queued = nowUs();
+	acquire(b, prio);
+	started = nowUs();
+	if (b->fd < 0) {
+		ret = -1;
+	} else if (b->plain) {
+		ret = transferPlain(b, i2c->deviceAddress, msgs, numMsgs);
+	} else {
+		ret = ioctl(b->fd, I2C_RDWR, &rdwr) == numMsgs ? 0 : -1;
+	}
+	done = nowUs();
+	__atomic_fetch_add(&transactions, 1, __ATOMIC_RELAXED);
+
+	pthread_mutex_lock(&b->lock);
+	dev->stats.count++;
+	if (ret != 0) dev->stats.errors++;
+	dev->stats.waitTotal += started - queued;
+	if (started - queued > dev->stats.waitMax) dev->stats.waitMax = started - queued;
+	dev->stats.xferTotal += done - started;
+	if (done - started > dev->stats.xferMax) dev->stats.xferMax = done - started;
+	release(b);
+	pthread_mutex_unlock(&b->lock);
+	if (startTime) *startTime = started;
+	if (endTime) *endTime = done;
+	return ret;
+}
+
+int write_read_i2c(i2c_settings *i2c, const unsigned char *writeBuffer, int writeSize,
+		unsigned char *readBuffer, int readSize) {
+	struct i2c_msg msgs[2] = {
+		{ 0, 0, writeSize, (char *) writeBuffer },
+		{ 0, I2C_M_RD, readSize, (char *) readBuffer }
+	};
+	if (i2cTransfer(i2c, msgs, 2) != 0) {
+		fprintf(stderr, "I2C write then read error\n");
+		return 1;
+	}
+	return 0;
+}
+
+static int writeBuf(i2c_settings *i2c, unsigned char *buf, int len) {
+	struct i2c_msg msg = { 0, 0, len, (char *) buf };
+	return i2cTransfer(i2c, &msg, 1);
+}
+
 int write_byte_i2c(i2c_settings *i2c, unsigned char reg) {
-	int response = i2c_smbus_write_byte(i2c->fd, reg);
-	if (response < 0) {
+	if (writeBuf(i2c, &reg, 1) != 0) {
 		fprintf(stderr, "I2C write byte error\n");
 		return 1;
 	}
@@ -36,15 +259,31 @@ int write_data_i2c(i2c_settings *i2c, unsigned char reg, char value) {
 	unsigned char buf[2];
 	buf[0] = reg;
 	buf[1] = value;
-	if (write(i2c->fd, buf, 2) != 2) {
+	if (writeBuf(i2c, buf, 2) != 0) {
 		fprintf(stderr, "I2C write data error\n");
 		return 1;
 	}
 	return 0;
 }
 
+int write_block_i2c(i2c_settings *i2c, unsigned char reg, const unsigned char *values, int len) {
+	unsigned char buf[MAX_BLOCK + 1];
+	if (len < 0 || len > MAX_BLOCK) {
+		fprintf(stderr, "I2C block write of %d bytes is too long\n", len);
+		return 1;
+	}
+	buf[0] = reg;
+	memcpy(buf + 1, values, len);
+	if (writeBuf(i2c, buf, len + 1) != 0) {
+		fprintf(stderr, "I2C write block error\n");
+		return 1;
+	}
+	return 0;
+}
+
 int read_i2c(i2c_settings *i2c, unsigned char *readBuffer, int bufferSize) {
-	if (read(i2c->fd, readBuffer, bufferSize) != bufferSize) {
+	struct i2c_msg msg = { 0, I2C_M_RD, bufferSize, (char *) readBuffer };
+	if (i2cTransfer(i2c, &msg, 1) != 0) {
 		fprintf(stderr, "I2C data read error\n");
 		return 1;
 	}
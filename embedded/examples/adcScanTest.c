@@ -0,0 +1,88 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+
+#include "data.h"
+#include "i2c.h"
+#include "NCD9830DBR2G.h"
+#include "check.h"
+
+/* Reads the pressure ADC one channel at a time and then with a scan,
+ * against a made up NCD9830 on a socket that answers each channel select
+ * with 0x30 plus the select bits. Checks every channel lands in the right
+ * slot and counts the transactions each way. Times here are the socket's,
+ * not the bus's, on the pod look at what scans print with DEBUG_PRES. */
+
+#define NUM_SCANS   100
+
+
+static uint8_t expected(uint8_t channel) {
+    return 0x30 + channel;
+}
+
+static void *fakeAdc(void *arg) {
+    int fd = *(int *) arg;
+    uint8_t cmd, answer;
+    while (recv(fd, &cmd, 1, 0) == 1) {
+        /* C2 C1 C0 are bits 6-4 of the command */
+        answer = expected((cmd >> 4) & 0x7);
+        send(fd, &answer, 1, 0);
+    }
+    return NULL;
+}
+
+int main() {
+    pthread_t adcThread;
+    ncdScan_t scan;
+    uint8_t data[2];
+    unsigned long start;
+    uint64_t worst = 0, total = 0, before, after;
+    int sv[2], ch, i, ok = 1;
+
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv) != 0) {
+        perror("adcScanTest");
+        return -1;
+    }
+    i2cUseFd(2, sv[0]);
+    pthread_create(&adcThread, NULL, fakeAdc, &sv[1]);
+    CHECK("init", initPressureSensors() == 0);
+
+    start = i2cTransactionCount();
+    for (ch = 0; ch < NCD_NUM_CHANNELS; ch++) {
+        if (readPressureSensor(ADC_0, ch, data) != 0 || data[0] != expected(ch)) ok = 0;
+    }
+    CHECK("one at a time", ok);
+    printf("one at a time: %lu transactions\n", i2cTransactionCount() - start);
+
+    start = i2cTransactionCount();
+    before = getuSTimestamp();
+    CHECK("scan", scanPressureSensor(ADC_0, &scan) == 0);
+    after = getuSTimestamp();
+    printf("scan: %lu transactions\n", i2cTransactionCount() - start);
+    for (ch = 0, ok = 1; ch < NCD_NUM_CHANNELS; ch++) {
+        if (scan.raw[ch] != expected(ch)) ok = 0;
+    }
+    CHECK("scan channels", ok);
+    CHECK("scan stamped while it ran", scan.time >= before && scan.time <= after &&
+            scan.duration <= after - before);
+
+    for (i = 0; i < NUM_SCANS; i++) {
+        if (scanPressureSensor(ADC_0, &scan) != 0) break;
+        total += scan.duration;
+        if (scan.duration > worst) worst = scan.duration;
+    }
+    CHECK("every scan", i == NUM_SCANS);
+    printf("%d scans, %.1f uS avg, %llu uS worst\n", i, i ? (double) total / i : 0,
+            (unsigned long long) worst);
+
+    i2cUseFd(2, -1);
+    close(sv[0]);
+    shutdown(sv[1], SHUT_RDWR);
+    pthread_join(adcThread, NULL);
+    close(sv[1]);
+
+    return checkResult();
+}
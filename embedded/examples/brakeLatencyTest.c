@@ -0,0 +1,87 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "data.h"
+#include "i2c.h"
+#include "mcp23017.h"
+#include "NCD9830DBR2G.h"
+#include "braking.h"
+#include "lv_iox.h"
+#include "check.h"
+#include "fakeMcp.h"
+
+/* How long from asking for the brakes to the solenoid write reaching the LV
+ * expander, while the pressure sampler keeps scanning the ADC on the same
+ * bus. Both chips are faked on one socket: ADC channel selects have the top
+ * bit set, expander register numbers don't. Each ADC read takes
+ * ADC_READ_US, so a scan holds the bus about as long as it does at 100 kHz.
+ * The brakes can still wait for a scan already on the bus, but never for
+ * the sampler's sleep, which used to hold bigSem for up to 20 mS. */
+
+#define ADC_READ_US     400
+#define NUM_BRAKES      40
+#define MAX_LATENCY_US  10000
+
+
+/* ADC channel selects, the expander has the rest */
+static bool adcRead(fakeMcp_t *dev, uint8_t cmd) {
+    uint8_t answer;
+    if (!(cmd & 0x80)) return false;
+    usleep(ADC_READ_US);
+    answer = 0x30 + ((cmd >> 4) & 0x7);
+    send(dev->fd, &answer, 1, 0);
+    return true;
+}
+
+int main() {
+    fakeMcp_t bus;
+    pressure_t p;
+    uint64_t start, written, latency, worst = 0, total = 0;
+    int i, wait, missed = 0;
+
+    initData();
+    if (fakeMcpStart(&bus, 2, adcRead) != 0) return -1;
+
+    CHECK("LV iox", initLVIox(true) == 0);
+    CHECK("pressure monitor", initPressureMonitor() == 0);
+    usleep(200000);
+
+    srand(1);
+    for (i = 0; i < NUM_BRAKES; i++) {
+        /* Land anywhere in the sampler's period */
+        usleep(rand() % 20000);
+        written = fakeMcpOlatbChanged(&bus);
+        start = getuSTimestamp();
+        /* The solenoids start off, which is already actuated */
+        if (i & 1) brakePrimaryActuate();
+        else brakePrimaryUnactuate();
+        /* Writes aren't answered, so give the fake a moment to see it */
+        for (wait = 0; wait < 1000; wait++) {
+            latency = fakeMcpOlatbChanged(&bus);
+            if (latency != written) break;
+            usleep(100);
+        }
+        if (latency == written) {
+            missed++;
+            continue;
+        }
+        latency -= start;
+        total += latency;
+        if (latency > worst) worst = latency;
+    }
+    printf("%d brake commands, to first solenoid write avg %.0f uS, worst %llu uS\n",
+            NUM_BRAKES, (double) total / (NUM_BRAKES - missed), (unsigned long long) worst);
+    CHECK("every command wrote", missed == 0);
+    CHECK("never waited on the sampler's sleep", worst < MAX_LATENCY_US);
+
+    /* And the pipeline behind it still works */
+    seqRead(&data->pressure->lock, &p, data->pressure, sizeof(p));
+    printf("primary tank %.1f psi, %llu scans dropped\n", p.primTank,
+            (unsigned long long) getPressureScansDropped());
+    CHECK("pressure published", p.primTank > 0);
+    CHECK("monitor keeps up", getPressureScansDropped() == 0);
+
+    return checkResult();
+}
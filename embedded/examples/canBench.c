@@ -0,0 +1,196 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "can.h"
+#include "data.h"
+
+/* Floods the bus from a second raw socket and measures how quickly the
+ * blocking receive path in can.c picks frames back up. Meant for vcan0,
+ * build with `make examples VIRTUAL=1` and run ./embedded/utils/setupCAN.sh first
+ *
+ * Run with -b to receive with canReadBatch() instead of one canRead() per
+ * frame, then compare TX cost of canSend() against canSendBatch()
+ *
+ * Latency is to when the receiver woke up and had the frame in both modes.
+ * Batched reads also report it to the kernel's receive stamp */
+
+#define BENCH_ID        0x7AA
+#define NUM_FRAMES      100000
+#define BURST_SIZE      32
+#define BURST_DELAY_US  200
+
+static int openTxSocket() {
+    struct sockaddr_can addr;
+    struct ifreq ifr;
+    int s = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+    if (s < 0) return -1;
+
+    strcpy(ifr.ifr_name, CAN_INTF);
+    if (ioctl(s, SIOCGIFINDEX, &ifr) == -1) {
+        close(s);
+        return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.can_family = AF_CAN;
+    addr.can_ifindex = ifr.ifr_ifindex;
+    if (bind(s, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(s);
+        return -1;
+    }
+    return s;
+}
+
+/* Stamps each frame with the time it was handed to the kernel */
+static void *txLoop(void *arg) {
+    int s = (int)(intptr_t) arg;
+    struct can_frame frame;
+    uint64_t ts;
+    int i;
+
+    frame.can_id = BENCH_ID;
+    frame.can_dlc = sizeof(ts);
+    for (i = 0; i < NUM_FRAMES; i++) {
+        ts = getuSTimestamp();
+        memcpy(frame.data, &ts, sizeof(ts));
+        while (write(s, &frame, sizeof(frame)) != sizeof(frame)) {
+            usleep(BURST_DELAY_US); /* TX queue full, let it drain */
+        }
+        if ((i % BURST_SIZE) == BURST_SIZE - 1) usleep(BURST_DELAY_US);
+    }
+    return NULL;
+}
+
+typedef struct latency_t {
+    uint64_t sum;
+    uint64_t max;
+} latency_t;
+
+/* The kernel stamp is converted from CLOCK_REALTIME and can land a little
+ * before the sender's, that counts as 0 */
+static void addLatency(latency_t *l, uint64_t at, uint64_t sent) {
+    uint64_t lat = at > sent ? at - sent : 0;
+    l->sum += lat;
+    if (lat > l->max) l->max = lat;
+}
+
+static void showLatency(const char *name, const latency_t *l, int received) {
+    printf("%-16s: avg %.2f us, max %llu us\n", name, l->sum / (double) received,
+            (unsigned long long) l->max);
+}
+
+static uint64_t threadCpuUs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return convertTouS(&ts);
+}
+
+/* CPU time spent pushing NUM_FRAMES out of the driver socket, both modes
+ * send the same bursts so the only difference is the syscall count. Frames
+ * the full TX queue turned away still cost CPU but aren't counted */
+static void txBench(bool batched) {
+    struct can_frame frames[BURST_SIZE];
+    uint8_t payload[8] = {0};
+    uint64_t cpu = 0, start;
+    int i, sent = 0;
+
+    for (i = 0; i < BURST_SIZE; i++) {
+        frames[i].can_id = BENCH_ID;
+        frames[i].can_dlc = sizeof(payload);
+        memset(frames[i].data, 0, sizeof(payload));
+    }
+
+    while (sent < NUM_FRAMES) {
+        start = threadCpuUs();
+        if (batched) {
+            sent += canSendBatch(frames, BURST_SIZE);
+        } else {
+            for (i = 0; i < BURST_SIZE; i++) {
+                if (canSend(BENCH_ID, payload, sizeof(payload)) == 0) sent++;
+            }
+        }
+        cpu += threadCpuUs() - start;
+        usleep(BURST_DELAY_US);
+    }
+    printf("TX %-13s: %.3f us CPU/frame\n", batched ? "canSendBatch" : "canSend",
+            cpu / (double) sent);
+}
+
+int main(int argc, char *argv[]) {
+    bool batched = argc > 1 && strcmp(argv[1], "-b") == 0;
+    canFrameTs_t batch[CAN_BATCH_SIZE];
+    struct can_frame frame;
+    pthread_t txThread;
+    uint64_t sent, now, start, end;
+    latency_t wakeLat = {0, 0}, kernelLat = {0, 0};
+    uint64_t delivered, filtered;
+    int received = 0, wakeups = 0, s;
+
+    /* Only the bench traffic, anything else on the bus is left in the kernel */
+    static const struct can_filter benchFilter = { BENCH_ID, CAN_SFF_MASK };
+    canSetFilters(&benchFilter, 1);
+    if (initCan() != 0) {
+        fprintf(stderr, "Failed to init CAN on %s\n", CAN_INTF);
+        return 1;
+    }
+    if ((s = openTxSocket()) < 0) {
+        fprintf(stderr, "Failed to open TX socket on %s\n", CAN_INTF);
+        return 1;
+    }
+
+    printf("---Begin CAN RX benchmark, %d frames, %s---\n", NUM_FRAMES,
+            batched ? "batched" : "single frame");
+    start = getuSTimestamp();
+    pthread_create(&txThread, NULL, txLoop, (void *)(intptr_t) s);
+
+    while (received < NUM_FRAMES) {
+        int ret = canWait(CAN_RX_TIMEOUT_MS * 10);
+        if (ret < 0) break;
+        if (ret == 0) {
+            fprintf(stderr, "Timed out, frames were dropped\n");
+            break;
+        }
+        wakeups++;
+        if (batched) {
+            int n, i;
+            while ((n = canReadBatch(batch, CAN_BATCH_SIZE)) > 0) {
+                now = getuSTimestamp();
+                for (i = 0; i < n; i++) {
+                    if (batch[i].frame.can_id != BENCH_ID) continue;
+                    memcpy(&sent, batch[i].frame.data, sizeof(sent));
+                    addLatency(&wakeLat, now, sent);
+                    addLatency(&kernelLat, batch[i].rxTime, sent);
+                    received++;
+                }
+            }
+        } else {
+            while (!canRead(&frame)) {
+                if (frame.can_id != BENCH_ID) continue;
+                now = getuSTimestamp();
+                memcpy(&sent, frame.data, sizeof(sent));
+                addLatency(&wakeLat, now, sent);
+                received++;
+            }
+        }
+    }
+    end = getuSTimestamp();
+    pthread_join(txThread, NULL);
+    close(s);
+
+    if (received == 0) return 1;
+    printf("Frames received : %d\n", received);
+    printf("Frames/s        : %.0f\n", received / ((end - start) / 1000000.0));
+    printf("Frames/wakeup   : %.2f\n", received / (double) wakeups);
+    showLatency("Latency", &wakeLat, received);
+    if (batched) showLatency("To kernel stamp", &kernelLat, received);
+    canGetRxStats(&delivered, &filtered);
+    printf("Kernel filtered : %llu of %llu\n", (unsigned long long) filtered,
+            (unsigned long long) (filtered + delivered));
+    printf("---End CAN RX benchmark---\n");
+
+    txBench(false);
+    txBench(true);
+    return 0;
+}
@@ -0,0 +1,132 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "data.h"
+#include "bms.h"
+#include "rms.h"
+
+/* Golden vector test for the CAN signal tables in can_signals.h. Each frame
+ * is hand built from the Orion / RMS CAN protocol docs and pushed through
+ * the same parsers the CAN thread uses, then every decoded field is checked.
+ * No CAN hardware needed */
+
+#define TOL 0.001
+
+extern data_t *data;
+extern float cells[72];
+
+static int failures = 0;
+
+#define CHECK(name, got, want) \
+    if (fabs((double) (got) - (double) (want)) > TOL) { \
+        fprintf(stderr, "FAIL %-24s got %f, expected %f\n", name, \
+                (double) (got), (double) (want)); \
+        failures++; \
+    }
+
+static void testBms() {
+    uint8_t f6B0[8] = {0x01, 0x2C, 0x0F, 0xA0, 0xC8, 0x8C, 0xA0, 0x00};
+    uint8_t f150[8] = {0x00, 0x00, 0x00, 0x00, 0x10, 0x27, 0x23, 0x14};
+    uint8_t f652[8] = {0x38, 0xFF, 0x2C, 0x01, 0x00, 0x00, 0x00, 0x00};
+    uint8_t f653[8] = {0x03, 0x00, 0x78, 0x00, 0x00, 0x00, 0x00, 0x00};
+    uint8_t f6B2[8] = {0x7D, 0x00, 0x1E, 0x01, 0x00, 0x00, 0x00, 0x00};
+    uint8_t cell[8] = {0x05, 0x8C, 0xA0, 0x00, 0x00, 0x00, 0x00, 0x00};
+    uint8_t badCell[8] = {0x48, 0x8C, 0xA0, 0x00, 0x00, 0x00, 0x00, 0x00};
+    bms_t *bms = data->bms;
+    uint32_t seq = bms->rx.seq;
+
+    CHECK("bms stale before frames", isStale(&bms->rx, 1000000), 1);
+    bms->relayStatus = 0x55;
+    CHECK("bms 0x6B0 handled", bmsParseMsg(0x6B0, f6B0), 1);
+    CHECK("bms packCurrent", bms->packCurrent, 30.0);
+    CHECK("bms packVoltage", bms->packVoltage, 400.0);
+    CHECK("bms Soc", bms->Soc, 100);
+    CHECK("bms cellMaxVoltage", bms->cellMaxVoltage, 3.6);
+    /* 0x6B0 used to overwrite relayStatus with the cell voltage bytes */
+    CHECK("bms relayStatus kept", bms->relayStatus, 0x55);
+    CHECK("bms seq", bms->rx.seq, seq + 1);
+    CHECK("bms fresh after frame", isStale(&bms->rx, 1000000), 0);
+
+    /* 0x150 used to divide packCurrent by 10 again on every frame */
+    CHECK("bms 0x150 handled", bmsParseMsg(0x150, f150), 1);
+    CHECK("bms packCurrent kept", bms->packCurrent, 30.0);
+    CHECK("bms packAh", bms->packAh, 10000);
+    CHECK("bms highTemp", bms->highTemp, 35);
+    CHECK("bms lowTemp", bms->lowTemp, 20);
+
+    CHECK("bms 0x652 handled", bmsParseMsg(0x652, f652), 1);
+    CHECK("bms packCCL", bms->packCCL, -200);
+    CHECK("bms packDCL", bms->packDCL, 300);
+
+    CHECK("bms 0x653 handled", bmsParseMsg(0x653, f653), 1);
+    CHECK("bms relayStatus", bms->relayStatus, 3);
+    CHECK("bms inputVoltage", bms->inputVoltage, 12.0);
+
+    CHECK("bms 0x6B2 handled", bmsParseMsg(0x6B2, f6B2), 1);
+    CHECK("bms cellMinVoltage", bms->cellMinVoltage, 3.2);
+    CHECK("bms avgTemp", bms->avgTemp, 30);
+    CHECK("bms imdStatus", bms->imdStatus, 1);
+
+    CHECK("bms cell handled", bmsParseMsg(BMS_CELL_ID, cell), 1);
+    CHECK("bms cells[5]", cells[5], 3.6);
+    CHECK("bms bad cell rejected", bmsParseMsg(BMS_CELL_ID, badCell), 0);
+    CHECK("bms unknown ID", bmsParseMsg(0x123, cell), 0);
+}
+
+static void testRms() {
+    uint8_t fA2[8] = {0x00, 0x00, 0x00, 0x00, 0xE8, 0x03, 0x00, 0x00};
+    uint8_t fA2Glitch[8] = {0x00, 0x00, 0x00, 0x00, 0xA0, 0x0F, 0x00, 0x00};
+    uint8_t fA5[8] = {0x00, 0x00, 0x18, 0xFC, 0xF4, 0x01, 0x00, 0x00};
+    uint8_t fA6[8] = {0x9C, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x64, 0x00};
+    uint8_t fA7[8] = {0x70, 0x17, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+    uint8_t fAB[8] = {0x78, 0x56, 0x34, 0x12, 0x00, 0x00, 0x00, 0x80};
+    uint8_t fAC[8] = {0xF6, 0xFF, 0x64, 0x00, 0x00, 0x00, 0x00, 0x00};
+    rms_t *rms = data->rms;
+    uint32_t bmsSeq, rmsSeq;
+
+    CHECK("rms 0xA2 handled", rms_parser(0xA2, fA2, NO_FILTER), 0);
+    CHECK("rms motorTemp", rms->motorTemp, 100);
+    /* Anything over 300 C is a sensor glitch and gets dropped */
+    rms_parser(0xA2, fA2Glitch, NO_FILTER);
+    CHECK("rms motorTemp glitch", rms->motorTemp, 100);
+
+    rms_parser(0xA5, fA5, NO_FILTER);
+    CHECK("rms motorSpeed", rms->motorSpeed, -1000);
+    CHECK("rms electricalFreq", rms->electricalFreq, 50);
+
+    rms_parser(0xA6, fA6, NO_FILTER);
+    CHECK("rms phaseACurrent", rms->phaseACurrent, -10);
+    CHECK("rms dcBusCurrent", rms->dcBusCurrent, 10);
+
+    rms_parser(0xA7, fA7, NO_FILTER);
+    CHECK("rms dcBusVoltage", rms->dcBusVoltage, 600);
+
+    rms_parser(0xAB, fAB, NO_FILTER);
+    CHECK("rms faultCode1", rms->faultCode1, 0x12345678);
+    CHECK("rms faultCode2", rms->faultCode2, 0x80000000);
+
+    rms_parser(0xAC, fAC, NO_FILTER);
+    CHECK("rms commandedTorque", rms->commandedTorque, -1);
+    CHECK("rms actualTorque", rms->actualTorque, 10);
+
+    CHECK("rms filtered out", rms_parser(0xA0, fA2, 0xA1), 1);
+    /* RMS frames count as RMS traffic, never as the BMS still talking */
+    bmsSeq = data->bms->rx.seq;
+    rmsSeq = rms->rx.seq;
+    CHECK("rms no-signal ID", rms_parser(0xA3, fA2, NO_FILTER), 0);
+    CHECK("rms frame stamps rms", rms->rx.seq, rmsSeq + 1);
+    CHECK("rms frame leaves bms alone", data->bms->rx.seq, bmsSeq);
+    CHECK("rms unknown ID", rms_parser(0xB0, fA2, NO_FILTER), 1);
+    CHECK("rms fresh after frame", isStale(&rms->rx, 1000000), 0);
+}
+
+int main() {
+    initData();
+    printf("---Begin CAN decode test---\n");
+    testBms();
+    testRms();
+    printf("---End CAN decode test, %d failures---\n", failures);
+    if (failures != 0) exit(-1);
+    return 0;
+}
@@ -0,0 +1,150 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "data.h"
+#include "ring.h"
+#include "filters.h"
+#include "check.h"
+
+/* Times one update of a 200 sample rolling average, the pressure monitor's
+ * window, done the old way (re-summing the whole window), through the
+ * tsRing_t history, and with the running sum filters. Then checks the running
+ * sums against a full re-sum after a long run. No hardware needed */
+
+#define WINDOW      200
+#define NUM_TIMED   200000
+#define NUM_LONG    5000000
+
+static volatile double sink;
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_CYCLES 1
+static inline uint64_t cycles() { return __rdtsc(); }
+#else
+/* No user space cycle counter by default on the BeagleBone, nS only there */
+#define HAVE_CYCLES 0
+static inline uint64_t cycles() { return 0; }
+#endif
+
+/* Something that looks like a transducer, a few hundred psi with noise */
+static double reading(uint32_t i) {
+    return 600 + 5 * sin(i * 0.01) + (double) (i * 2654435761u % 1000) / 1000.0;
+}
+
+/* What pressureMonitor() used to do for each channel */
+static double oldAvg(double *buf, uint32_t *idx, double val) {
+    double sum = 0;
+    int i;
+    buf[*idx] = val;
+    *idx = (*idx + 1) % WINDOW;
+    for (i = 0; i < WINDOW; i++) sum += buf[i];
+    return sum / WINDOW;
+}
+
+static void report(const char *name, uint64_t startUs, uint64_t startCyc) {
+    double ns = (getuSTimestamp() - startUs) * 1000.0 / NUM_TIMED;
+    if (HAVE_CYCLES) {
+        printf("%-22s %8.1f nS %8.1f cycles per update\n", name, ns,
+                (double) (cycles() - startCyc) / NUM_TIMED);
+    } else {
+        printf("%-22s %8.1f nS per update\n", name, ns);
+    }
+}
+
+static void bench() {
+    static double buf[WINDOW];
+    uint32_t idx = 0, i;
+    tsRing_t ring;
+    rollMean_t f;
+    rollMeanFix_t fix;
+    uint64_t us, cyc;
+
+    tsRingInit(&ring, 256);
+    rollMeanInit(&f, WINDOW);
+    rollMeanFixInit(&fix, WINDOW);
+
+    us = getuSTimestamp(); cyc = cycles();
+    for (i = 0; i < NUM_TIMED; i++) sink = oldAvg(buf, &idx, reading(i));
+    report("re-sum array", us, cyc);
+
+    us = getuSTimestamp(); cyc = cycles();
+    for (i = 0; i < NUM_TIMED; i++) {
+        tsRingPush(&ring, i, reading(i));
+        sink = tsRingMean(&ring, WINDOW);
+    }
+    report("tsRingMean", us, cyc);
+
+    us = getuSTimestamp(); cyc = cycles();
+    for (i = 0; i < NUM_TIMED; i++) sink = rollMeanPush(&f, reading(i));
+    report("rollMeanPush", us, cyc);
+
+    us = getuSTimestamp(); cyc = cycles();
+    for (i = 0; i < NUM_TIMED; i++) sink = rollMeanFixPush(&fix, (int32_t) (reading(i) * 1000));
+    report("rollMeanFixPush", us, cyc);
+
+    /* The cost of making up the samples, to take off the numbers above */
+    us = getuSTimestamp(); cyc = cycles();
+    for (i = 0; i < NUM_TIMED; i++) sink = reading(i);
+    report("(reading only)", us, cyc);
+
+    tsRingFree(&ring);
+    rollMeanFree(&f);
+    rollMeanFixFree(&fix);
+}
+
+/* Running sums against two passes over the same window after a long run */
+static void accuracy() {
+    rollMean_t f;
+    rollMeanFix_t fix;
+    int64_t sum = 0, sumSq = 0;
+    double mean = 0, var = 0, v;
+    int32_t iv;
+    uint32_t i;
+
+    rollMeanInit(&f, WINDOW);
+    rollMeanFixInit(&fix, WINDOW);
+
+    CHECK("empty mean", rollMeanGet(&f) == 0 && rollMeanVar(&f) == 0);
+    rollMeanPush(&f, 4);
+    rollMeanPush(&f, 8);
+    CHECK("partial window", rollMeanGet(&f) == 6 && rollMeanVar(&f) == 4);
+    rollMeanReset(&f);
+
+    for (i = 0; i < NUM_LONG; i++) {
+        rollMeanPush(&f, reading(i));
+        rollMeanFixPush(&fix, (int32_t) (reading(i) * 1000));
+    }
+
+    for (i = NUM_LONG - WINDOW; i < NUM_LONG; i++) mean += reading(i);
+    mean /= WINDOW;
+    for (i = NUM_LONG - WINDOW; i < NUM_LONG; i++) {
+        v = reading(i) - mean;
+        var += v * v;
+    }
+    var /= WINDOW;
+    printf("after %d updates: mean off by %.2e, variance off by %.2e\n", NUM_LONG,
+            fabs(rollMeanGet(&f) - mean), fabs(rollMeanVar(&f) - var));
+    CHECK("mean drift", fabs(rollMeanGet(&f) - mean) < 1e-9);
+    CHECK("variance drift", fabs(rollMeanVar(&f) - var) < 1e-6);
+
+    for (i = NUM_LONG - WINDOW; i < NUM_LONG; i++) {
+        iv = (int32_t) (reading(i) * 1000);
+        sum += iv;
+        sumSq += (int64_t) iv * iv;
+    }
+    CHECK("fixed point mean exact", rollMeanFixGet(&fix) == (int32_t) ((sum + WINDOW / 2) / WINDOW));
+    CHECK("fixed point variance exact", rollMeanFixVar(&fix) == (sumSq - sum * sum / WINDOW) / WINDOW);
+
+    rollMeanFree(&f);
+    rollMeanFixFree(&fix);
+}
+
+int main() {
+    printf("---Begin filter benchmark, %d sample window---\n", WINDOW);
+    bench();
+    accuracy();
+    printf("---End filter benchmark---\n");
+    return checkResult();
+}
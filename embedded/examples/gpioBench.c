@@ -0,0 +1,176 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include "data.h"
+#include "bbgpio.h"
+#include "check.h"
+
+/* Toggles a pin as fast as it can, first the way bbGpioSetValue() used to
+ * (build the path, open, write, close every time), then through the cached
+ * fds and a pin handle, then straight through the GPIO registers. Pass an
+ * exported output pin to run it on the real sysfs and /dev/mem, with no pin
+ * it makes a fake gpio tree in /tmp and mock registers, which still shows the
+ * syscalls saved but not what sysfs or the bus cost */
+
+#define NUM_TOGGLES 100000
+#define FAKE_PIN    66
+
+
+static const char *root = "/sys/class/gpio";
+
+static void oldSetValue(unsigned int gpio, bool val) {
+    char buff[256];
+    int fd;
+    snprintf(buff, sizeof(buff), "%s/gpio%d/value", root, gpio);
+    fd = open(buff, O_WRONLY);
+    if (fd < 0) return;
+    write(fd, val ? "1" : "0", 2);
+    close(fd);
+}
+
+static void report(const char *name, uint64_t start) {
+    uint64_t us = getuSTimestamp() - start;
+    printf("%-16s %9.0f toggles/s  %6.2f uS each\n", name, NUM_TOGGLES * 1000000.0 / us,
+            (double) us / NUM_TOGGLES);
+}
+
+static void testRegisters(unsigned int gpio, bool fake) {
+    volatile uint32_t *bank;
+    bbGpioPin_t pin;
+    uint64_t start;
+    uint32_t mask = 1u << (gpio % 32);
+    int i;
+
+    if ((fake ? bbGpioMmapInitMock() : bbGpioMmapInit()) != 0) return;
+    bank = bbGpioMmapBank(gpio / 32);
+
+    CHECK("handle on registers", bbGpioPinOpen(&pin, gpio) == 0 && pin.bank == bank);
+    start = getuSTimestamp();
+    for (i = 0; i < NUM_TOGGLES; i++) bbGpioPinSet(&pin, i & 1);
+    report("registers", start);
+
+    if (fake) {
+        /* Sets and clears are single writes of just this pin's bit */
+        bank[BB_GPIO_SETDATAOUT / 4] = 0;
+        bank[BB_GPIO_CLEARDATAOUT / 4] = 0;
+        bbGpioMmapSet(gpio, true);
+        CHECK("set register", bank[BB_GPIO_SETDATAOUT / 4] == mask && bank[BB_GPIO_CLEARDATAOUT / 4] == 0);
+        bbGpioPinSet(&pin, false);
+        CHECK("clear register", bank[BB_GPIO_CLEARDATAOUT / 4] == mask);
+
+        bank[BB_GPIO_DATAIN / 4] = mask | 1;
+        CHECK("read pin", bbGpioMmapGet(gpio) && bbGpioPinGet(&pin) == 1);
+        CHECK("read bank", bbGpioMmapReadBank(gpio / 32) == (mask | 1));
+        bank[BB_GPIO_DATAIN / 4] = 1;
+        CHECK("read low", !bbGpioMmapGet(gpio) && bbGpioPinGet(&pin) == 0);
+
+        bbGpioMmapSetDir(gpio, true);
+        CHECK("output", bank[BB_GPIO_OE / 4] == ~mask);
+        bbGpioMmapSetDir(gpio, false);
+        CHECK("input", bank[BB_GPIO_OE / 4] == 0xFFFFFFFF);
+    }
+    bbGpioMmapRelease();
+}
+
+static int writeFile(const char *path, const char *val) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return -1;
+    write(fd, val, strlen(val));
+    close(fd);
+    return 0;
+}
+
+/* gpioN/value and direction in a temp directory */
+static int makeFakeTree(char *dir, unsigned int gpio) {
+    char path[256];
+    int fd;
+    if (mkdtemp(dir) == NULL) return -1;
+    snprintf(path, sizeof(path), "%s/export", dir);
+    if (writeFile(path, "") != 0) return -1;
+    snprintf(path, sizeof(path), "%s/unexport", dir);
+    if (writeFile(path, "") != 0) return -1;
+    snprintf(path, sizeof(path), "%s/gpio%u", dir, gpio);
+    if (mkdir(path, 0755) != 0) return -1;
+    snprintf(path, sizeof(path), "%s/gpio%u/value", dir, gpio);
+    if ((fd = open(path, O_WRONLY | O_CREAT, 0644)) < 0) return -1;
+    write(fd, "0\n", 2);
+    close(fd);
+    snprintf(path, sizeof(path), "%s/gpio%u/direction", dir, gpio);
+    if ((fd = open(path, O_WRONLY | O_CREAT, 0644)) < 0) return -1;
+    write(fd, "out\n", 4);
+    close(fd);
+    return 0;
+}
+
+static void removeFakeTree(const char *dir, unsigned int gpio) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/gpio%u/value", dir, gpio);
+    unlink(path);
+    snprintf(path, sizeof(path), "%s/gpio%u/direction", dir, gpio);
+    unlink(path);
+    snprintf(path, sizeof(path), "%s/gpio%u", dir, gpio);
+    rmdir(path);
+    snprintf(path, sizeof(path), "%s/export", dir);
+    unlink(path);
+    snprintf(path, sizeof(path), "%s/unexport", dir);
+    unlink(path);
+    rmdir(dir);
+}
+
+int main(int argc, char *argv[]) {
+    char fakeDir[] = "/tmp/gpioBenchXXXXXX";
+    unsigned int gpio = argc > 1 ? atoi(argv[1]) : FAKE_PIN;
+    bool fake = argc <= 1;
+    bbGpioPin_t pin;
+    uint64_t start;
+    int i;
+
+    if (fake) {
+        if (makeFakeTree(fakeDir, gpio) != 0) {
+            perror("gpioBench");
+            return 1;
+        }
+        root = fakeDir;
+        bbGpioSetSysfsRoot(fakeDir);
+    }
+    printf("---Begin GPIO toggle benchmark, gpio%u on %s---\n", gpio, fake ? "a fake tree" : "the pod");
+
+    start = getuSTimestamp();
+    for (i = 0; i < NUM_TOGGLES; i++) oldSetValue(gpio, i & 1);
+    report("open every time", start);
+
+    start = getuSTimestamp();
+    for (i = 0; i < NUM_TOGGLES; i++) bbGpioSetValue(gpio, i & 1);
+    report("bbGpioSetValue", start);
+
+    CHECK("handle", bbGpioPinOpen(&pin, gpio) == 0);
+    start = getuSTimestamp();
+    for (i = 0; i < NUM_TOGGLES; i++) bbGpioPinSet(&pin, i & 1);
+    report("bbGpioPinSet", start);
+
+    CHECK("set high", bbGpioPinSet(&pin, true) == 0 && bbGpioPinGet(&pin) == 1);
+    CHECK("set low", bbGpioSetValue(gpio, false) == 0 && bbGpioGetValue(gpio) == false);
+    CHECK("direction", strcmp(bbGpioGetDir(gpio), OUT_DIR) == 0);
+
+    if (fake) {
+        /* Unexport and export again, which makes new files under gpioN */
+        char path[256];
+        snprintf(path, sizeof(path), "%s/gpio%u/value", fakeDir, gpio);
+        CHECK("unexport", bbGpioUnexport(gpio) == 0);
+        unlink(path);
+        writeFile(path, "1\n");
+        CHECK("export", bbGpioExport(gpio) == 0);
+        CHECK("new value file after export", bbGpioGetValue(gpio) == true);
+    }
+
+    testRegisters(gpio, fake);
+
+    bbGpioCloseAll();
+    if (fake) removeFakeTree(fakeDir, gpio);
+    printf("---End GPIO toggle benchmark---\n");
+    return checkResult();
+}
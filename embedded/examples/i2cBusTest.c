@@ -0,0 +1,123 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+
+#include "i2c.h"
+#include "check.h"
+
+/* Several threads share one made up bus, like the IMU, ADC and expanders do
+ * on bus 2. The fake device takes XFER_US to answer and echoes back whatever
+ * byte was written, so a thread that ever reads another thread's byte means
+ * two transfers got mixed up. One device is I2C_PRIO_HIGH, and its wait for
+ * the bus should stay around one transfer however busy the rest are. */
+
+#define TEST_BUS        1
+#define XFER_US         500
+#define NUM_NORMAL      4
+#define NORMAL_XFERS    200
+#define HIGH_XFERS      50
+#define HIGH_PERIOD_US  2000
+
+static int mixedUp = 0;
+
+static void *fakeDev(void *arg) {
+    int fd = *(int *) arg;
+    uint8_t buf[64];
+    int n;
+    while ((n = recv(fd, buf, sizeof(buf), 0)) > 0) {
+        usleep(XFER_US);
+        send(fd, buf, 1, 0);
+    }
+    return NULL;
+}
+
+typedef struct client_t {
+    i2c_settings dev;
+    int xfers;
+    int periodUs;
+    pthread_t thread;
+} client_t;
+
+static void *clientLoop(void *arg) {
+    client_t *c = (client_t *) arg;
+    uint8_t token, answer;
+    int i;
+    for (i = 0; i < c->xfers; i++) {
+        token = (uint8_t) (c->dev.deviceAddress + i);
+        if (write_read_i2c(&c->dev, &token, 1, &answer, 1) != 0 || answer != token) {
+            __atomic_fetch_add(&mixedUp, 1, __ATOMIC_RELAXED);
+        }
+        if (c->periodUs) usleep(c->periodUs);
+    }
+    return NULL;
+}
+
+static void report(const char *name, client_t *c) {
+    i2cStats_t s;
+    i2cGetStats(&c->dev, &s);
+    printf("%-8s %#x: %4llu xfers, %llu errors, wait avg %5.0f max %5llu uS, "
+            "on bus avg %4.0f uS\n", name, c->dev.deviceAddress,
+            (unsigned long long) s.count, (unsigned long long) s.errors,
+            s.count ? (double) s.waitTotal / s.count : 0, (unsigned long long) s.waitMax,
+            s.count ? (double) s.xferTotal / s.count : 0);
+}
+
+int main() {
+    client_t normal[NUM_NORMAL], high;
+    i2cStats_t highStats, normalStats;
+    pthread_t devThread;
+    int sv[2], i;
+    double normalAvg = 0;
+
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv) != 0) {
+        perror("i2cBusTest");
+        return -1;
+    }
+    i2cUseFd(TEST_BUS, sv[0]);
+    pthread_create(&devThread, NULL, fakeDev, &sv[1]);
+
+    memset(normal, 0, sizeof(normal));
+    memset(&high, 0, sizeof(high));
+    for (i = 0; i < NUM_NORMAL; i++) {
+        normal[i].dev.bus = TEST_BUS;
+        normal[i].dev.deviceAddress = 0x20 + i;
+        normal[i].xfers = NORMAL_XFERS;
+        i2c_begin(&normal[i].dev);
+    }
+    high.dev.bus = TEST_BUS;
+    high.dev.deviceAddress = 0x48;
+    high.xfers = HIGH_XFERS;
+    high.periodUs = HIGH_PERIOD_US;
+    i2c_begin(&high.dev);
+    CHECK("set priority", i2cSetPriority(&high.dev, I2C_PRIO_HIGH) == 0);
+    CHECK("bad priority", i2cSetPriority(&high.dev, I2C_NUM_PRIOS) == -1);
+
+    for (i = 0; i < NUM_NORMAL; i++) pthread_create(&normal[i].thread, NULL, clientLoop, &normal[i]);
+    pthread_create(&high.thread, NULL, clientLoop, &high);
+    for (i = 0; i < NUM_NORMAL; i++) pthread_join(normal[i].thread, NULL);
+    pthread_join(high.thread, NULL);
+
+    for (i = 0; i < NUM_NORMAL; i++) {
+        report("normal", &normal[i]);
+        i2cGetStats(&normal[i].dev, &normalStats);
+        normalAvg += (double) normalStats.waitTotal / normalStats.count / NUM_NORMAL;
+    }
+    report("high", &high);
+    i2cGetStats(&high.dev, &highStats);
+
+    CHECK("nothing mixed up", mixedUp == 0);
+    CHECK("every transfer counted", highStats.count == HIGH_XFERS && normalStats.count == NORMAL_XFERS);
+    /* Normal ones queue behind each other, high only behind what's on the bus */
+    CHECK("high waits less", (double) highStats.waitTotal / highStats.count < normalAvg / 2);
+
+    i2cUseFd(TEST_BUS, -1);
+    close(sv[0]);
+    shutdown(sv[1], SHUT_RDWR);
+    pthread_join(devThread, NULL);
+    close(sv[1]);
+
+    return checkResult();
+}
@@ -0,0 +1,29 @@
+#ifndef __CHECK_H__
+#define __CHECK_H__
+
+#include <stdio.h>
+
+/* The examples' test harness. CHECK() counts a failure and carries on, and
+ * main() ends with return checkResult(); */
+
+static int failures = 0;
+
+#define CHECK(name, cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "FAIL %s\n", name); \
+            failures++; \
+        } \
+    } while (0)
+
+/* Prints how it went and gives main()'s exit code */
+static inline int checkResult(void) {
+    if (failures) {
+        printf("%d checks failed\n", failures);
+        return 1;
+    }
+    printf("All passed\n");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,128 @@
+#ifndef __FAKE_MCP_H__
+#define __FAKE_MCP_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+
+#include "data.h"
+#include "i2c.h"
+#include "mcp23017.h"
+
+/* A made up MCP23017 for the examples, put on an I2C bus with i2cUseFd().
+ *
+ * It sits on the other end of a SOCK_SEQPACKET socket, so every write() is
+ * one packet just like one transaction on the bus. A one byte write sets the
+ * register pointer and is answered with every register from there on, of
+ * which the read takes as many as it asked for. Longer writes fill registers
+ * from the pointer on, and writing GPIO writes OLAT like the real chip.
+ *
+ * Other chips on the same bus go through other(). It gets the one byte
+ * writes first and returns true for any it answered. */
+
+#define FAKE_MCP_REGS   0x16
+
+/* The register numbers are chars */
+#define REG(r)          ((uint8_t) (r))
+
+typedef struct fakeMcp_t fakeMcp_t;
+
+struct fakeMcp_t {
+    int fd, busFd;
+    uint8_t regs[FAKE_MCP_REGS];
+    uint8_t inputs[2];          /* What's on the pins set as inputs */
+    int writes;
+    uint64_t olatChanged[2];    /* When OLATA and OLATB last changed */
+    bool (*other)(fakeMcp_t *dev, uint8_t cmd);
+    pthread_t thread;
+};
+
+static inline void fakeMcpAnswer(fakeMcp_t *dev, uint8_t ptr) {
+    uint8_t out[FAKE_MCP_REGS];
+    int b;
+    memcpy(out, dev->regs, FAKE_MCP_REGS);
+    /* Reading GPIO gives the pins, outputs read back what OLAT drives */
+    for (b = 0; b < 2; b++) {
+        out[REG(GPIOA) + b] = (dev->regs[REG(OLATA) + b] & ~dev->regs[REG(IODIRA) + b]) |
+            (dev->inputs[b] & dev->regs[REG(IODIRA) + b]);
+    }
+    if (ptr >= FAKE_MCP_REGS) ptr = 0;
+    send(dev->fd, out + ptr, FAKE_MCP_REGS - ptr, 0);
+}
+
+static inline void fakeMcpWrite(fakeMcp_t *dev, uint8_t reg, uint8_t val) {
+    /* Writing GPIO writes OLAT */
+    if (reg == REG(GPIOA) || reg == REG(GPIOB)) reg += 2;
+    if ((reg == REG(OLATA) || reg == REG(OLATB)) && dev->regs[reg] != val) {
+        __atomic_store_n(&dev->olatChanged[reg - REG(OLATA)], getuSTimestamp(), __ATOMIC_RELEASE);
+    }
+    dev->regs[reg] = val;
+}
+
+static inline void *fakeMcpLoop(void *arg) {
+    fakeMcp_t *dev = (fakeMcp_t *) arg;
+    uint8_t buf[64];
+    uint8_t ptr;
+    int n, i;
+
+    /* setupMCP() reads once before ever setting the pointer */
+    fakeMcpAnswer(dev, 0);
+    while ((n = recv(dev->fd, buf, sizeof(buf), 0)) > 0) {
+        ptr = buf[0];
+        if (n == 1) {
+            if (dev->other == NULL || !dev->other(dev, ptr)) fakeMcpAnswer(dev, ptr);
+            continue;
+        }
+        dev->writes++;
+        for (i = 1; i < n && ptr < FAKE_MCP_REGS; i++, ptr++) {
+            fakeMcpWrite(dev, ptr, buf[i]);
+        }
+    }
+    return NULL;
+}
+
+/* Powers the fake on, everything an input and latches low, and puts it on
+ * bus. other can be NULL */
+static inline int fakeMcpStart(fakeMcp_t *dev, int bus, bool (*other)(fakeMcp_t *, uint8_t)) {
+    int sv[2];
+    memset(dev, 0, sizeof(*dev));
+    dev->regs[REG(IODIRA)] = dev->regs[REG(IODIRB)] = 0xFF;
+    dev->other = other;
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv) != 0) {
+        perror("fakeMcpStart");
+        return -1;
+    }
+    dev->fd = sv[1];
+    dev->busFd = sv[0];
+    i2cUseFd(bus, sv[0]);
+    return pthread_create(&dev->thread, NULL, fakeMcpLoop, dev);
+}
+
+static inline void fakeMcpStop(fakeMcp_t *dev, int bus) {
+    i2cUseFd(bus, -1);
+    close(dev->busFd);
+    shutdown(dev->fd, SHUT_RDWR);
+    pthread_join(dev->thread, NULL);
+    close(dev->fd);
+}
+
+/* Writes aren't answered, so a round trip straight on the socket (not
+ * counted) makes sure the fake has caught up before its registers are
+ * checked */
+static inline void fakeMcpSettle(fakeMcp_t *dev) {
+    uint8_t reg = 0;
+    if (write(dev->busFd, &reg, 1) != 1 || read(dev->busFd, &reg, 1) != 1) {
+        perror("fakeMcpSettle");
+    }
+}
+
+/* When OLATB last changed, what the brake solenoids are on */
+static inline uint64_t fakeMcpOlatbChanged(fakeMcp_t *dev) {
+    return __atomic_load_n(&dev->olatChanged[1], __ATOMIC_ACQUIRE);
+}
+
+#endif
@@ -0,0 +1,88 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "i2c.h"
+#include "mcp23017.h"
+#include "hv_iox.h"
+#include "lv_iox.h"
+#include "check.h"
+#include "fakeMcp.h"
+
+/* Brings the HV and LV IO expanders up against a made up MCP23017 and
+ * counts the I2C transactions it took, then checks the pins ended up the way
+ * setupIox() wants them and that the shadow keeps later pin changes to one
+ * write each. */
+
+static void testHV() {
+    fakeMcp_t dev;
+    unsigned long start, used;
+
+    if (fakeMcpStart(&dev, 2, NULL) != 0) return;
+    start = i2cTransactionCount();
+    CHECK("initHVIox", initHVIox(true) == 0);
+    used = i2cTransactionCount() - start;
+    printf("initHVIox: %lu transactions\n", used);
+    /* Probe, clear IODIR and OLAT, then one write of the directions */
+    CHECK("HV init transactions", used <= 4);
+    fakeMcpSettle(&dev);
+
+    /* Only the MCU latch is an output */
+    CHECK("HV IODIRA", dev.regs[REG(IODIRA)] == 0xFF);
+    CHECK("HV IODIRB", dev.regs[REG(IODIRB)] == (uint8_t) ~(1 << (MCU_LATCH - MCP_GPIOB_0)));
+
+    start = i2cTransactionCount();
+    setMCULatch(true);
+    setMCULatch(true);
+    printf("setMCULatch twice: %lu transactions\n", i2cTransactionCount() - start);
+    fakeMcpStop(&dev, 2);
+}
+
+static void testLV() {
+    fakeMcp_t dev;
+    unsigned long start, used;
+    i2c_settings iox;
+
+    if (fakeMcpStart(&dev, 2, NULL) != 0) return;
+    start = i2cTransactionCount();
+    CHECK("initLVIox", initLVIox(true) == 0);
+    used = i2cTransactionCount() - start;
+    printf("initLVIox: %lu transactions\n", used);
+    CHECK("LV init transactions", used <= 4);
+    fakeMcpSettle(&dev);
+
+    /* Limit switches in on A, solenoids out and off on B */
+    CHECK("LV IODIRA", (dev.regs[REG(IODIRA)] & 0x0F) == 0x0F);
+    CHECK("LV IODIRB", dev.regs[REG(IODIRB)] == 0x00);
+    CHECK("LV OLATB", dev.regs[REG(OLATA) + 1] == 0x00);
+
+    /* Another handle on the same chip sees the same pins */
+    iox.bus = 2;
+    iox.deviceAddress = 0x21;
+    CHECK("LV dup handle", i2c_begin(&iox) == 0);
+    start = i2cTransactionCount();
+    CHECK("LV set solenoid", setState(&iox, MCP_GPIOB_3, 1) == 0);
+    CHECK("LV set solenoid again", setState(&iox, MCP_GPIOB_3, 1) == 0);
+    CHECK("LV can't drive an input", setState(&iox, MCP_GPIOA_0, 1) == -1);
+    fakeMcpSettle(&dev);
+    CHECK("LV OLATB after", dev.regs[REG(OLATA) + 1] == 0x08);
+    printf("solenoid on twice: %lu transactions\n", i2cTransactionCount() - start);
+
+    dev.inputs[0] = 0x05;
+    start = i2cTransactionCount();
+    CHECK("LV limit switch 0", getState(&iox, MCP_GPIOA_0) == 1);
+    CHECK("LV limit switch 1", getState(&iox, MCP_GPIOA_1) == 0);
+    CHECK("LV solenoid reads back", getState(&iox, MCP_GPIOB_3) == 1);
+    printf("three pin reads: %lu transactions\n", i2cTransactionCount() - start);
+    start = i2cTransactionCount();
+    CHECK("LV all pins", (getStates(&iox) & 0x080F) == 0x0805);
+    printf("all pins at once: %lu transactions\n", i2cTransactionCount() - start);
+    fakeMcpStop(&dev, 2);
+}
+
+int main() {
+    testHV();
+    testLV();
+    return checkResult();
+}
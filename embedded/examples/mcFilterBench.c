@@ -0,0 +1,218 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "data.h"
+#include "filters.h"
+#include "mcFilter.h"
+#include "check.h"
+
+/* Times one update of all eight pressure channels through the mcFilter
+ * kernels against running a scalar filter per channel, and checks both give
+ * the same answers. No hardware needed */
+
+#define NUM_TIMED   200000
+#define SAMPLE_HZ   50.0        /* The pressure monitor's rate */
+#define CUTOFF_HZ   2.0
+
+static volatile float sink;
+
+/* Eight transducers, each with its own level, slow wander and noise */
+static void reading(uint32_t i, mcfVec_t *x) {
+    int c;
+    for (c = 0; c < MCF_CHANNELS; c++) {
+        x->ch[c] = 100 * (c + 1) + 5 * sinf(i * 0.01f + c)
+            + (float) ((i * 2654435761u + c * 40503u) % 1000) / 100.0f;
+    }
+}
+
+static void report(const char *name, uint64_t scalarUs, uint64_t vecUs) {
+    printf("%-16s scalar %7.1f nS  mcFilter %7.1f nS  per 8 channel update\n", name,
+            scalarUs * 1000.0 / NUM_TIMED, vecUs * 1000.0 / NUM_TIMED);
+}
+
+static float median5(const float *v) {
+    float s[MCF_MEDIAN_N], t;
+    int i, j;
+    memcpy(s, v, sizeof(s));
+    for (i = 1; i < MCF_MEDIAN_N; i++) {
+        for (j = i; j > 0 && s[j - 1] > s[j]; j--) {
+            t = s[j]; s[j] = s[j - 1]; s[j - 1] = t;
+        }
+    }
+    return s[MCF_MEDIAN_N / 2];
+}
+
+static void testMa() {
+    static mcfMa_t mf;
+    rollMean_t rf[MCF_CHANNELS];
+    mcfVec_t x, out;
+    uint64_t start, scalarUs;
+    uint32_t i;
+    int c;
+    float worst = 0;
+
+    for (c = 0; c < MCF_CHANNELS; c++) rollMeanInit(&rf[c], MCF_MA_WINDOW);
+    mcfMaInit(&mf);
+
+    start = getuSTimestamp();
+    for (i = 0; i < NUM_TIMED; i++) {
+        reading(i, &x);
+        for (c = 0; c < MCF_CHANNELS; c++) sink = rollMeanPush(&rf[c], x.ch[c]);
+    }
+    scalarUs = getuSTimestamp() - start;
+
+    start = getuSTimestamp();
+    for (i = 0; i < NUM_TIMED; i++) {
+        reading(i, &x);
+        mcfMaPush(&mf, &x);
+        mcfMaGet(&mf, &out);
+    }
+    report("moving average", scalarUs, getuSTimestamp() - start);
+
+    for (c = 0; c < MCF_CHANNELS; c++) {
+        worst = fmaxf(worst, fabs(out.ch[c] - rollMeanGet(&rf[c])));
+        rollMeanFree(&rf[c]);
+    }
+    CHECK("moving average matches", worst < 1e-3);
+}
+
+static void testEma() {
+    mcfEma_t mf;
+    float y[MCF_CHANNELS];
+    mcfVec_t x, out;
+    uint64_t start, scalarUs;
+    uint32_t i;
+    int c;
+    float worst = 0;
+
+    reading(0, &x);
+    memcpy(y, x.ch, sizeof(y));
+    start = getuSTimestamp();
+    for (i = 1; i < NUM_TIMED; i++) {
+        reading(i, &x);
+        for (c = 0; c < MCF_CHANNELS; c++) y[c] = expFilterFloat(x.ch[c], y[c], 0.1);
+    }
+    scalarUs = getuSTimestamp() - start;
+
+    mcfEmaInit(&mf, 0.1);
+    start = getuSTimestamp();
+    for (i = 0; i < NUM_TIMED; i++) {
+        reading(i, &x);
+        mcfEmaPush(&mf, &x, &out);
+    }
+    report("EMA", scalarUs, getuSTimestamp() - start);
+
+    for (c = 0; c < MCF_CHANNELS; c++) worst = fmaxf(worst, fabsf(out.ch[c] - y[c]));
+    CHECK("EMA matches", worst < 1e-2);
+}
+
+static void testMedian() {
+    mcfMedian_t mf;
+    float win[MCF_CHANNELS][MCF_MEDIAN_N];
+    mcfVec_t x, out;
+    uint64_t start, scalarUs;
+    uint32_t i;
+    int c, bad = 0;
+
+    start = getuSTimestamp();
+    for (i = 0; i < NUM_TIMED; i++) {
+        reading(i, &x);
+        for (c = 0; c < MCF_CHANNELS; c++) {
+            win[c][i % MCF_MEDIAN_N] = x.ch[c];
+            sink = median5(win[c]);
+        }
+    }
+    scalarUs = getuSTimestamp() - start;
+
+    mcfMedianInit(&mf);
+    start = getuSTimestamp();
+    for (i = 0; i < NUM_TIMED; i++) {
+        reading(i, &x);
+        mcfMedianPush(&mf, &x, &out);
+    }
+    report("median of 5", scalarUs, getuSTimestamp() - start);
+
+    for (c = 0; c < MCF_CHANNELS; c++) bad += out.ch[c] != median5(win[c]);
+    CHECK("median matches", bad == 0);
+
+    /* A single spike doesn't get through */
+    mcfMedianInit(&mf);
+    for (c = 0; c < MCF_CHANNELS; c++) x.ch[c] = 10;
+    mcfMedianPush(&mf, &x, &out);
+    x.ch[3] = 1000;
+    mcfMedianPush(&mf, &x, &out);
+    CHECK("median drops spike", out.ch[3] == 10);
+}
+
+static void testBiquad() {
+    mcfBiquad_t mf;
+    double b0, b1, b2, a1, a2, z1[MCF_CHANNELS], z2[MCF_CHANNELS], y[MCF_CHANNELS];
+    mcfVec_t x, out;
+    uint64_t start, scalarUs;
+    uint32_t i;
+    int c;
+    float worst = 0;
+
+    mcfBiquadLowpass(&mf, CUTOFF_HZ, SAMPLE_HZ);
+    b0 = mf.b0[0]; b1 = mf.b1[0]; b2 = mf.b2[0]; a1 = mf.a1[0]; a2 = mf.a2[0];
+
+    /* Settles on the first sample, so a constant input comes straight out */
+    for (c = 0; c < MCF_CHANNELS; c++) x.ch[c] = 50 * c;
+    mcfBiquadPush(&mf, &x, &out);
+    mcfBiquadPush(&mf, &x, &out);
+    for (c = 0; c < MCF_CHANNELS; c++) worst = fmaxf(worst, fabsf(out.ch[c] - x.ch[c]));
+    CHECK("no startup step", worst < 1e-3);
+    mcfBiquadLowpass(&mf, CUTOFF_HZ, SAMPLE_HZ);
+
+    memset(z1, 0, sizeof(z1));
+    memset(z2, 0, sizeof(z2));
+    reading(0, &x);
+    for (c = 0; c < MCF_CHANNELS; c++) {
+        z2[c] = (b2 - a2) * x.ch[c];
+        z1[c] = (b1 - a1) * x.ch[c] + z2[c];
+    }
+    start = getuSTimestamp();
+    for (i = 0; i < NUM_TIMED; i++) {
+        reading(i, &x);
+        for (c = 0; c < MCF_CHANNELS; c++) {
+            y[c] = b0 * x.ch[c] + z1[c];
+            z1[c] = b1 * x.ch[c] - a1 * y[c] + z2[c];
+            z2[c] = b2 * x.ch[c] - a2 * y[c];
+        }
+    }
+    scalarUs = getuSTimestamp() - start;
+
+    start = getuSTimestamp();
+    for (i = 0; i < NUM_TIMED; i++) {
+        reading(i, &x);
+        mcfBiquadPush(&mf, &x, &out);
+    }
+    report("biquad low pass", scalarUs, getuSTimestamp() - start);
+
+    worst = 0;
+    for (c = 0; c < MCF_CHANNELS; c++) worst = fmaxf(worst, fabs(out.ch[c] - y[c]));
+    CHECK("biquad matches", worst < 1e-2);
+}
+
+/* Making up the samples is in every number above, this is how much */
+static void timeReading() {
+    mcfVec_t x;
+    uint64_t start = getuSTimestamp();
+    uint32_t i;
+    for (i = 0; i < NUM_TIMED; i++) reading(i, &x);
+    printf("(making up samples %7.1f nS of each of those)\n",
+            (getuSTimestamp() - start) * 1000.0 / NUM_TIMED);
+}
+
+int main() {
+    printf("---Begin multi-channel filter benchmark, %d channels---\n", MCF_CHANNELS);
+    testMa();
+    testEma();
+    testMedian();
+    testBiquad();
+    timeReading();
+    printf("---End multi-channel filter benchmark---\n");
+    return checkResult();
+}
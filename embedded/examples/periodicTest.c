@@ -0,0 +1,83 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "data.h"
+#include "periodic.h"
+
+/* Runs a 10 mS loop with a few mS of work in it, once with usleep() the way
+ * the loops used to and once with periodicWait(), to show the drift going
+ * away. Then makes one iteration run long and checks it is counted as
+ * overruns and the loop lands back on its schedule. No hardware needed */
+
+#define PERIOD_US   10000
+#define WORK_US     3000
+#define NUM_RUNS    50
+#define SLACK_US    8000    /* Scheduling noise allowed on a loaded machine */
+
+static int failures = 0;
+
+int main() {
+    periodic_t task, longTask;
+    uint64_t start, elapsed, expected = NUM_RUNS * PERIOD_US;
+    int i, missed;
+
+    printf("---Begin periodic task test---\n");
+
+    start = getuSTimestamp();
+    for (i = 0; i < NUM_RUNS; i++) {
+        usleep(WORK_US);
+        usleep(PERIOD_US);
+    }
+    elapsed = getuSTimestamp() - start;
+    printf("usleep:   %d periods in %llu uS, %llu uS of drift\n", NUM_RUNS,
+            (unsigned long long) elapsed, (unsigned long long) (elapsed - expected));
+
+    periodicInit(&task, "test", PERIOD_US);
+    start = getuSTimestamp();
+    for (i = 0; i < NUM_RUNS; i++) {
+        usleep(WORK_US);
+        if (periodicWait(&task) != 0) {
+            fprintf(stderr, "FAIL unexpected overrun on run %d\n", i);
+            failures++;
+        }
+    }
+    elapsed = getuSTimestamp() - start;
+    printf("periodic: %d periods in %llu uS\n", NUM_RUNS, (unsigned long long) elapsed);
+    if (elapsed > expected + SLACK_US) {
+        fprintf(stderr, "FAIL periodic loop drifted, expected %llu uS\n",
+                (unsigned long long) expected);
+        failures++;
+    }
+    if (task.runs != NUM_RUNS || task.overruns != 0) {
+        fprintf(stderr, "FAIL %llu runs, %llu overruns\n", (unsigned long long) task.runs,
+                (unsigned long long) task.overruns);
+        failures++;
+    }
+
+    /* 35 mS of work misses the deadlines at 10, 20 and 30 mS, next run is at 40 */
+    periodicInit(&longTask, "overrun", PERIOD_US);
+    start = getuSTimestamp();
+    usleep(3 * PERIOD_US + PERIOD_US / 2);
+    missed = periodicWait(&longTask);
+    elapsed = getuSTimestamp() - start;
+    if (missed < 3 || longTask.overruns != (uint64_t) missed) {
+        fprintf(stderr, "FAIL expected 3 missed periods, got %d\n", missed);
+        failures++;
+    }
+    if (elapsed < (uint64_t) (missed + 1) * PERIOD_US ||
+            elapsed > (uint64_t) (missed + 1) * PERIOD_US + SLACK_US) {
+        fprintf(stderr, "FAIL woke at %llu uS, off the %d uS grid\n",
+                (unsigned long long) elapsed, PERIOD_US);
+        failures++;
+    }
+    periodicWait(&longTask);
+    if (getuSTimestamp() - start > (uint64_t) (missed + 2) * PERIOD_US + SLACK_US) {
+        fprintf(stderr, "FAIL did not get back on schedule after the overrun\n");
+        failures++;
+    }
+
+    periodicShowAll();
+    printf("---End periodic task test: %s---\n", failures ? "FAILED" : "PASSED");
+    return failures ? 1 : 0;
+}
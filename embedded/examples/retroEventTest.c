@@ -0,0 +1,104 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/gpio.h>
+
+#include "data.h"
+#include "retro.h"
+#include "gpiochip.h"
+#include "check.h"
+
+/* Feeds made up strip crossings to the retro code through a pipe standing in
+ * for the gpiochip. Each edge is written some mS after it "happened", the way
+ * the retro thread might get scheduled late, but carries the time it really
+ * happened like the kernel's would. Checks the count and that the strip time
+ * nav sees is the edge time, and shows how far off stamping on wakeup, the
+ * way the sysfs threads do, would have been. No hardware needed */
+
+#ifdef GPIO_V2_GET_LINE_IOCTL
+
+#define NUM_STRIPS      10
+#define STRIP_US        350000  /* 10 ft at about 20 mph, over VOTE_RESET_TIME */
+#define RETRO_SPREAD_US 300     /* Between each retro seeing the same strip */
+#define MAX_LATE_US     5000    /* Worst the reading thread is made to wait */
+
+
+static void sendEdge(int fd, unsigned int gpio, uint64_t time, uint32_t seqno) {
+    struct gpio_v2_line_event ev;
+    unsigned int chip;
+    memset(&ev, 0, sizeof(ev));
+    ev.timestamp_ns = time * 1000;
+    ev.id = GPIO_V2_LINE_EVENT_RISING_EDGE;
+    gpioChipLine(gpio, &chip, &ev.offset);
+    ev.seqno = seqno;
+    ev.line_seqno = seqno;
+    if (write(fd, &ev, sizeof(ev)) != sizeof(ev)) perror("retroEventTest");
+}
+
+int main() {
+    unsigned int pins[NUM_RETROS] = { RETRO_1_PIN, RETRO_2_PIN, RETRO_3_PIN };
+    uint64_t edge, counted, kernelErr, wakeErr, kernelMax = 0, wakeSum = 0, wakeMax = 0;
+    uint32_t seqno = 1;
+    int p[2], strip, r, count;
+
+    printf("---Begin retro edge event test---\n");
+    initData();
+    if (pipe(p) != 0 || initRetrosFromFd(p[0]) != 0) {
+        fprintf(stderr, "Failed to start the retros\n");
+        return 1;
+    }
+    srand(1);
+
+    for (strip = 1; strip <= NUM_STRIPS; strip++) {
+        edge = getuSTimestamp();
+        for (r = 0; r < NUM_RETROS; r++) {
+            /* Late, but stamped with when it happened */
+            usleep(rand() % MAX_LATE_US);
+            sendEdge(p[1], pins[r], edge + r * RETRO_SPREAD_US, seqno++);
+        }
+
+        /* When the count went up is about when a sysfs thread would have
+         * stamped it */
+        do {
+            count = data->motion->retroCount;
+            counted = getuSTimestamp();
+        } while (count < strip && counted - edge < STRIP_US);
+        CHECK("strip counted once", count == strip);
+
+        /* The second retro to see a strip is the one that wins the vote */
+        kernelErr = data->timers->lastRetro - (edge + RETRO_SPREAD_US);
+        wakeErr = counted - (edge + RETRO_SPREAD_US);
+        if (kernelErr > kernelMax) kernelMax = kernelErr;
+        if (wakeErr > wakeMax) wakeMax = wakeErr;
+        wakeSum += wakeErr;
+
+        usleep(STRIP_US - (getuSTimestamp() - edge));
+    }
+
+    printf("%d strips, %d counted\n", NUM_STRIPS, data->motion->retroCount);
+    printf("kernel edge times: off by %llu uS at most\n", (unsigned long long) kernelMax);
+    printf("stamped on wakeup: off by %llu uS on average, %llu uS at most\n",
+            (unsigned long long) (wakeSum / NUM_STRIPS), (unsigned long long) wakeMax);
+    CHECK("every strip counted", data->motion->retroCount == NUM_STRIPS);
+    CHECK("strip time is the edge time", kernelMax == 0);
+
+    /* The edges going away for good. The retro thread retries, then moves
+     * to sysfs, and flags the retros down if there's no sysfs either */
+    close(p[1]);
+    if (access("/sys/class/gpio/export", W_OK) != 0) {
+        CHECK("edge thread gives up", joinRetroThreads() == 0);
+        CHECK("retros flagged down", data->flags->retroFault);
+    }
+    printf("---End retro edge event test---\n");
+    return checkResult();
+}
+
+#else
+
+int main() {
+    printf("Built without GPIO v2 uAPI headers, nothing to test\n");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,132 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "data.h"
+#include "ring.h"
+#include "check.h"
+
+/* Checks the tsRing_t history buffer: wrapping, windows, clearing, then a
+ * writer pushing as fast as it can while readers check every window they
+ * are handed is a run of consecutive samples. No hardware needed */
+
+#define STRESS_US   1000000
+#define NUM_READERS 2
+
+static tsRing_t shared;
+static volatile bool running;
+
+static void testBasics() {
+    tsRing_t ring;
+    tsWindow_t win;
+    tsSample_t s;
+    int i;
+
+    CHECK("init", tsRingInit(&ring, 5) == 0);
+    CHECK("rounded to a power of two", ring.size == 8);
+    CHECK("empty latest", tsRingLatest(&ring, &s) == -1);
+    CHECK("empty mean", tsRingMean(&ring, 4) == 0);
+
+    for (i = 1; i <= 3; i++) tsRingPush(&ring, i * 100, i);
+    CHECK("count before full", tsRingCount(&ring) == 3);
+    CHECK("mean of fewer than asked", tsRingMean(&ring, 5) == 2);
+    CHECK("latest", tsRingLatest(&ring, &s) == 0 && s.val == 3 && s.time == 300);
+    CHECK("two back", tsRingAt(&ring, 2, &s) == 0 && s.val == 1);
+    CHECK("past the start", tsRingAt(&ring, 3, &s) == -1);
+
+    /* 1..11 pushed, the buffer wraps between 8 and 9 */
+    for (i = 4; i <= 11; i++) tsRingPush(&ring, i * 100, i);
+    CHECK("count when full", tsRingCount(&ring) == 8);
+    CHECK("window capped at size - 1", tsRingWindow(&ring, 100, &win) == 7);
+    CHECK("window wraps", win.len[0] == 4 && win.len[1] == 3);
+    CHECK("window oldest first", win.span[0][0].val == 5 && win.span[1][2].val == 11);
+    CHECK("window valid", tsRingWindowValid(&ring, &win));
+    CHECK("mean of last 4", tsRingMean(&ring, 4) == 9.5);
+
+    /* Writing over the start of a window invalidates it */
+    tsRingWindow(&ring, 7, &win);
+    tsRingPush(&ring, 1200, 12);
+    CHECK("window lapped", !tsRingWindowValid(&ring, &win));
+
+    tsRingClear(&ring);
+    CHECK("cleared", tsRingCount(&ring) == 0 && tsRingLatest(&ring, &s) == -1);
+    tsRingPush(&ring, 1300, 13);
+    CHECK("after clear", tsRingCount(&ring) == 1 && tsRingMean(&ring, 8) == 13);
+    tsRingFree(&ring);
+}
+
+static void *writer(void *arg) {
+    uint64_t i = 0;
+    (void) arg;
+    while (running) {
+        i++;
+        tsRingPush(&shared, i, i);
+    }
+    return NULL;
+}
+
+static void *reader(void *arg) {
+    uint64_t *counts = (uint64_t *) arg;
+    tsWindow_t win;
+    uint32_t n = 1, i, j;
+    bool bad;
+    double last;
+
+    while (running) {
+        n = n % (shared.size - 1) + 1;
+        if (tsRingWindow(&shared, n, &win) == 0) continue;
+        bad = false;
+        last = (double) win.start;
+        for (j = 0; j < 2; j++) {
+            for (i = 0; i < win.len[j]; i++) {
+                const tsSample_t *s = &win.span[j][i];
+                if (s->val != last + 1 || s->time != (uint64_t) s->val) bad = true;
+                last = s->val;
+            }
+        }
+        if (!tsRingWindowValid(&shared, &win)) {
+            counts[1]++;
+        } else {
+            if (bad) counts[2]++;
+            counts[0]++;
+        }
+    }
+    return NULL;
+}
+
+static void testStress() {
+    pthread_t w, r[NUM_READERS];
+    uint64_t counts[NUM_READERS][3] = {{0}};
+    uint64_t good = 0, retries = 0, bad = 0, start;
+    int i;
+
+    tsRingInit(&shared, 64);
+    running = true;
+    pthread_create(&w, NULL, writer, NULL);
+    for (i = 0; i < NUM_READERS; i++) pthread_create(&r[i], NULL, reader, counts[i]);
+    start = getuSTimestamp();
+    while (getuSTimestamp() - start < STRESS_US) usleep(10000);
+    running = false;
+    pthread_join(w, NULL);
+    for (i = 0; i < NUM_READERS; i++) {
+        pthread_join(r[i], NULL);
+        good += counts[i][0];
+        retries += counts[i][1];
+        bad += counts[i][2];
+    }
+    printf("stress: %llu samples pushed, %llu windows read, %llu lapped and retried, %llu bad\n",
+            (unsigned long long) shared.head, (unsigned long long) good,
+            (unsigned long long) retries, (unsigned long long) bad);
+    CHECK("no bad windows", bad == 0);
+    tsRingFree(&shared);
+}
+
+int main() {
+    printf("---Begin ring test---\n");
+    testBasics();
+    testStress();
+    printf("---End ring test---\n");
+    return checkResult();
+}
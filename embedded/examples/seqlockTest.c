@@ -0,0 +1,122 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "data.h"
+
+/* Stress test for the data_t seqlocks. A writer thread keeps updating motion
+ * and pressure so that every field of one update holds the same value, while
+ * readers check that each copy they take is from a single update. Run once
+ * reading data directly, the way everything used to, and once through the
+ * get*Snapshot functions. No hardware needed */
+
+#define RUN_US      1000000
+#define NUM_READERS 2
+#define NUM_TIMED   1000000
+
+extern data_t *data;
+
+static volatile bool running;
+static volatile bool useSnapshots;
+
+static void *writer(void *arg) {
+    uint32_t i = 0;
+    (void) arg;
+    while (running) {
+        i = (i + 1) & 0xFFFFFF;     /* Stays exact in a float */
+        seqWriteBegin(&data->motion->lock);
+        data->motion->pos = i;
+        data->motion->vel = i;
+        data->motion->accel = i;
+        data->motion->retroCount = i;
+        seqWriteEnd(&data->motion->lock);
+
+        seqWriteBegin(&data->pressure->lock);
+        data->pressure->primTank = i;
+        data->pressure->primLine = i;
+        data->pressure->primAct = i;
+        data->pressure->secTank = i;
+        data->pressure->secLine = i;
+        data->pressure->secAct = i;
+        data->pressure->amb = i;
+        data->pressure->pv = i;
+        seqWriteEnd(&data->pressure->lock);
+    }
+    return NULL;
+}
+
+static void *reader(void *arg) {
+    uint64_t *torn = (uint64_t *) arg;
+    motion_t m;
+    pressure_t p;
+    while (running) {
+        if (useSnapshots) {
+            getMotionSnapshot(&m);
+            getPressureSnapshot(&p);
+        } else {
+            m.pos = data->motion->pos;
+            m.vel = data->motion->vel;
+            m.accel = data->motion->accel;
+            m.retroCount = data->motion->retroCount;
+            p.primTank = data->pressure->primTank;
+            p.primAct = data->pressure->primAct;
+            p.secAct = data->pressure->secAct;
+            p.pv = data->pressure->pv;
+        }
+        if (m.pos != m.vel || m.vel != m.accel || m.accel != m.retroCount) torn[0]++;
+        if (p.primTank != p.primAct || p.primAct != p.secAct || p.secAct != p.pv) torn[0]++;
+        torn[1]++;
+    }
+    return NULL;
+}
+
+/* Returns how many of the reads were torn */
+static uint64_t runStress(bool snapshots) {
+    pthread_t w, r[NUM_READERS];
+    uint64_t counts[NUM_READERS][2] = {{0}};
+    uint64_t torn = 0, reads = 0, start;
+    int i;
+
+    useSnapshots = snapshots;
+    running = true;
+    pthread_create(&w, NULL, writer, NULL);
+    for (i = 0; i < NUM_READERS; i++) pthread_create(&r[i], NULL, reader, counts[i]);
+    start = getuSTimestamp();
+    while (getuSTimestamp() - start < RUN_US) usleep(10000);
+    running = false;
+    pthread_join(w, NULL);
+    for (i = 0; i < NUM_READERS; i++) {
+        pthread_join(r[i], NULL);
+        torn += counts[i][0];
+        reads += counts[i][1];
+    }
+    printf("%-9s: %llu reads, %llu torn\n", snapshots ? "snapshot" : "direct",
+            (unsigned long long) reads, (unsigned long long) torn);
+    return torn;
+}
+
+int main() {
+    motion_t m;
+    bms_t b;
+    uint64_t start, i;
+
+    initData();
+    printf("---Begin seqlock stress test, %d readers---\n", NUM_READERS);
+    runStress(false);
+    if (runStress(true) != 0) {
+        fprintf(stderr, "FAIL torn snapshot\n");
+        return 1;
+    }
+
+    /* Uncontended cost of a copy */
+    start = getuSTimestamp();
+    for (i = 0; i < NUM_TIMED; i++) getMotionSnapshot(&m);
+    printf("getMotionSnapshot: %.0f nS\n", (getuSTimestamp() - start) * 1000.0 / NUM_TIMED);
+    start = getuSTimestamp();
+    for (i = 0; i < NUM_TIMED; i++) getBmsSnapshot(&b);
+    printf("getBmsSnapshot:    %.0f nS\n", (getuSTimestamp() - start) * 1000.0 / NUM_TIMED);
+    printf("---End seqlock stress test: PASSED---\n");
+    return 0;
+}
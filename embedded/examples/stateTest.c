@@ -30,6 +30,7 @@
 
 static pthread_t smThread;
 static sem_t smSem;
+static bool bmsSilent = false;    /* Stops the fake BMS from "sending" */
 
 static void genericInit(char *name);
 static void goToState(char *name);
@@ -48,6 +49,8 @@ extern stateMachine_t stateMachine;
  *      Start: Ready         Expected: pre-run fault
  * test3 - Motor controller is overheating
  *      Start: Propulsion    Expected: run fault
+ * test3b - BMS stops sending CAN frames
+ *      Start: Propulsion    Expected: run fault
  * test4 - Missed 5 retro strips in a row
  *      Start: Propulsion    
  * test5 - Pressure vessel is depressurizing
@@ -136,6 +139,25 @@ static int rmsOverheatTest()
     return ASSERT_STATE_IS(RUN_FAULT_NAME);
     }
 
+/* BMS stops sending mid run, the last values it sent are still nominal */
+static int bmsSilentTest()
+    {
+    FREEZE_SM;
+    genericInit("BMS Silent Test");
+    goToState(PROPULSION_NAME);
+    UNFREEZE_SM;
+
+    WAIT(.5);
+
+    if (checkForChange(PROPULSION_NAME) != PASS) return FAIL;
+
+    bmsSilent = true;
+    WAIT(1.5);
+    bmsSilent = false;
+
+    return ASSERT_STATE_IS(RUN_FAULT_NAME);
+    }
+
 /* Missed 5 tape strips in a row */
 static int navMissedRetroTest()
     {
@@ -218,6 +240,9 @@ void *stateMachineLoop()
     while(1)
         {
         sem_wait(&smSem);
+        /* Stands in for the CAN thread, the devices are "alive" each tick */
+        if (!bmsSilent) stampRx(&data->bms->rx, getuSTimestamp());
+        stampRx(&data->rms->rx, getuSTimestamp());
         runStateMachine();
         sem_post(&smSem);
         WAIT(.1);
@@ -241,6 +266,7 @@ int main() {
     RUN_TEST(hvBattSOCLowTest);
     RUN_TEST(hvBattLowVoltTest);
     RUN_TEST(rmsOverheatTest);
+    RUN_TEST(bmsSilentTest);
     RUN_TEST(navMissedRetroTest);
     RUN_TEST(pvDepressurizingTest);
     sem_destroy(&smSem);
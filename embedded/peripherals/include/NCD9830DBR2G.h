@@ -21,8 +21,21 @@
 #define CHANNEL_6    0x3
 #define CHANNEL_7    0x7
 
+#define NCD_NUM_CHANNELS 8
+
+/* One reading of every channel */
+typedef struct ncdScan_t {
+    uint8_t raw[NCD_NUM_CHANNELS];  /* By CHANNEL_x, not 0-7 in pin order */
+    uint64_t time;                  /* uS, halfway through the scan */
+    uint32_t duration;              /* uS from the first select to the last read */
+} ncdScan_t;
 
 int readPressureSensor(int sensor, uint8_t channel, uint8_t *data);
+
+/* Reads all eight channels in one I2C transaction, selecting each and
+ * reading it back with repeated starts and no stops between, so they're
+ * sampled as close together as the bus allows and share one time */
+int scanPressureSensor(int sensor, ncdScan_t *scan);
 int initPressureSensors(void);
 
 
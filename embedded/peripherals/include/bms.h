@@ -3,8 +3,11 @@
 
 #include <stdint.h>
 
+#define BMS_CELL_ID     0x036
+
 int bmsClearFaults();
 int bmsParseMsg(uint32_t id, uint8_t *msg);
+void bmsRegisterCan();
 void bmsDump();
 void dumpCells();
 #endif
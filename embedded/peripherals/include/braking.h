@@ -1,5 +1,6 @@
 #include <NCD9830DBR2G.h>
-#include <semaphore.h>
+#include <stdint.h>
+#include <ring.h>
 #define PS_TANK     CHANNEL_0
 #define PS_LINE     CHANNEL_1
 #define PS_ACTUATE  CHANNEL_2
@@ -10,7 +11,21 @@
 #define BS_LINE     CHANNEL_7
 #define BS_ACTUATE  CHANNEL_6
 
-extern sem_t bigSem;
+/* Channels of raw pressure history kept by pressureMonitor */
+enum {
+    PRES_PRIM_TANK,
+    PRES_PRIM_LINE,
+    PRES_PRIM_ACT,
+    PRES_SEC_TANK,
+    PRES_SEC_LINE,
+    PRES_SEC_ACT,
+    PRES_AMB,
+    PRES_PV,
+    NUM_PRES_CHANNELS
+};
+
+/* Every raw reading of a channel, stamped when it was sampled */
+const tsRing_t *getPressureHistory(int channel);
 
 double readAmbientPressure(void);
 
@@ -26,8 +41,16 @@ double readSecLine(void);
 
 double readSecActuator(void);
 
+/* pressureSampler scans the ADC on a fixed period and hands each scan to
+ * pressureMonitor, which does the filtering and publishing. Neither holds a
+ * lock the brakes need */
+void *pressureSampler(void *arg);
+
 void *pressureMonitor(void);
 
+/* Scans skipped because pressureMonitor was too far behind */
+uint64_t getPressureScansDropped(void);
+
 int initPressureMonitor(void);
 
 void showPressures(void);
@@ -2,10 +2,28 @@
 #define CANDEVICES_H
 
 #include <semaphore.h>
+#include "can.h"
 
 extern sem_t canSem;
 
+/* Decodes one frame for a registered ID, returns 0 if it was understood */
+typedef int (*canHandler_t)(uint32_t id, uint8_t *data);
+
+/* Kept per CAN ID by the dispatcher, all times in uS */
+typedef struct canIdStats_t {
+    uint32_t count;
+    uint64_t lastSeen;      /* Kernel receive time of the latest frame */
+    uint64_t period;        /* Time between the latest two frames */
+    uint64_t jitter;        /* Smoothed change in period */
+} canIdStats_t;
+
+int canRegisterHandler(uint32_t firstId, uint32_t lastId, canHandler_t handler);
+const canIdStats_t *canGetIdStats(uint32_t id);
+uint32_t canGetUnhandledCount(void);
+uint64_t canFrameRxTime(void);
+
 void SetupCANDevices();
 void *CANLoop(void *arg);
+int rx_recv(canFrameTs_t *batch);
 
 #endif
@@ -0,0 +1,233 @@
+#ifndef __CAN_SIGNALS_H__
+#define __CAN_SIGNALS_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <float.h>
+#include "data.h"
+#include "can_devices.h"
+
+/***
+ * CAN signal database
+ *
+ * Every value we pull out of a CAN frame is described once in the tables at
+ * the bottom of this file, DBC style. The tables are X-macros, so bms.c and
+ * rms.c expand them into one decode function per message ID with all of the
+ * offsets, masks and scales as constants. If a scale is wrong, this is the
+ * only place it needs fixing.
+ *
+ * Each signal is described as:
+ *
+ *  SIG(group, field, start, len, endian, sign, scale, offset, min, max)
+ *
+ *      group  - which part of data_t it lands in (bms, rms)
+ *      field  - the member of that struct
+ *      start  - bit position of the signal in the payload. For CAN_LE it
+ *               counts from the LSB of byte 0, for CAN_BE from the MSB of
+ *               byte 0, so byte N always starts at bit N * 8
+ *      len    - length in bits
+ *      endian - CAN_LE (first byte least significant) or CAN_BE
+ *      sign   - CAN_UNSIGNED or CAN_SIGNED (two's complement), should match
+ *               the signedness of field
+ *      scale  - physical = raw * scale + offset
+ *      min    - decoded values outside of [min, max] are thrown away and
+ *      max      the field keeps its last good value
+ *
+ * Messages are lists of signals, hooked up to their ID and group in the
+ * *_MESSAGES tables. Decoding any message of a group stamps that group's
+ * rxStamp_t with the frame's receive time, see isStale() in data.h. A
+ * message with no signals is still "decoded", we just don't use anything in
+ * it yet, but it does show the device is alive. Multiplexed messages (e.g.
+ * BMS cell voltages) don't fit this format and are still handled by hand in
+ * the device file.
+ */
+
+#define CAN_LE          0
+#define CAN_BE          1
+#define CAN_UNSIGNED    0
+#define CAN_SIGNED      1
+#define CAN_NO_MIN      (-DBL_MAX)
+#define CAN_NO_MAX      (DBL_MAX)
+
+static inline uint64_t canLoadLE(const uint8_t *msg) {
+    return (uint64_t) msg[0]         | (uint64_t) msg[1] << 8  |
+           (uint64_t) msg[2] << 16   | (uint64_t) msg[3] << 24 |
+           (uint64_t) msg[4] << 32   | (uint64_t) msg[5] << 40 |
+           (uint64_t) msg[6] << 48   | (uint64_t) msg[7] << 56;
+}
+
+static inline uint64_t canLoadBE(const uint8_t *msg) {
+    return (uint64_t) msg[0] << 56   | (uint64_t) msg[1] << 48 |
+           (uint64_t) msg[2] << 40   | (uint64_t) msg[3] << 32 |
+           (uint64_t) msg[4] << 24   | (uint64_t) msg[5] << 16 |
+           (uint64_t) msg[6] << 8    | (uint64_t) msg[7];
+}
+
+#define CAN_SIG_MASK(len)   ((len) >= 64 ? ~0ULL : ((1ULL << (len)) - 1))
+
+/* Raw bits of a signal, le/be are the payload already loaded both ways */
+#define CAN_SIG_RAW(le, be, start, len, endian) \
+    ((endian) == CAN_LE ? (((le) >> (start)) & CAN_SIG_MASK(len)) \
+                        : (((be) >> (64 - (start) - (len))) & CAN_SIG_MASK(len)))
+
+/* Sign extends raw when the signal is signed, all math is done in double */
+#define CAN_SIG_PHYS(raw, len, sign, scale, offset) \
+    (((sign) == CAN_SIGNED ? \
+        (double) ((int64_t) ((raw) << (64 - (len))) >> (64 - (len))) : \
+        (double) (raw)) * (scale) + (offset))
+
+#ifdef CAN_SIGNAL_DEBUG
+#include <stdio.h>
+#define CAN_SIGNAL_PRINT(group, field) \
+    printf(#group "." #field ": %f\r\n", (double) data->group->field);
+#else
+#define CAN_SIGNAL_PRINT(group, field)
+#endif
+
+/* Expands a single signal into the statements that decode it */
+#define CAN_DECODE_SIGNAL(group, field, start, len, endian, sign, scale, offset, min, max) \
+    { \
+        double _val = CAN_SIG_PHYS(CAN_SIG_RAW(_le, _be, start, len, endian), len, sign, scale, offset); \
+        if (_val >= (min) && _val <= (max)) data->group->field = _val; \
+        CAN_SIGNAL_PRINT(group, field) \
+    }
+
+/* Defines static int canDecode_<id>(uint32_t id, uint8_t *msg), which matches
+ * canHandler_t so it can go straight into the dispatch table */
+#define CAN_DEFINE_DECODER(id, group, SIGNALS) \
+    static int canDecode_##id(uint32_t _id, uint8_t *msg) { \
+        uint64_t _le = canLoadLE(msg); \
+        uint64_t _be = canLoadBE(msg); \
+        (void) _id; (void) _le; (void) _be; \
+        seqWriteBegin(&data->group->lock); \
+        SIGNALS(CAN_DECODE_SIGNAL) \
+        stampRx(&data->group->rx, canFrameRxTime()); \
+        seqWriteEnd(&data->group->lock); \
+        return 0; \
+    }
+
+/* For building a switch over every message in a table */
+#define CAN_DECODER_CASE(id, group, SIGNALS) \
+    case id: canDecode_##id(id, msg); break;
+
+/* Hands each message's decoder to the CAN dispatcher */
+#define CAN_REGISTER_DECODER(id, group, SIGNALS) \
+    canRegisterHandler(id, id, canDecode_##id);
+
+#define CAN_NO_SIGNALS(SIG)
+
+
+/***
+ * BMS - Orion BMS broadcast messages
+ */
+
+#define BMS_MSG_0x150(SIG) \
+    SIG(bms, packAh,          32, 16, CAN_LE, CAN_UNSIGNED, 1,      0, CAN_NO_MIN, CAN_NO_MAX) \
+    SIG(bms, highTemp,        48,  8, CAN_LE, CAN_UNSIGNED, 1,      0, CAN_NO_MIN, CAN_NO_MAX) \
+    SIG(bms, lowTemp,         56,  8, CAN_LE, CAN_UNSIGNED, 1,      0, CAN_NO_MIN, CAN_NO_MAX)
+
+#define BMS_MSG_0x650(SIG) \
+    SIG(bms, Soc,              0,  8, CAN_LE, CAN_UNSIGNED, 0.5,    0, CAN_NO_MIN, CAN_NO_MAX) \
+    SIG(bms, packResistance,   8, 16, CAN_LE, CAN_UNSIGNED, 1,      0, CAN_NO_MIN, CAN_NO_MAX) \
+    SIG(bms, packHealth,      24,  8, CAN_LE, CAN_UNSIGNED, 1,      0, CAN_NO_MIN, CAN_NO_MAX) \
+    SIG(bms, packOpenVoltage, 32, 16, CAN_LE, CAN_UNSIGNED, 0.1,    0, CAN_NO_MIN, CAN_NO_MAX) \
+    SIG(bms, packCycles,      48, 16, CAN_LE, CAN_UNSIGNED, 1,      0, CAN_NO_MIN, CAN_NO_MAX)
+
+#define BMS_MSG_0x651(SIG) \
+    SIG(bms, maxCells,        48,  8, CAN_LE, CAN_UNSIGNED, 1,      0, CAN_NO_MIN, CAN_NO_MAX) \
+    SIG(bms, numCells,        56,  8, CAN_LE, CAN_UNSIGNED, 1,      0, CAN_NO_MIN, CAN_NO_MAX)
+
+#define BMS_MSG_0x652(SIG) \
+    SIG(bms, packCCL,          0, 16, CAN_LE, CAN_SIGNED,   1,      0, CAN_NO_MIN, CAN_NO_MAX) \
+    SIG(bms, packDCL,         16, 16, CAN_LE, CAN_UNSIGNED, 1,      0, CAN_NO_MIN, CAN_NO_MAX)
+
+#define BMS_MSG_0x653(SIG) \
+    SIG(bms, relayStatus,      0,  8, CAN_LE, CAN_UNSIGNED, 1,      0, CAN_NO_MIN, CAN_NO_MAX) \
+    SIG(bms, inputVoltage,    16, 16, CAN_LE, CAN_UNSIGNED, 0.1,    0, CAN_NO_MIN, CAN_NO_MAX)
+
+#define BMS_MSG_0x6B0(SIG) \
+    SIG(bms, packCurrent,      0, 16, CAN_BE, CAN_UNSIGNED, 0.1,    0, CAN_NO_MIN, CAN_NO_MAX) \
+    SIG(bms, packVoltage,     16, 16, CAN_BE, CAN_UNSIGNED, 0.1,    0, CAN_NO_MIN, CAN_NO_MAX) \
+    SIG(bms, Soc,             32,  8, CAN_BE, CAN_UNSIGNED, 0.5,    0, CAN_NO_MIN, CAN_NO_MAX) \
+    SIG(bms, cellMaxVoltage,  40, 16, CAN_BE, CAN_UNSIGNED, 0.0001, 0, CAN_NO_MIN, CAN_NO_MAX)
+
+#define BMS_MSG_0x6B1(SIG) \
+    SIG(bms, packDCL,          0, 16, CAN_BE, CAN_UNSIGNED, 1,      0, CAN_NO_MIN, CAN_NO_MAX) \
+    SIG(bms, highTemp,        32,  8, CAN_BE, CAN_UNSIGNED, 1,      0, CAN_NO_MIN, CAN_NO_MAX)
+
+#define BMS_MSG_0x6B2(SIG) \
+    SIG(bms, cellMinVoltage,   0, 16, CAN_BE, CAN_UNSIGNED, 0.0001, 0, CAN_NO_MIN, CAN_NO_MAX) \
+    SIG(bms, avgTemp,         16,  8, CAN_BE, CAN_UNSIGNED, 1,      0, CAN_NO_MIN, CAN_NO_MAX) \
+    SIG(bms, imdStatus,       24,  8, CAN_BE, CAN_UNSIGNED, 1,      0, CAN_NO_MIN, CAN_NO_MAX)
+
+#define BMS_MESSAGES(MSG) \
+    MSG(0x150, bms, BMS_MSG_0x150) \
+    MSG(0x650, bms, BMS_MSG_0x650) \
+    MSG(0x651, bms, BMS_MSG_0x651) \
+    MSG(0x652, bms, BMS_MSG_0x652) \
+    MSG(0x653, bms, BMS_MSG_0x653) \
+    MSG(0x6B0, bms, BMS_MSG_0x6B0) \
+    MSG(0x6B1, bms, BMS_MSG_0x6B1) \
+    MSG(0x6B2, bms, BMS_MSG_0x6B2)
+
+
+/***
+ * RMS - motor controller broadcast messages, all little endian
+ */
+
+#define RMS_MSG_0xA0(SIG) \
+    SIG(rms, igbtTemp,             0, 16, CAN_LE, CAN_UNSIGNED, 0.1,  0, CAN_NO_MIN, CAN_NO_MAX) \
+    SIG(rms, gateDriverBoardTemp, 48, 16, CAN_LE, CAN_UNSIGNED, 0.1,  0, CAN_NO_MIN, CAN_NO_MAX)
+
+#define RMS_MSG_0xA1(SIG) \
+    SIG(rms, controlBoardTemp,     0, 16, CAN_LE, CAN_UNSIGNED, 0.1,  0, CAN_NO_MIN, CAN_NO_MAX)
+
+/* Motor temp sensor glitches high every so often, anything over 300 C is noise */
+#define RMS_MSG_0xA2(SIG) \
+    SIG(rms, motorTemp,           32, 16, CAN_LE, CAN_UNSIGNED, 0.1,  0, CAN_NO_MIN, 300)
+
+#define RMS_MSG_0xA5(SIG) \
+    SIG(rms, motorSpeed,          16, 16, CAN_LE, CAN_SIGNED,   1,    0, CAN_NO_MIN, CAN_NO_MAX) \
+    SIG(rms, electricalFreq,      32, 16, CAN_LE, CAN_UNSIGNED, 0.1,  0, CAN_NO_MIN, CAN_NO_MAX)
+
+#define RMS_MSG_0xA6(SIG) \
+    SIG(rms, phaseACurrent,        0, 16, CAN_LE, CAN_SIGNED,   0.1,  0, CAN_NO_MIN, CAN_NO_MAX) \
+    SIG(rms, dcBusCurrent,        48, 16, CAN_LE, CAN_SIGNED,   0.1,  0, CAN_NO_MIN, CAN_NO_MAX)
+
+#define RMS_MSG_0xA7(SIG) \
+    SIG(rms, dcBusVoltage,         0, 16, CAN_LE, CAN_SIGNED,   0.1,  0, CAN_NO_MIN, CAN_NO_MAX)
+
+#define RMS_MSG_0xA9(SIG) \
+    SIG(rms, lvVoltage,           48, 16, CAN_LE, CAN_UNSIGNED, 0.01, 0, CAN_NO_MIN, CAN_NO_MAX)
+
+#define RMS_MSG_0xAA(SIG) \
+    SIG(rms, canCode1,             0, 32, CAN_LE, CAN_UNSIGNED, 1,    0, CAN_NO_MIN, CAN_NO_MAX) \
+    SIG(rms, canCode2,            32, 32, CAN_LE, CAN_UNSIGNED, 1,    0, CAN_NO_MIN, CAN_NO_MAX)
+
+#define RMS_MSG_0xAB(SIG) \
+    SIG(rms, faultCode1,           0, 32, CAN_LE, CAN_UNSIGNED, 1,    0, CAN_NO_MIN, CAN_NO_MAX) \
+    SIG(rms, faultCode2,          32, 32, CAN_LE, CAN_UNSIGNED, 1,    0, CAN_NO_MIN, CAN_NO_MAX)
+
+#define RMS_MSG_0xAC(SIG) \
+    SIG(rms, commandedTorque,      0, 16, CAN_LE, CAN_SIGNED,   0.1,  0, CAN_NO_MIN, CAN_NO_MAX) \
+    SIG(rms, actualTorque,        16, 16, CAN_LE, CAN_SIGNED,   0.1,  0, CAN_NO_MIN, CAN_NO_MAX)
+
+#define RMS_MESSAGES(MSG) \
+    MSG(0xA0, rms, RMS_MSG_0xA0) \
+    MSG(0xA1, rms, RMS_MSG_0xA1) \
+    MSG(0xA2, rms, RMS_MSG_0xA2) \
+    MSG(0xA3, rms, CAN_NO_SIGNALS) \
+    MSG(0xA4, rms, CAN_NO_SIGNALS) \
+    MSG(0xA5, rms, RMS_MSG_0xA5) \
+    MSG(0xA6, rms, RMS_MSG_0xA6) \
+    MSG(0xA7, rms, RMS_MSG_0xA7) \
+    MSG(0xA8, rms, CAN_NO_SIGNALS) \
+    MSG(0xA9, rms, RMS_MSG_0xA9) \
+    MSG(0xAA, rms, RMS_MSG_0xAA) \
+    MSG(0xAB, rms, RMS_MSG_0xAB) \
+    MSG(0xAC, rms, RMS_MSG_0xAC) \
+    MSG(0xAD, rms, CAN_NO_SIGNALS) \
+    MSG(0xAE, rms, CAN_NO_SIGNALS) \
+    MSG(0xAF, rms, CAN_NO_SIGNALS)
+
+#endif
@@ -11,6 +11,7 @@
 #define DATA_REG 0x06
 
 #include <semaphore.h> 
+#include <stdbool.h>
 
 typedef struct {
 	//Delta velocity
@@ -39,6 +40,8 @@ typedef struct {
 
 void SetupIMU();
 void *IMULoop(void *arg);
+/* True once SetupIMU() has got the IMU going, the getters need it */
+bool IMUReady();
 
 void getPosData(float *fData);
 float getPosX();
@@ -34,7 +34,22 @@ static const char IODIRA    = 0x00;
 static const char IODIRB    = 0x01;
 static const char GPIOA     = 0x12;
 static const char GPIOB     = 0x13;
+static const char OLATA     = 0x14;
+static const char OLATB     = 0x15;
 
+/* For the calls that take a bit per pin */
+#define MCP_PIN(pin)    (1 << (pin))
+
+/***
+ * Every expander has a shadow of its IODIR and OLAT registers, shared by all
+ * the i2c_settings for the same bus and address. Directions and outputs are
+ * looked up there instead of read off the chip, and a write only goes out if
+ * it changes something. The shadow is filled in by clearSettingsMCP(), or the
+ * first time it's needed with one sequential read of every register. That
+ * and reading both GPIO banks together rely on IOCON being left at its
+ * power on value. If something else (like bloopGpio) may have changed the
+ * chip, refreshMCP() reads it again.
+ */
 int setupMCP(i2c_settings *i2c, char mcpAddress);
 
 int clearSettingsMCP(i2c_settings *i2c);
@@ -47,4 +62,17 @@ int getDir(i2c_settings *i2c, uint8_t pin);
 
 int setDir(i2c_settings *i2c, uint8_t pin, bool val);
 
+/* Sets the direction of every pin in pins at once, dirs has a 1 (MCP_DIR_IN)
+ * for inputs. At most one write */
+int setDirs(i2c_settings *i2c, uint16_t pins, uint16_t dirs);
+
+/* Sets every output in pins to its bit of vals, at most one write. Fails
+ * without writing if any of pins is an input */
+int setStates(i2c_settings *i2c, uint16_t pins, uint16_t vals);
+
+/* All 16 pins in one read, A in the low byte. -1 on error */
+int getStates(i2c_settings *i2c);
+
+int refreshMCP(i2c_settings *i2c);
+
 #endif
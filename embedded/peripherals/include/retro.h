@@ -16,7 +16,14 @@
 #define RETRO_2			1
 #define RETRO_3			2
 
+/* Watches all the retros from one thread with kernel edge times if the
+ * gpiochip supports it, otherwise one sysfs thread per retro */
 int initRetros(void);
 int joinRetroThreads(void);
 
+/* Runs the retros off edges read from fd in struct gpio_v2_line_event
+ * format, at the line offsets of the RETRO_*_PIN, for testing without
+ * hardware */
+int initRetrosFromFd(int fd);
+
 #endif
@@ -36,4 +36,7 @@ int rmsInvEnNoTorque();
 /* Handles parsing of all recieved CAN messages */
 int rms_parser(uint32_t id, uint8_t *data, uint32_t filter);
 
+/* Registers rms_parser() with the CAN dispatcher */
+void rmsRegisterCan();
+
 #endif
@@ -23,7 +23,6 @@ i2c_settings adc0    = {
 
 i2c_settings *adcs[2];
 
-static int selectChannel(uint8_t devNum, uint8_t channel);
 static int readChannel(uint8_t devNum, uint8_t channel, uint8_t *data);
 
 int readPressureSensor(int sensor, uint8_t channel, uint8_t *data) {
@@ -35,7 +34,8 @@ int readPressureSensor(int sensor, uint8_t channel, uint8_t *data) {
 }
 
 
-static int selectChannel(uint8_t devNum, uint8_t channel) {
+/* Selects the channel and reads its conversion in one transaction */
+static int readChannel(uint8_t devNum, uint8_t channel, uint8_t *data) {
     if (channel > 7) {
         fprintf(stderr, "Invalid channel, must be 0-7.\n");
         return -1;
@@ -44,21 +44,35 @@ static int selectChannel(uint8_t devNum, uint8_t channel) {
     uint8_t cmdByte = 0;
     cmdByte = SD_BIT | CHANNEL(channel) | PD_BITS;
 
-    if (write_byte_i2c(adcs[devNum], cmdByte) != 0) {
-        fprintf(stderr, "Failed to write channel select byte: %#x\n", cmdByte);
+    if (write_read_i2c(adcs[devNum], &cmdByte, 1, data, 1) != 0) {
+        fprintf(stderr, "Failed to read channel %d from ADC %d.\n", channel, devNum);
         return -1;
     }
-
     return 0;
 }
 
-static int readChannel(uint8_t devNum, uint8_t channel, uint8_t *data) {
-   selectChannel(devNum, channel);
-   if (read_i2c((i2c_settings *)adcs[devNum], data, 1) != 0) {
-       fprintf(stderr, "Failed to read data from ADC %d.\n", devNum);
-       return -1;
-   }
-   return 0;
+int scanPressureSensor(int sensor, ncdScan_t *scan) {
+    struct i2c_msg msgs[2 * NCD_NUM_CHANNELS];
+    uint8_t cmds[NCD_NUM_CHANNELS];
+    uint64_t start, end;
+    int ch;
+
+    for (ch = 0; ch < NCD_NUM_CHANNELS; ch++) {
+        cmds[ch] = SD_BIT | CHANNEL(ch) | PD_BITS;
+        msgs[2 * ch].flags = 0;
+        msgs[2 * ch].len = 1;
+        msgs[2 * ch].buf = (char *) &cmds[ch];
+        msgs[2 * ch + 1].flags = I2C_M_RD;
+        msgs[2 * ch + 1].len = 1;
+        msgs[2 * ch + 1].buf = (char *) &scan->raw[ch];
+    }
+    if (i2cTransferTimed(adcs[sensor], msgs, 2 * NCD_NUM_CHANNELS, &start, &end) != 0) {
+        fprintf(stderr, "Failed to scan ADC %d.\n", sensor);
+        return -1;
+    }
+    scan->time = start + (end - start) / 2;
+    scan->duration = end - start;
+    return 0;
 }
 
 int initPressureSensors() {
@@ -68,6 +82,8 @@ int initPressureSensors() {
         fprintf(stderr, "Failed to open i2c bus for pressure sensor 1.\n");
         return -1;
     }
+    /* Braking decisions wait on these */
+    i2cSetPriority(&adc0, I2C_PRIO_HIGH);
 
 /*	adcs[1] = &adc1; 
     NOT ON THE BUS
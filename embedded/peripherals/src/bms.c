@@ -4,6 +4,11 @@
 #include "bms.h"
 #include "can.h"
 #include "data.h"
+#include "can_devices.h"
+#ifdef DEBUG_BMS
+#define CAN_SIGNAL_DEBUG
+#endif
+#include "can_signals.h"
 
 extern data_t *data;
 float cells[72] = {0};
@@ -27,8 +32,24 @@ int bmsClearFaults(void){
 
 	return 0;
 }
+/* Defines canDecode_<id>() for every message in the BMS signal table */
+BMS_MESSAGES(CAN_DEFINE_DECODER)
+
+/* Cell voltages are multiplexed on the first byte, so they are done by hand */
+static int bmsDecodeCells(uint32_t id, uint8_t *msg) {
+    (void) id;
+    if (msg[0] >= 72) return -1;
+    cells[msg[0]] = (msg[2] | (msg[1] << 8)) / 10000.0;
+    seqWriteBegin(&data->bms->lock);
+    stampRx(&data->bms->rx, canFrameRxTime());
+    seqWriteEnd(&data->bms->lock);
+    return 0;
+}
+
 /**
   * Receives a CAN Message and updates global BMS_Data struct
+  *
+  * Returns 1 if the message was a BMS message, 0 otherwise
   */
 int bmsParseMsg(uint32_t id, uint8_t *msg) {
 #if 0 /*DEBUG_BMS*/
@@ -37,127 +58,24 @@ int bmsParseMsg(uint32_t id, uint8_t *msg) {
     printf("Data: %d, %d, %d, %d, %d, %d, %d\n", msg[0], msg[1], msg[2], 
 	    msg[3], msg[4], msg[5], msg[6]);
 #endif
-    bms_t *bms = data->bms;
 	switch(id) {
-		case 0x6B0:		
-            bms->packCurrent = msg[1] | msg[0] << 8;
-			bms->packCurrent /= 10;
-			bms->packVoltage = msg[3] | msg[2] << 8;
-			bms->packVoltage /= 10;
-			bms->Soc = msg[4]/2;
-			bms->relayStatus = msg[6] | msg[5] << 8;
-            bms->cellMaxVoltage = ((msg[5] << 8)| msg[6]) /10000.0;
-#ifdef DEBUG_BMS
-			printf("V: %f\r\n", bms->packVoltage);
-			printf("A: %f\r\n", bms->packCurrent);
-			printf("Soc: %d\r\n", bms->Soc);
-			printf("Relay: %d\r\n", bms->relayStatus);
-#endif
-            break;
-		case 0x6B1:
-			bms->packDCL = msg[1] | msg[0] << 8;
-			bms->highTemp = msg[4];
-/*			bms->cellMinVoltage = (msg[7] | (msg[6] << 8)) / 10000.0;*/
-#ifdef DEBUG_BMS
-            printf("DCL: %d\r\n", bms->packDCL);
-			printf("High T: %d\r\n", bms->highTemp);
-			printf("Low T: %d\r\n", bms->lowTemp);
-#endif
-			break;
-		case 0x653:
-/*			printf("ID: 0x%3lx\r\n", (long unsigned int) id);*/
-			bms->relayStatus = msg[1] | msg[0] << 8;
-			bms->relayStatus = msg[0];
-			bms->inputVoltage = msg[2] | (msg[3] << 8);
-			bms->inputVoltage /= 10;
-#ifdef DEBUG_BMS
-            printf("Relay status %d\r\n", bms->relayStatus);
-			printf("Input Source Supply Voltage: %f\r\n", bms->inputVoltage);
-#endif
-            break;
-		case 0x652:
-
-			bms->packCCL = msg[0] | (msg[1] << 8);
-			bms->packDCL = msg[2] | (msg[3] << 8);
-/*			bms->cellMaxVoltage = msg[4] | (msg[5] << 8);*/
-/*			bms->cellMaxVoltage /= 10000;*/
-/*			bms->cellMinVoltage = msg[6] | (msg[7] << 8);*/
-/*			bms->cellMinVoltage /= 10000;*/
-#ifdef DEBUG_BMS
-            printf("DCL %d\r\n", bms->packDCL);
-			printf("Cell Min V:  %d, Cell Max V: %d\r\n", bms->cellMinVoltage, bms->cellMaxVoltage);
-#endif
-            break;
-		case 0x651:
-/*			bms->cellMaxVoltage = msg[2] | (msg[3] << 8);*/
-/*			bms->cellMinVoltage = msg[0] | (msg[1] << 8);*/
-/*			bms->cellAvgVoltage = msg[5] | (msg[4] << 8);*/
-/*			bms->cellAvgVoltage /= 1000;*/
-/*			bms->cellMaxVoltage /= 1000;*/
-/*			bms->cellMinVoltage /= 1000;*/
-			bms->maxCells = msg[6];
-			bms->numCells = msg[7];
-#ifdef DEBUG_BMS
-			printf("Num Cells %d\r\n", bms->numCells);
-			printf("Cell Avg V:  %d\r\n", bms->cellAvgVoltage);
-			printf("Cell Min V:  %d, Cell Max V: %d\r\n", bms->cellMinVoltage, bms->cellMaxVoltage);
-#endif
-            break;
-		case 0x650:
-
-			bms->Soc = msg[0];
-			bms->Soc /= 2;
-			bms->packResistance = msg[1] | (msg[2] << 8);
-			bms->packHealth = msg[3];
-			bms->packOpenVoltage = msg[4] | (msg[5] << 8);
-			bms->packOpenVoltage /= 10;
-			bms->packCycles = msg[6] | (msg[7] << 8);
-#ifdef DEBUG_BMS
-			printf("SOC %d\r\n", bms->Soc);
-			printf("Pack Resistance %d\r\n", bms->packResistance);
-			printf("Pack Health %d\r\n", bms->packHealth);
-			printf("Pack Open Voltage  %f\r\n", bms->packOpenVoltage);
-            printf("Pack Cycles  %d\r\n", bms->packCycles);
-#endif
-            break;
-		case 0x150:
-
-/*			bms->avgTemp = msg[0];*/
-			bms->packCurrent /= 10;
-/*            bms->cellMinVoltage = ((msg[3] << 8) | msg[4]) / 10000.0;*/
-/*			bms->packVoltage = msg[2] | (msg[3] << 8);*/
-/*			bms->packVoltage /= 10;*/
-			bms->packAh = msg[4] | (msg[5] << 8);
-			bms->highTemp = msg[6];
-			bms->lowTemp = msg[7];
-#ifdef DEBUG_BMS
-			printf("Pack Current %f\r\n", bms->packCurrent);
-			printf("Pack Voltage  %f\r\n", bms->packVoltage);
-			printf("Pack Amp Hours  %d\r\n", bms->packAh);
-			printf("High Temp  %d\r\n", bms->highTemp);
-            printf("Low Temp  %d\r\n", bms->lowTemp);
-#endif
-            break;
-        case 0x6b2:
-            data->bms->cellMinVoltage = ((msg[0] << 8) | msg[1]) / 10000.0;
-/*            data->bms->cellMaxVoltage = ((msg[2] << 8) | msg[3]) / 10000;*/
-            bms->avgTemp = msg[2];
-            bms->imdStatus = msg[3];
-            break;
+        BMS_MESSAGES(CAN_DECODER_CASE)
 		case 0x80:
 			break;
-        case 0x36:
-            if (msg[0] >= 0 && msg[0] < 72)
-                cells[msg[0]] = (msg[2] | (msg[1] << 8)) / 10000.0;
-             
-        
+        case BMS_CELL_ID:
+            return bmsDecodeCells(id, msg) == 0;
         default:
 			return 0;
-        
     }
 	return 1;
 }
 
+/* Hooks every ID bmsParseMsg() decodes into the CAN dispatcher */
+void bmsRegisterCan() {
+    BMS_MESSAGES(CAN_REGISTER_DECODER)
+    canRegisterHandler(BMS_CELL_ID, BMS_CELL_ID, bmsDecodeCells);
+}
+
 void bmsDump () {
     bms_t *bms = data->bms;
     printf("---BMS DATA---\n");
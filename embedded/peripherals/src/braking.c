@@ -1,6 +1,8 @@
 #include <NCD9830DBR2G.h>
 #include <braking.h>
 #include <data.h>
+#include <mcFilter.h>
+#include <periodic.h>
 #include <stdio.h>
 #include <lv_iox.h>
 #include <pthread.h>
@@ -11,19 +13,36 @@
 #define CURRENT_500_SCALING(x)  ( ((((x / 256.0) * 5.0) - 0.6) / 2.4) * 500.0)
 #define CURRENT_50_SCALING(x)   ( ((((x / 256.0) * 5.0) - 0.6) / 2.4) * 50.0)
 
-#define RING_SIZE  200
+#define HISTORY    256         /* Samples kept, a little over 5 S */
 #define LOOP_PERIOD 20000
+#define SCAN_QUEUE  8           /* Scans the sampler can get ahead by, a power of 2 */
 
-static double avgDouble(double *arr, int size);
 double readPressureVessel();
 
 double readPressureVessel(); 
 static pthread_t presMonThread;
+static pthread_t samplerThread;
 
-sem_t bigSem;
+/* Sampler to monitor handoff. There's one of each, so the two indices are
+ * all the synchronisation it needs, and the sampler never waits on the
+ * monitor. scansReady only wakes the monitor up */
+static ncdScan_t scans[SCAN_QUEUE];
+static uint32_t scanHead, scanTail;
+static uint64_t scansDropped;
+static sem_t scansReady;
+
+static tsRing_t history[NUM_PRES_CHANNELS];
+static mcfMa_t average;   /* Over MCF_MA_WINDOW samples, 4 S */
+
+_Static_assert(NUM_PRES_CHANNELS == MCF_CHANNELS, "one filter channel per transducer");
 
 int initPressureMonitor() {
-    sem_init(&bigSem, 0, 1);
+    int i;
+    sem_init(&scansReady, 0, 0);
+    mcfMaInit(&average);
+    for (i = 0; i < NUM_PRES_CHANNELS; i++) {
+        if (tsRingInit(&history[i], HISTORY) != 0) return (-1);
+    }
     if (initPressureSensors() != 0) {
         fprintf(stderr, "Failed to init ADCs\n");
         return (-1);
@@ -32,69 +51,115 @@ int initPressureMonitor() {
         fprintf(stderr, "Failed to init pressure monitor\n");
         return (-1);
     }
+    if (pthread_create(&samplerThread, NULL, pressureSampler, NULL) != 0) {
+        fprintf(stderr, "Failed to init pressure sampler\n");
+        return (-1);
+    }
     return 0;
 }
 
-void *pressureMonitor() {
-    double primTankRing[RING_SIZE];
-    double primLineRing[RING_SIZE];
-    double primActRing[RING_SIZE];
+uint64_t getPressureScansDropped() {
+    return __atomic_load_n(&scansDropped, __ATOMIC_RELAXED);
+}
 
-    double secTankRing[RING_SIZE];
-    double secLineRing[RING_SIZE];
-    double secActRing[RING_SIZE];
+const tsRing_t *getPressureHistory(int channel) {
+    if (channel < 0 || channel >= NUM_PRES_CHANNELS) return NULL;
+    return &history[channel];
+}
+
+/* Keeps the raw reading and queues it for the average */
+static inline void sample(mcfVec_t *in, int channel, uint64_t now, double val) {
+    tsRingPush(&history[channel], now, val);
+    in->ch[channel] = val;
+}
 
-    double ambRing[RING_SIZE];
+/* Raw ADC counts to psi for each kind of transducer */
+static inline double tankPsi(uint8_t raw) {
+    return VOLTAGE_2000_SCALING((double) raw);
+}
 
-    double pvRing[RING_SIZE];
+static inline double linePsi(uint8_t raw) {
+    return CURRENT_500_SCALING((double) raw);
+}
 
-    uint64_t i = 0;
+static inline double lowPsi(uint8_t raw) {
+    return CURRENT_50_SCALING((double) raw);
+}
+
+/* Only talks to the ADC. Takes no locks, so nothing else ever waits on it
+ * for longer than the I2C transfer it has on the bus */
+void *pressureSampler(void *arg) {
+    periodic_t task;
+    uint32_t head;
+    (void) arg;
+    periodicInit(&task, "pressure", LOOP_PERIOD);
+    while(1) {
+        head = scanHead;
+        if (head - __atomic_load_n(&scanTail, __ATOMIC_ACQUIRE) == SCAN_QUEUE) {
+            /* The monitor is way behind, don't spend bus time on a scan it can't take */
+            __atomic_fetch_add(&scansDropped, 1, __ATOMIC_RELAXED);
+        } else if (scanPressureSensor(ADC_0, &scans[head % SCAN_QUEUE]) == 0) {
+            __atomic_store_n(&scanHead, head + 1, __ATOMIC_RELEASE);
+            sem_post(&scansReady);
+        }
+        periodicWait(&task);
+    }
+    return NULL;
+}
+
+/* Turns each scan from the sampler into pressures, history and averages */
+void *pressureMonitor() {
+    mcfVec_t in, mean;
+    ncdScan_t scan;
+    uint32_t tail;
+    uint64_t now;
     while(1) {
-        sem_wait(&bigSem);
-        primTankRing[i % RING_SIZE] = readPrimaryTank() + 10.76;
-        primLineRing[i % RING_SIZE] = readPrimaryLine();
-        primActRing[i % RING_SIZE]  = readPrimaryActuator();
-
-        secTankRing[i % RING_SIZE]  = readSecTank() + 11.83;
-        secLineRing[i % RING_SIZE]  = readSecLine();
-        secActRing[i % RING_SIZE]   = readSecActuator();
-
-        ambRing[i % RING_SIZE]      = readAmbientPressure();
-
-        pvRing[i % RING_SIZE]       = readPressureVessel();
-
-        data->pressure->primTank = avgDouble(primTankRing, RING_SIZE);
-        data->pressure->primLine = avgDouble(primLineRing, RING_SIZE);
-        data->pressure->primAct  = avgDouble(primActRing,  RING_SIZE);
-        data->pressure->secTank  = avgDouble(secTankRing,  RING_SIZE);
-        data->pressure->secLine  = avgDouble(secLineRing,  RING_SIZE);
-        data->pressure->secAct   = avgDouble(secActRing,   RING_SIZE);
-        data->pressure->amb      = avgDouble(ambRing,      RING_SIZE);
-        data->pressure->pv       = avgDouble(pvRing,       RING_SIZE);
+        if (sem_wait(&scansReady) != 0) continue;
+        tail = scanTail;
+        if (tail == __atomic_load_n(&scanHead, __ATOMIC_ACQUIRE)) continue;
+        scan = scans[tail % SCAN_QUEUE];
+        __atomic_store_n(&scanTail, tail + 1, __ATOMIC_RELEASE);
+
+        now = scan.time;
+        sample(&in, PRES_PRIM_TANK, now, tankPsi(scan.raw[PS_TANK]) + 10.76);
+        sample(&in, PRES_PRIM_LINE, now, linePsi(scan.raw[PS_LINE]));
+        sample(&in, PRES_PRIM_ACT,  now, linePsi(scan.raw[PS_ACTUATE]));
+
+        sample(&in, PRES_SEC_TANK,  now, tankPsi(scan.raw[BS_TANK]) + 11.83);
+        sample(&in, PRES_SEC_LINE,  now, linePsi(scan.raw[BS_LINE]));
+        sample(&in, PRES_SEC_ACT,   now, linePsi(scan.raw[BS_ACTUATE]));
+
+        sample(&in, PRES_AMB,       now, lowPsi(scan.raw[CHANNEL_4]));
+
+        sample(&in, PRES_PV,        now, lowPsi(scan.raw[PRES_VESL]));
+
+        mcfMaPush(&average, &in);
+        mcfMaGet(&average, &mean);
+
+        seqWriteBegin(&data->pressure->lock);
+        data->pressure->primTank = mean.ch[PRES_PRIM_TANK];
+        data->pressure->primLine = mean.ch[PRES_PRIM_LINE];
+        data->pressure->primAct  = mean.ch[PRES_PRIM_ACT];
+        data->pressure->secTank  = mean.ch[PRES_SEC_TANK];
+        data->pressure->secLine  = mean.ch[PRES_SEC_LINE];
+        data->pressure->secAct   = mean.ch[PRES_SEC_ACT];
+        data->pressure->amb      = mean.ch[PRES_AMB];
+        data->pressure->pv       = mean.ch[PRES_PV];
+        seqWriteEnd(&data->pressure->lock);
 #ifdef DEBUG_PRES
         showPressures();
+        printf("Scan took %u uS\n", scan.duration);
 #endif
-        i += 1;
-        usleep(LOOP_PERIOD);
-        sem_post(&bigSem);
     }
 
     return NULL;
 }
 
 int joinPressureMonitor() {
+    pthread_join(samplerThread, NULL);
     return pthread_join(presMonThread, NULL);
 }
 
-static double avgDouble(double *arr, int size) {
-    int i = 0;
-    double sum = 0;
-    for (i = 0; i < size; i++) {
-        sum += arr[i];
-    }
-    return sum / (double) size;
-}
-
 int brake() {
     brakePrimaryActuate();
     usleep(500000);
@@ -184,73 +249,51 @@ int brakeSecondaryVent() {
 }
  
 
-//Voltage
-double readPrimaryTank() {
+/* One channel on its own, the monitor scans them all instead */
+static double readConverted(uint8_t channel, double (*convert)(uint8_t)) {
     uint8_t data[2];
-    if (readPressureSensor(ADC_0, PS_TANK, data) != 0)
+    if (readPressureSensor(ADC_0, channel, data) != 0)
         return -1;
-    return (VOLTAGE_2000_SCALING((double) data[0]));
+    return convert(data[0]);
+}
+
+//Voltage
+double readPrimaryTank() {
+    return readConverted(PS_TANK, tankPsi);
 }
 
 //Current
 double readPrimaryLine() {
-    uint8_t data[2];
-    if (readPressureSensor(ADC_0, PS_LINE, data) != 0)
-        return -1;
-    return ( CURRENT_500_SCALING((double) data[0]) );
+    return readConverted(PS_LINE, linePsi);
 }
+
 //Current
 double readPrimaryActuator() {
-    uint8_t data[2];
-    if (readPressureSensor(ADC_0, PS_ACTUATE, data) != 0) {
-        return -1;
-    }
-    return ( CURRENT_500_SCALING((double) data[0]) );
+    return readConverted(PS_ACTUATE, linePsi);
 }
 
-
 //Voltage
 double readSecTank() {
-    uint8_t data[2];
-    if (readPressureSensor(ADC_0, BS_TANK, data) != 0)
-        return -1;
-    return (VOLTAGE_2000_SCALING((double) data[0]));
+    return readConverted(BS_TANK, tankPsi);
 }
 
 //Current
 double readSecLine() {
-    uint8_t data[2];
-    if (readPressureSensor(ADC_0, BS_LINE, data) != 0)
-        return -1;
-    return ( CURRENT_500_SCALING((double) data[0]) );
+    return readConverted(BS_LINE, linePsi);
 }
 
 //Current
 double readSecActuator() {
-    uint8_t data[2];
-    if (readPressureSensor(ADC_0, BS_ACTUATE, data) != 0) {
-        return -1;
-    }
-  
-    return ( CURRENT_500_SCALING((double) data[0]) );
+    return readConverted(BS_ACTUATE, linePsi);
 }
 
-
 /* Damn I dont know how to spell vessel */
 double readPressureVessel() {
-    uint8_t data[2];
-    if (readPressureSensor(ADC_0, PRES_VESL, data) != 0) {
-        return -1;
-    }
-    return (CURRENT_50_SCALING( (double) data[0]) );
+    return readConverted(PRES_VESL, lowPsi);
 }
 
 double readAmbientPressure() {
-    uint8_t data[2];
-    if (readPressureSensor(ADC_0, CHANNEL_4, data) != 0) {
-        return -1;
-    }
-    return ( CURRENT_50_SCALING( (double) data[0]) );
+    return readConverted(CHANNEL_4, lowPsi);
 }
 
 void showPressures() {
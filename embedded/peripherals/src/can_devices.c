@@ -9,11 +9,87 @@
 #include "can_devices.h"
 #include "motor.h"
 #include "semaphore.h"
+#include "data.h"
 //Global Variables
 pthread_t CANThread;
 sem_t canSem;
 
+/* Only standard (11 bit) IDs are used on the pod's bus, so every possible
+ * ID gets a slot and dispatch is a single array index */
+#define CAN_NUM_IDS      (CAN_SFF_MASK + 1)
+#define CAN_MAX_FILTERS  64
+#define JITTER_GAIN      16     /* Same smoothing as RFC 3550 */
+
+typedef struct canDispatchEntry_t {
+	canHandler_t handler;
+	canIdStats_t stats;
+} canDispatchEntry_t;
+
+static canDispatchEntry_t dispatchTable[CAN_NUM_IDS];
+static struct can_filter rxFilters[CAN_MAX_FILTERS];
+static uint32_t unhandledFrames = 0;
+/* Frame the CAN thread is handling. Per thread, so handlers called from
+ * anywhere else never see the CAN thread's */
+static __thread uint64_t dispatchRxTime = 0;
+
+/***
+ * canRegisterHandler - routes every ID in [firstId, lastId] to handler.
+ *  Registered IDs double as the kernel filter list, so a device only has to
+ *  register itself here for its frames to start showing up.
+ *
+ * RETURNS: 0 on success, -1 if the range is invalid
+ */
+int canRegisterHandler(uint32_t firstId, uint32_t lastId, canHandler_t handler) {
+	uint32_t id;
+	if (firstId > lastId || lastId > CAN_SFF_MASK || handler == NULL) {
+		fprintf(stderr, "Invalid CAN handler range %#x - %#x\n", firstId, lastId);
+		return -1;
+	}
+	for (id = firstId; id <= lastId; id++) {
+		dispatchTable[id].handler = handler;
+	}
+	return 0;
+}
+
+const canIdStats_t *canGetIdStats(uint32_t id) {
+	if (id > CAN_SFF_MASK) return NULL;
+	return &dispatchTable[id].stats;
+}
+
+uint32_t canGetUnhandledCount() {
+	return unhandledFrames;
+}
+
+/***
+ * canFrameRxTime - for use inside a handler, the kernel receive time of the
+ *  frame being decoded. Handlers called directly (not from the CAN thread)
+ *  get the current time instead.
+ */
+uint64_t canFrameRxTime() {
+	return dispatchRxTime != 0 ? dispatchRxTime : getuSTimestamp();
+}
+
+/* One exact match filter per registered ID */
+static int buildRxFilters() {
+	int numFilters = 0;
+	uint32_t id;
+	for (id = 0; id < CAN_NUM_IDS; id++) {
+		if (dispatchTable[id].handler == NULL) continue;
+		if (numFilters >= CAN_MAX_FILTERS) {
+			fprintf(stderr, "Too many CAN IDs to filter, accepting everything\n");
+			return 0;
+		}
+		rxFilters[numFilters].can_id = id;
+		rxFilters[numFilters].can_mask = CAN_SFF_MASK | CAN_EFF_FLAG | CAN_RTR_FLAG;
+		numFilters++;
+	}
+	return numFilters;
+}
+
 void SetupCANDevices(){
+	rmsRegisterCan();
+	bmsRegisterCan();
+	canSetFilters(rxFilters, buildRxFilters());
 	initCan();
     sem_init(&canSem, 0, 1);
 /*	initMotor();*/
@@ -22,33 +98,72 @@ void SetupCANDevices(){
 	}
 }
 
-void rx_recv(struct can_frame *can_mesg){
-            
-	    if(!canRead(can_mesg)){ // Checks for a CAN message
-		//	printf("ID: %#X || ", (unsigned int) can_mesg->can_id);
-		//	printf("Data: [%#X.%#X.%#X.%#X.%#X.%#X.%#X.%#X]\n\r", can_mesg->data[0], can_mesg->data[1], can_mesg->data[2], can_mesg->data[3], can_mesg->data[4], can_mesg->data[5], can_mesg->data[6], can_mesg->data[7]);
-			bool validRMSMesg = false;
-			if(!rms_parser(can_mesg->can_id, can_mesg->data, NO_FILTER)){
-		//		printf("RMS Data parsed successfully\n");
-				validRMSMesg = true;
-			}
-			if(!validRMSMesg && bmsParseMsg(can_mesg->can_id, can_mesg->data)){
-/*				printf("BMS Data parsed successfully\n");*/
-/*				//dumpCells();*/
-/*                bmsDump();*/
+static void updateIdStats(canIdStats_t *stats, uint64_t rxTime) {
+	if (stats->count > 0) {
+		uint64_t period = rxTime - stats->lastSeen;
+		if (stats->count > 1) {
+			int64_t diff = (int64_t) period - (int64_t) stats->period;
+			if (diff < 0) diff = -diff;
+			stats->jitter += (diff - (int64_t) stats->jitter) / JITTER_GAIN;
 		}
-		NEW_CAN_MESSAGE = false;
+		stats->period = period;
+	}
+	stats->lastSeen = rxTime;
+	stats->count++;
+}
+
+static void canDispatch(canFrameTs_t *can_mesg) {
+	uint32_t id = can_mesg->frame.can_id;
+	//	printf("ID: %#X || ", (unsigned int) id);
+	//	printf("Data: [%#X.%#X.%#X.%#X.%#X.%#X.%#X.%#X]\n\r", can_mesg->frame.data[0], can_mesg->frame.data[1], can_mesg->frame.data[2], can_mesg->frame.data[3], can_mesg->frame.data[4], can_mesg->frame.data[5], can_mesg->frame.data[6], can_mesg->frame.data[7]);
+	if ((id & (CAN_EFF_FLAG | CAN_RTR_FLAG | CAN_ERR_FLAG)) || dispatchTable[id].handler == NULL) {
+		unhandledFrames++;
+		return;
 	}
+	canDispatchEntry_t *entry = &dispatchTable[id];
+	updateIdStats(&entry->stats, can_mesg->rxTime);
+	dispatchRxTime = can_mesg->rxTime;
+	entry->handler(id, can_mesg->frame.data);
+	dispatchRxTime = 0;
+}
+
+/* Drains every frame currently queued on the socket a batch at a time,
+ * batch must hold CAN_BATCH_SIZE frames. Returns how many were handled */
+int rx_recv(canFrameTs_t *batch){
+	int numFrames = 0, n, i;
+	do {
+		n = canReadBatch(batch, CAN_BATCH_SIZE);
+		for (i = 0; i < n; i++) {
+			canDispatch(&batch[i]);
+		}
+		numFrames += n;
+	} while (n == CAN_BATCH_SIZE);
+	NEW_CAN_MESSAGE = false;
+	return numFrames;
 }
 
 
+/* RX never takes canSem, the socket itself is safe to send on from
+ * other threads while this one is blocked waiting for frames */
 void *CANLoop(void *arg){
 	(void) arg;
-	struct can_frame can_mesg;
+	canFrameTs_t batch[CAN_BATCH_SIZE];
+	int ret;
+	bool failing = false;
 	while(1){
-        sem_wait(&canSem);
-		rx_recv(&can_mesg);
-        sem_post(&canSem);
-		usleep(50);
+		ret = canWait(CAN_RX_TIMEOUT_MS);
+		if (ret < 0) {
+			/* Bus off, interface down or a bad fd. Waiting again would fail
+			 * straight away, so back off and try a fresh socket */
+			if (!failing) fprintf(stderr, "CAN socket error, reopening\n");
+			failing = true;
+			usleep(CAN_RX_TIMEOUT_MS * 1000);
+			canReopen();
+			continue;
+		}
+		if (ret == 0) continue;
+		if (failing) fprintf(stderr, "CAN receiving again\n");
+		failing = false;
+		rx_recv(batch);
 	}
 }
@@ -19,6 +19,8 @@ static int setupIox(void);
 
 int initHVIox(bool hardStart) {
     if (setupMCP(&iox, HV_IO_ADDR) != 0) return -1;
+    /* emergencyDisableMCU() goes through here */
+    i2cSetPriority(&iox, I2C_PRIO_HIGH);
     if (hardStart) {
         if (clearSettingsMCP(&iox) != 0) return -1;
         if (setupIox() != 0) return -1; 
@@ -38,18 +40,12 @@ i2c_settings getHVIoxDev() {
  *
  */
 static int setupIox() {
-    setDir(&iox, HV_IND_EN, MCP_DIR_IN);
-    setDir(&iox, MCU_LATCH, MCP_DIR_OUT);
-    setDir(&iox, BMS_MULTI_IN, MCP_DIR_IN);
-    setDir(&iox, IMD_STAT_FDBK, MCP_DIR_IN);
-    setDir(&iox, INRT_STAT_FDBK, MCP_DIR_IN);
-    setDir(&iox, HV_EN_FDBK, MCP_DIR_IN);
-    setDir(&iox, MCU_HV_EN, MCP_DIR_IN);
-    setDir(&iox, PS_FDBK, MCP_DIR_IN);
-    setDir(&iox, BMS_STAT_FDBK, MCP_DIR_IN);
-    setDir(&iox, E_STOP_FDBK, MCP_DIR_IN);
-    setDir(&iox, MSTR_SW_FDBK, MCP_DIR_IN);
-    return 0; /* TODO Add error checking */
+    uint16_t pins = MCP_PIN(HV_IND_EN) | MCP_PIN(MCU_LATCH) | MCP_PIN(BMS_MULTI_IN) |
+        MCP_PIN(IMD_STAT_FDBK) | MCP_PIN(INRT_STAT_FDBK) | MCP_PIN(HV_EN_FDBK) |
+        MCP_PIN(MCU_HV_EN) | MCP_PIN(PS_FDBK) | MCP_PIN(BMS_STAT_FDBK) |
+        MCP_PIN(E_STOP_FDBK) | MCP_PIN(MSTR_SW_FDBK);
+    /* Everything is an input but the MCU latch */
+    return setDirs(&iox, pins, pins & ~MCP_PIN(MCU_LATCH));
 }
 
 int isHVIndicatorEnabled() {
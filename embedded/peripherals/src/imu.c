@@ -8,6 +8,7 @@
 #include <inttypes.h>
 #include <pthread.h>
 #include <unistd.h>
+#include <stdbool.h>
 #include "imu.h"
 #include "i2c.h"
 
@@ -26,6 +27,8 @@ static inline uint64_t getuSTimestamp() {
 static IMU_data * data;
 static i2c_settings * i2c;
 static pthread_t IMUThread;
+static bool ready = false;
+
 void SetupIMU(){
 	i2c = (i2c_settings *) malloc(sizeof(i2c_settings));
 	i2c->bus = 2;
@@ -61,12 +64,18 @@ void SetupIMU(){
 	data->accelZ = 0;
 	
 	sem_init(&data->mutex, 0, 1);
+	ready = true;
+}
+
+bool IMUReady() {
+	return ready;
 }
 
 void *IMULoop(void *arg){
 	(void) arg;
 	
 	unsigned char res1[4];
+	const unsigned char statusReg = STATUS_REG, dataReg = DATA_REG;
 	uint32_t tempx, tempy, tempz;
 	int i;
     //uint64_t curr, prev;
@@ -77,15 +86,13 @@ void *IMULoop(void *arg){
 		// Information on data registers can be found @ https://www.xsens.com/download/pdf/documentation/mti-1/mti-1-series_datasheet.pdf
 
 		//Get message length size
-		write_byte_i2c(i2c, STATUS_REG);
-		read_i2c(i2c, res1, 4);
+		write_read_i2c(i2c, &statusReg, 1, res1, 4);
 		uint16_t messageSize = res1[2] | res1[3] << 8;
 
 
 		// Get Data
-		write_byte_i2c(i2c, DATA_REG);
 		unsigned char dataBuffer[messageSize];
-		read_i2c(i2c, dataBuffer, messageSize);
+		write_read_i2c(i2c, &dataReg, 1, dataBuffer, messageSize);
         i = 0;
         //curr = getuSTimestamp();
 		while(i < messageSize){
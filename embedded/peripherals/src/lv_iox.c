@@ -6,8 +6,6 @@
 #include <mcp23017.h>
 #include <proc_iox.h>
 #include <lv_iox.h>
-#include <semaphore.h>
-#include <braking.h>
 
 #define LV_IO_ADDR   0x21
 
@@ -16,6 +14,8 @@ static int setupIox();
 
 int initLVIox(bool hardStart) {
     if (setupMCP(&iox, LV_IO_ADDR) != 0) return -1;
+    /* Limit switches and solenoids */
+    i2cSetPriority(&iox, I2C_PRIO_HIGH);
     if (hardStart) {
         if (clearSettingsMCP(&iox) != 0) return -1;
         if (setupIox() != 0) return -1;
@@ -31,30 +31,16 @@ int initLVIox(bool hardStart) {
  *
  */
 static int setupIox() {
-    /* Limit switch inputs */
+    uint16_t limSwitches = MCP_PIN(MCP_GPIOA_0) | MCP_PIN(MCP_GPIOA_1) |
+        MCP_PIN(MCP_GPIOA_2) | MCP_PIN(MCP_GPIOA_3);
+    uint16_t solenoids = MCP_PIN(MCP_GPIOB_0) | MCP_PIN(MCP_GPIOB_1) |
+        MCP_PIN(MCP_GPIOB_2) | MCP_PIN(MCP_GPIOB_3) | MCP_PIN(MCP_GPIOB_4) |
+        MCP_PIN(MCP_GPIOB_5) | MCP_PIN(MCP_GPIOB_6) | MCP_PIN(MCP_GPIOB_7);
     int ret = 0;
-    ret += setDir(&iox, MCP_GPIOA_0, MCP_DIR_IN);
-    ret += setDir(&iox, MCP_GPIOA_1, MCP_DIR_IN);
-    ret += setDir(&iox, MCP_GPIOA_2, MCP_DIR_IN);
-    ret += setDir(&iox, MCP_GPIOA_3, MCP_DIR_IN);
-    
-    /* Solenoid outputs */
-    ret += setDir(&iox, MCP_GPIOB_0, MCP_DIR_OUT);
-    ret += setDir(&iox, MCP_GPIOB_1, MCP_DIR_OUT);
-    ret += setDir(&iox, MCP_GPIOB_2, MCP_DIR_OUT);
-    ret += setDir(&iox, MCP_GPIOB_3, MCP_DIR_OUT);
-    ret += setDir(&iox, MCP_GPIOB_4, MCP_DIR_OUT);
-    ret += setDir(&iox, MCP_GPIOB_5, MCP_DIR_OUT);
-    ret += setDir(&iox, MCP_GPIOB_6, MCP_DIR_OUT);
-    ret += setDir(&iox, MCP_GPIOB_7, MCP_DIR_OUT);
-    ret += setState(&iox, MCP_GPIOB_0, 0); 
-    ret += setState(&iox, MCP_GPIOB_1, 0); 
-    ret += setState(&iox, MCP_GPIOB_2, 0); 
-    ret += setState(&iox, MCP_GPIOB_3, 0); 
-    ret += setState(&iox, MCP_GPIOB_4, 0); 
-    ret += setState(&iox, MCP_GPIOB_5, 0); 
-    ret += setState(&iox, MCP_GPIOB_6, 0); 
-    ret += setState(&iox, MCP_GPIOB_7, 0); 
+
+    /* Limit switch inputs, solenoid outputs, all off */
+    ret += setDirs(&iox, limSwitches | solenoids, limSwitches);
+    ret += setStates(&iox, solenoids, 0);
     if (ret != 0) fprintf(stderr, "Error initializing LV IOX\n");
     return ret; /* TODO Add error checking */
 }
@@ -68,11 +54,7 @@ int limSwitchGet(int limSwitch) {
         fprintf(stderr, "Invalid Limit Switch\n");
         return -1;
     }
-    int val = 0;
-    sem_wait(&bigSem);
-    val = getState(&iox, limSwitch);
-    sem_post(&bigSem);
-    return val;
+    return getState(&iox, limSwitch);
 }
 
 int solenoidSet(int solenoid, bool val) { 
@@ -84,9 +66,6 @@ int solenoidSet(int solenoid, bool val) {
         fprintf(stderr, "Invalid solenoid\n");
         return -1;
     }
-    sem_wait(&bigSem);
-    int ret = setState(&iox, solenoid, val);
-    sem_post(&bigSem);
-    return ret;
+    return setState(&iox, solenoid, val);
 }
 
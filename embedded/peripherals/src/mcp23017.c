@@ -5,9 +5,90 @@
 #include <inttypes.h>
 #include <unistd.h>
 #include <math.h>
+#include <pthread.h>
 #include "i2c.h"
 #include "mcp23017.h"
 
+#define MAX_MCPS    8       /* The address pins allow 0x20 to 0x27 on a bus */
+#define NUM_REGS    0x16    /* IODIRA to OLATB */
+
+typedef struct mcpShadow_t {
+    bool used;
+    bool known;
+    int bus;
+    int deviceAddress;
+    uint8_t iodir[2];
+    uint8_t olat[2];
+} mcpShadow_t;
+
+static mcpShadow_t shadows[MAX_MCPS];
+static pthread_mutex_t shadowLock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Call with shadowLock held */
+static mcpShadow_t *getShadow(i2c_settings *i2c) {
+    int i;
+    mcpShadow_t *empty = NULL;
+    for (i = 0; i < MAX_MCPS; i++) {
+        if (shadows[i].used && shadows[i].bus == i2c->bus &&
+                shadows[i].deviceAddress == i2c->deviceAddress) {
+            return &shadows[i];
+        }
+        if (!shadows[i].used && empty == NULL) empty = &shadows[i];
+    }
+    if (empty == NULL) {
+        fprintf(stderr, "No room to track another MCP23017\n");
+        return NULL;
+    }
+    empty->used = true;
+    empty->known = false;
+    empty->bus = i2c->bus;
+    empty->deviceAddress = i2c->deviceAddress;
+    return empty;
+}
+
+/* Reads IODIRA through OLATB in one go, the chip steps through them itself */
+static int loadShadow(i2c_settings *i2c, mcpShadow_t *shadow) {
+    uint8_t reg = IODIRA;
+    uint8_t regs[NUM_REGS];
+    if (write_read_i2c(i2c, &reg, 1, regs, NUM_REGS) != 0) return -1;
+    shadow->iodir[0] = regs[(uint8_t) IODIRA];
+    shadow->iodir[1] = regs[(uint8_t) IODIRB];
+    shadow->olat[0] = regs[(uint8_t) OLATA];
+    shadow->olat[1] = regs[(uint8_t) OLATB];
+    shadow->known = true;
+    return 0;
+}
+
+/* Call with shadowLock held */
+static mcpShadow_t *getKnownShadow(i2c_settings *i2c) {
+    mcpShadow_t *shadow = getShadow(i2c);
+    if (shadow == NULL) return NULL;
+    if (!shadow->known && loadShadow(i2c, shadow) != 0) return NULL;
+    return shadow;
+}
+
+/* Writes whichever banks of a register pair changed, both in one
+ * transaction if they both did, and keeps the shadow in step */
+static int writePair(i2c_settings *i2c, char reg, uint8_t cur[2], uint16_t next) {
+    uint8_t vals[2] = { next & 0xFF, next >> 8 };
+    int ret = 0;
+    if (vals[0] != cur[0] && vals[1] != cur[1]) {
+        ret = write_block_i2c(i2c, reg, vals, 2);
+    } else if (vals[0] != cur[0]) {
+        ret = write_data_i2c(i2c, reg, vals[0]);
+    } else if (vals[1] != cur[1]) {
+        ret = write_data_i2c(i2c, reg + 1, vals[1]);
+    }
+    if (ret != 0) return -1;
+    cur[0] = vals[0];
+    cur[1] = vals[1];
+    return 0;
+}
+
+static uint16_t pair(const uint8_t regs[2]) {
+    return regs[0] | (regs[1] << 8);
+}
+
 int setupMCP(i2c_settings * i2c, char mcpAddress) {
     uint8_t flush[1];
     i2c->bus = 2;
@@ -23,39 +104,43 @@ int setupMCP(i2c_settings * i2c, char mcpAddress) {
     if (read_i2c(i2c, flush, 1) != 0) {
         return -1;   
     }
-    
+
+    /* It may have been reset since, so don't trust what we had */
+    pthread_mutex_lock(&shadowLock);
+    mcpShadow_t *shadow = getShadow(i2c);
+    if (shadow) shadow->known = false;
+    pthread_mutex_unlock(&shadowLock);
     return 0;
 }
 
 /* Sets the pins to default state of inputs, at 0 */
 int clearSettingsMCP(i2c_settings * i2c) {
-    if (write_data_i2c(i2c, IODIRA, 0xFF) != 0) return -1;
-    if (write_data_i2c(i2c, IODIRB, 0xFF) != 0) return -1;
-    if (write_data_i2c(i2c, GPIOA, 0x00) != 0) return -1;
-    if (write_data_i2c(i2c, GPIOB, 0x00) != 0) return -1;
-    return 0;
-}
-
-// helper method for getting data from a specific address
-static uint8_t getFromAddress(i2c_settings * i2c, char address) {
-	write_byte_i2c(i2c, address);
-
-	uint8_t dataBuffer[1];
-	read_i2c(i2c, dataBuffer, 1);
-
-	return dataBuffer[0]; // getting the digit corresponding to the pin
-}
-/* TODO temp function, going to replace with a faster solution by using a 0x<Bank><pin> encoding later */
-static uint8_t makeRelativeToBank(uint8_t pin) {
-    /* If its in bank B, we need to shif the numbering convention */
-    if (pin >= (NUM_PINS >> 1)) {
-        pin -= (NUM_PINS >> 1);
+    const uint8_t inputs[2] = { 0xFF, 0xFF };
+    const uint8_t low[2] = { 0x00, 0x00 };
+    int ret = 0;
+
+    pthread_mutex_lock(&shadowLock);
+    mcpShadow_t *shadow = getShadow(i2c);
+    if (write_block_i2c(i2c, IODIRA, inputs, 2) != 0 ||
+            write_block_i2c(i2c, OLATA, low, 2) != 0) {
+        ret = -1;
     }
-    return pin;
+    if (shadow) {
+        shadow->iodir[0] = shadow->iodir[1] = 0xFF;
+        shadow->olat[0] = shadow->olat[1] = 0x00;
+        shadow->known = ret == 0;
+    }
+    pthread_mutex_unlock(&shadowLock);
+    return ret;
 }
 
-static int getAllStates(i2c_settings *i2c, uint8_t address) {
-    return (getFromAddress(i2c, address));
+int refreshMCP(i2c_settings *i2c) {
+    int ret = -1;
+    pthread_mutex_lock(&shadowLock);
+    mcpShadow_t *shadow = getShadow(i2c);
+    if (shadow) ret = loadShadow(i2c, shadow);
+    pthread_mutex_unlock(&shadowLock);
+    return ret;
 }
 
 static int validatePin(uint8_t pin) {
@@ -66,31 +151,12 @@ static int validatePin(uint8_t pin) {
     return 0;
 }
 
-static int writeToDev(i2c_settings *i2c, char addr, uint8_t pin, bool val) {
-    int ret;
-    pin = makeRelativeToBank(pin);
-    if (val) {
-        ret = write_data_i2c(i2c, addr, getAllStates(i2c, addr) | (1 << pin));
-    } else {
-        ret = write_data_i2c(i2c, addr, getAllStates(i2c, addr) & ~(1 << pin));
-    }
-    return ret;
-}
-
-static char getIodirBank(uint8_t pin) {
-    if (pin < (NUM_PINS >> 1)) {
-        return IODIRA;
-    } else {
-        return IODIRB;
-    }
-}
-
-static char getGpioBank(uint8_t pin) {
-    if (pin < (NUM_PINS >> 1)) {
-        return GPIOA;
-    } else {
-        return GPIOB;
-    }
+int getStates(i2c_settings *i2c) {
+    uint8_t reg = GPIOA;
+    uint8_t banks[2];
+    /* Both banks in one read, GPIOB follows GPIOA */
+    if (write_read_i2c(i2c, &reg, 1, banks, 2) != 0) return -1;
+    return pair(banks);
 }
 
 int getState(i2c_settings * i2c, uint8_t pin) {
@@ -98,48 +164,65 @@ int getState(i2c_settings * i2c, uint8_t pin) {
         fprintf(stderr, "Invalid pin input getState\n");
         return -1;
     }
-    char addr = getGpioBank(pin);
-    pin = makeRelativeToBank(pin);
-    return (getFromAddress(i2c, addr) >> pin) & 1;
+    int states = getStates(i2c);
+    if (states < 0) return -1;
+    return (states >> pin) & 1;
 }
 
-
+int setStates(i2c_settings *i2c, uint16_t pins, uint16_t vals) {
+    int ret;
+    pthread_mutex_lock(&shadowLock);
+    mcpShadow_t *shadow = getKnownShadow(i2c);
+    if (shadow == NULL) {
+        ret = -1;
+    } else if (pins & pair(shadow->iodir)) {
+        fprintf(stderr, "setState: Only can set value on an output\n");
+        ret = -1;
+    } else {
+        ret = writePair(i2c, OLATA, shadow->olat, (pair(shadow->olat) & ~pins) | (vals & pins));
+    }
+    pthread_mutex_unlock(&shadowLock);
+    return ret;
+}
 
 int setState(i2c_settings * i2c, uint8_t pin, bool val) {
     if (validatePin(pin) == -1) {
         fprintf(stderr, "setState: Invalid pin number\n");
         return -1;
     }
-    if (getDir(i2c, pin) != 0) {
-        fprintf(stderr, "setState: Only can set value on an output\n");
-        return -1;
-    }
-    uint8_t address = getGpioBank(pin);
-    int currentState = getState(i2c, pin);
-    if (val == currentState) {
-        return 0;
-    }
-	return writeToDev(i2c, address, pin, val);
+    return setStates(i2c, MCP_PIN(pin), val ? MCP_PIN(pin) : 0);
 }
 
 int getDir(i2c_settings * i2c, uint8_t pin) {
+    int ret;
     if (validatePin(pin) == -1) {
         fprintf(stderr, "Invalid pin\n");
         return -1;
     }
-    char addr = getIodirBank(pin);
-    pin = makeRelativeToBank(pin);
-	return (getFromAddress(i2c, addr) >> pin) & 1;
+    pthread_mutex_lock(&shadowLock);
+    mcpShadow_t *shadow = getKnownShadow(i2c);
+    ret = shadow ? (pair(shadow->iodir) >> pin) & 1 : -1;
+    pthread_mutex_unlock(&shadowLock);
+    return ret;
+}
+
+int setDirs(i2c_settings *i2c, uint16_t pins, uint16_t dirs) {
+    int ret;
+    pthread_mutex_lock(&shadowLock);
+    mcpShadow_t *shadow = getKnownShadow(i2c);
+    if (shadow == NULL) {
+        ret = -1;
+    } else {
+        ret = writePair(i2c, IODIRA, shadow->iodir, (pair(shadow->iodir) & ~pins) | (dirs & pins));
+    }
+    pthread_mutex_unlock(&shadowLock);
+    return ret;
 }
 
 int setDir(i2c_settings * i2c, uint8_t pin, bool val) {
     if (validatePin(pin) == -1) {
         fprintf(stderr, "Invalid pin");
+        return -1;
     }
-    char address = getIodirBank(pin);
-    int currentState = getDir(i2c, pin);
-    if (val == currentState) {
-        return 0;
-    }
-    return writeToDev(i2c, address, pin, val);
+    return setDirs(i2c, MCP_PIN(pin), val ? MCP_PIN(pin) : 0);
 }
@@ -30,33 +30,17 @@ i2c_settings getProcIoxDev() {
 
 static int setupIox() {
     /* Debug pins, set B1 high for optional testing */
-    setDir(&iox, MCP_GPIOB_0, MCP_DIR_OUT);
-    setDir(&iox, MCP_GPIOB_1, MCP_DIR_OUT);
-    setState(&iox, MCP_GPIOB_0, 0);
-    setState(&iox, MCP_GPIOB_1, 1);
-
+    uint16_t debugPins = MCP_PIN(MCP_GPIOB_0) | MCP_PIN(MCP_GPIOB_1);
     /* Debug LEDs */
-    setDir(&iox, MCP_GPIOB_4, MCP_DIR_OUT);
-    setDir(&iox, MCP_GPIOB_5, MCP_DIR_OUT);
-    setDir(&iox, MCP_GPIOB_6, MCP_DIR_OUT);
-    setDir(&iox, MCP_GPIOB_7, MCP_DIR_OUT);
-    setState(&iox, MCP_GPIOB_4, 0);
-    setState(&iox, MCP_GPIOB_5, 0);
-    setState(&iox, MCP_GPIOB_6, 0);
-    setState(&iox, MCP_GPIOB_7, 0);
-    
-    
+    uint16_t leds = MCP_PIN(MCP_GPIOB_4) | MCP_PIN(MCP_GPIOB_5) |
+        MCP_PIN(MCP_GPIOB_6) | MCP_PIN(MCP_GPIOB_7);
     /* Random GPIO, may or may not be connected */
     /* Also dont know if in/out so we'll leave them as
      * in for now */
-    setDir(&iox, MCP_GPIOA_0, MCP_DIR_IN);
-    setDir(&iox, MCP_GPIOA_1, MCP_DIR_IN);
-    setDir(&iox, MCP_GPIOA_2, MCP_DIR_IN);
-    setDir(&iox, MCP_GPIOA_3, MCP_DIR_IN);
-    setDir(&iox, MCP_GPIOA_4, MCP_DIR_IN);
-    setDir(&iox, MCP_GPIOA_5, MCP_DIR_IN);
-    setDir(&iox, MCP_GPIOA_6, MCP_DIR_IN);
-    setDir(&iox, MCP_GPIOA_7, MCP_DIR_IN);
+    uint16_t bankA = 0x00FF;
+
+    setDirs(&iox, debugPins | leds | bankA, bankA);
+    setStates(&iox, debugPins | leds, MCP_PIN(MCP_GPIOB_1));
 
     return 0;   /* TODO add error checking */
 }
@@ -7,6 +7,7 @@
 #include <stdbool.h>
 #include <pthread.h>
 #include <bbgpio.h>
+#include <gpiochip.h>
 #include <retro.h>
 #include <poll.h>
 #include <time.h>
@@ -27,15 +28,26 @@
 #define VOTE_RESET_TIME 300000  /* Hard coded for max speed, approx algo should be (DIST_BTWN_STRIPS / (2 * SPEED_FTPS)) */
 #define CONST_TERM      SAFETY_CONSTANT * SEC_TO_USEC
 
+#define EVENT_TIMEOUT   1000    /* mS */
+#define EVENT_RETRIES   5       /* Errors in a row before giving up on the gpiochip */
+#define EVENT_RETRY_US  10000
+
 static pthread_t retroThreads[3];
 static pthread_t spuriousThread;
+static pthread_t eventThread;
 static bool shouldQuit = false;
 static bool blockInts  = true;
+static int eventFd = -1;        /* All three retros, when the gpiochip can do it */
+static bool usingEvents = false;
+static bool usingSysfs = false;
+static unsigned int retroOffsets[NUM_RETROS];
 
-static int onTapeStrip (int retroNum);
+static int onTapeStrip (int retroNum, uint64_t time);
 static void * waitForStrip (void * retroNum);
+static void * waitForEdges (void * unused);
 static int getPin(int retroNum);
 static void * blockSpuriousInts(int timeout);
+static int startSysfsRetros(void);
 
 
 /***
@@ -44,8 +56,34 @@ static void * blockSpuriousInts(int timeout);
   *
  ***/
 int initRetros() {
+	unsigned int chip, firstChip = 0;
 	int i = 0;
 
+	/* Preferably one thread for all of them, with the kernel's edge times */
+	if (gpioEventsSupported()) {
+		for (i = 0; i < NUM_RETROS; i++) {
+			gpioChipLine(getPin(i), &chip, &retroOffsets[i]);
+			if (i == 0) firstChip = chip;
+			if (chip != firstChip) break;
+		}
+		if (i == NUM_RETROS) {
+			eventFd = gpioRequestEdges(firstChip, retroOffsets, NUM_RETROS, GPIO_EDGE_RISING, "retro");
+			if (eventFd >= 0) {
+				usingEvents = true;
+				return pthread_create(&eventThread, NULL, waitForEdges, NULL) == 0 ? 0 : -1;
+			}
+		}
+		fprintf(stderr, "Retros falling back to sysfs GPIO\n");
+	}
+
+	if (startSysfsRetros() != 0) return -1;
+	usingSysfs = true;
+	return 0;
+}
+
+/* One thread per retro polling its sysfs value file */
+static int startSysfsRetros() {
+	int i;
 	for (i = 0; i < NUM_RETROS; i++) {
 		if (bbGpioExport(getPin(i)) != 0) return -1;
 		if (bbGpioSetDir(getPin(i), IN_DIR) != 0) return -1;
@@ -60,6 +98,15 @@ int initRetros() {
     return 0;
 }
 
+int initRetrosFromFd(int fd) {
+	unsigned int chip;
+	int i;
+	for (i = 0; i < NUM_RETROS; i++) gpioChipLine(getPin(i), &chip, &retroOffsets[i]);
+	eventFd = fd;
+	usingEvents = true;
+	return pthread_create(&eventThread, NULL, waitForEdges, NULL) == 0 ? 0 : -1;
+}
+
 /***
  * joinRetroThreads - signals to all threads that they should stop
  *  and then blocks until they do.
@@ -68,6 +115,9 @@ int initRetros() {
 int joinRetroThreads() {
 	int i = 0;
 /*	shouldQuit = true;*/
+	/* Joined first, it may have switched over to sysfs before it quit */
+	if (usingEvents) pthread_join(eventThread, NULL);
+	if (!usingSysfs) return 0;
 	for (i = 0; i < NUM_RETROS; i++) {
 		pthread_join(retroThreads[i], NULL);
 	}
@@ -101,10 +151,9 @@ static int voteOnCandidate(int retroNum) {
         (candidate - otherRetro2) <= VOTE_BUFFER) && candidate > (data->timers->lastRetro + VOTE_RESET_TIME));
 }
 
-/* Not voting yet! */
-static int onTapeStrip(int retroNum) {
+/* time is when the edge happened, in uS */
+static int onTapeStrip(int retroNum, uint64_t currTime) {
     DBG_RETRO_PRINTF("Tape strip detected on retro %d\n", retroNum);
-	uint64_t currTime = getuSTimestamp();
     uint64_t delay = 10000;//getDelay();
     DBG_RETRO_PRINTF("Current delay: %llu\n", delay);
 
@@ -117,7 +166,9 @@ static int onTapeStrip(int retroNum) {
             DBG_RETRO_PRINTF("Vote pass: incrementing count\n");
             data->timers->oldRetro = data->timers->lastRetro;
             data->timers->lastRetro = currTime;
+            seqWriteBegin(&data->motion->lock);
             data->motion->retroCount++;
+            seqWriteEnd(&data->motion->lock);
         }
         DBG_RETRO_PRINTF("New count: %d\n", data->motion->retroCount);
     }
@@ -171,7 +222,50 @@ static void *waitForStrip(void *num) {
                to get the interrupts out of the system. */
             if (blockInts)
                 continue;
-			onTapeStrip(retroNum);
+			onTapeStrip(retroNum, getuSTimestamp());
+		}
+	}
+	return NULL;
+}
+
+/***
+  * waitForEdges - Run by the one thread watching every retro through the
+  *  gpiochip. Edges arrive in the order they happened, stamped by the kernel
+  *  when the interrupt fired, so how long this thread took to get scheduled
+  *  no longer ends up in the velocity.
+  ***/
+static void *waitForEdges(void *unused) {
+	(void) unused;
+	gpioEvent_t ev[NUM_RETROS * 4];
+	uint32_t nextSeqno = 0;
+	int n, i, j, errors = 0;
+
+	while (!shouldQuit) {
+		n = gpioReadEvents(eventFd, ev, NUM_RETROS * 4, EVENT_TIMEOUT);
+		if (n < 0) {
+			if (++errors < EVENT_RETRIES) {
+				usleep(EVENT_RETRY_US);
+				continue;
+			}
+			fprintf(stderr, "Reading retro edges keeps failing, switching to sysfs\n");
+			gpioRelease(eventFd);
+			eventFd = -1;
+			if (startSysfsRetros() != 0) {
+				fprintf(stderr, "Retros are down\n");
+				data->flags->retroFault = true;
+			} else {
+				usingSysfs = true;
+			}
+			break;
+		}
+		errors = 0;
+		for (i = 0; i < n; i++) {
+			if (nextSeqno != 0 && ev[i].seqno != nextSeqno)
+				fprintf(stderr, "Lost %u retro edges\n", ev[i].seqno - nextSeqno);
+			nextSeqno = ev[i].seqno + 1;
+			for (j = 0; j < NUM_RETROS; j++) {
+				if (ev[i].offset == retroOffsets[j]) onTapeStrip(j, ev[i].time);
+			}
 		}
 	}
 	return NULL;
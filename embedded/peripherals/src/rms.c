@@ -5,6 +5,10 @@
 #include "rms.h"
 #include "data.h"
 #include "can_devices.h"
+#ifdef DEBUG_RMS
+#define CAN_SIGNAL_DEBUG
+#endif
+#include "can_signals.h"
 
 /* Uncomment define for additional prints in the parser */
 /*#define DEBUG_RMS*/
@@ -159,118 +163,27 @@ int rmsSendHbMsg(uint16_t torque) {
 }
 
 
+/* Defines canDecode_<id>() for every message in the RMS signal table */
+RMS_MESSAGES(CAN_DEFINE_DECODER)
+
 /* RMS CAN Parser Function
  *      Based on the CAN ID passed, parsing out the data bytes into
- *      their respective values in the RMS data struct
+ *      their respective values in the RMS data struct. The scales and
+ *      offsets for each ID live in can_signals.h
  */
-int rms_parser(uint32_t id, uint8_t *rmsData, uint32_t filter){
+int rms_parser(uint32_t id, uint8_t *msg, uint32_t filter){
     if (filter != 0 && filter != id) {
         return 1;
     }
-    uint16_t val;
-    //uint16_t val2;
-    int16_t temp;
 	switch(id){
-           case (0xa0):
-			data->rms->igbtTemp = (rmsData[0] | (rmsData[1] <<8)) / 10; //Deg C
-			data->rms->gateDriverBoardTemp = (rmsData[6] | (rmsData[7] << 8)) / 10; //Deg C
-#ifdef DEBUG_RMS
-            printf("IGBT: %d\r\n", data->rms->igbtTemp);
-			printf("Gate Driver Board Temp: %d\r\n", data->rms->gateDriverBoardTemp);
-#endif
-            break;
-		case (0xa1):
-			data->rms->controlBoardTemp = (rmsData[0] | (rmsData[1] << 8)) / 10; // Deg C
-#ifdef DEBUG_RMS
-            printf("Control Board Temp: %d\r\n", data->rms->controlBoardTemp);
-#endif
-            break;
-		case (0xa2):
-            val = (rmsData[4] | rmsData[5] << 8) / 10;
-			data->rms->motorTemp = val > 300 ? data->rms->motorTemp : val; //Deg C
-#ifdef DEBUG_RMS
-            printf("Motor Temp: %d\r\n", data->rms->motorTemp);
-#endif
-            break;
-		case (0xa3):
-			break;
-		case (0xa4):
-			break;
-		case (0xa5):
-			data->rms->motorSpeed = (rmsData[2] | (rmsData[3] << 8));//val == 0 ? 0 : 65536 - abs(val) ;//< -10000 || val > 10000 ? data->rms->motorSpeed: val; // RPM
-			data->rms->electricalFreq = (rmsData[4] | (rmsData[5] << 8 )) / 10; //electrical frequency Hz
-#ifdef DEBUG_RMS
-            printf("Motor Speed: %d\r\n", data->rms->motorSpeed);
-			printf("Elect. Freq: %d\r\n", data->rms->electricalFreq);
-#endif
-            break;
-		case (0xa6):
-			temp = (rmsData[0] | (rmsData[1] << 8));
-            
-            data->rms->phaseACurrent = temp / 10;//> 1000 ? data->rms->phaseACurrent : val; // Phase A current
-		    temp = (rmsData[6] | (rmsData[7] << 8));
-            data->rms->dcBusCurrent = temp / 10;//< 0 ? data->rms->dcBusCurrent : val2; //DC Bus current
-#ifdef DEBUG_RMS
-            printf("Phase A Current: %d\r\n", data->rms->phaseACurrent);
-			printf("DC Bus Current: %d\r\n", data->rms->dcBusCurrent);
-            printf("Phase B Current: %d\r\n", data->rms->phaseBCurrent); //FIXME This isnt actually being read in?
-#endif
-            break;
-		case (0xa7):
-
-			
-            temp = (rmsData[0] | (rmsData[1] << 8));
-            data->rms->dcBusVoltage = temp / 10.0;
-            
-           // data->rms->outputVoltageLn = val2; //Voltage line to netural 
-#ifdef DEBUG_RMS
-            printf("DC Bus Voltage: %d\r\n", data->rms->dcBusVoltage);
-			printf("Output Voltage line: %d\r\n", data->rms->outputVoltageLn);
-#endif
-            break;
-		case (0xa8):
-			break;
-		case (0xa9):
-			data->rms->lvVoltage = (rmsData[6] | (rmsData[7] << 8)) / 100;
-#ifdef DEBUG_RMS
-            printf("LV Voltage: %d\r\n", data->rms->lvVoltage);
-#endif
-            break;
-
-		case (0xaa):
-			data->rms->canCode1 = (rmsData[3] << 24) | (rmsData[2] << 16) | (rmsData[1] << 8) | rmsData[0];
-			data->rms->canCode2 = (rmsData[7] << 24) | (rmsData[6] << 16) | (rmsData[5] << 8) | rmsData[4];
-#ifdef DEBUG_RMS
-            printf("CAN Code 1: %lld\r\n", (long long int) data->rms->canCode1);
-			printf("CAN Code 2: %lld\r\n", (long long int) data->rms->canCode2);
-#endif
-            break;
-		case (0xab):
-			data->rms->faultCode1 = (rmsData[3] << 24) | (rmsData[2] << 16) | (rmsData[1] << 8) | rmsData[0];
-			data->rms->faultCode2 = (rmsData[7] << 24) | (rmsData[6] << 16) | (rmsData[5] << 8) | rmsData[4];
-#ifdef DEBUG_RMS
-            printf("Fault Code 1: %lld\r\n", (long long int) data->rms->faultCode1);
-			printf("Fault Code 2: %lld\r\n", (long long int) data->rms->faultCode2);
-#endif
-            break;
-		case (0xac):
-			data->rms->commandedTorque = (rmsData[0] | (rmsData[1] << 8));// > 200 ? data->rms->commandedTorque : val; 
-			data->rms->commandedTorque /= 10;
-            data->rms->actualTorque = (rmsData[2] | (rmsData[3] << 8));// / 10;
-            data->rms->actualTorque /= 10;
-#ifdef DEBUG_RMSi
-            printf("Commanded Torque: %d\r\n", data->rms->commandedTorque);
-			printf("Actual Torque: %d\r\n", data->rms->actualTorque);
-#endif
-            break;
-		case (0xad):
-			break;
-		case (0xae):
-			break;
-		case (0xaf):
-			break;
+        RMS_MESSAGES(CAN_DECODER_CASE)
 		default:
 			return 1;
 	}
 	return 0;
 }
+
+/* Hooks the RMS broadcast messages into the CAN dispatcher */
+void rmsRegisterCan() {
+    RMS_MESSAGES(CAN_REGISTER_DECODER)
+}
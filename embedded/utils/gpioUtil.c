@@ -4,10 +4,15 @@
 #include <string.h>
 #include "mcp23017.h"
 #include "i2c.h"
+#include "bbgpio.h"
+#include "data.h"
 
-#define LIST 0
-#define GET  1
-#define SET  2
+#define LIST     0
+#define GET      1
+#define SET      2
+#define BBGET    3
+#define BBSET    4
+#define BBTOGGLE 5
 
 extern const int NUM_PINS;
 
@@ -17,6 +22,10 @@ void printUsage(void) {
     printf("\t<DEV NUM> : \n\t\tGPIO Device number, try list to check\n");
     printf("\t<PIN>     : \n\t\tThe pin on the device (0-7 on bank A, 8-15 on bank B)\n");
     printf("\t<VAL>     : \n\t\tUsed with the set command, sets a pin to val, should be 0 or 1\n");
+    printf("USAGE: bloopGpio <BBCMD> <GPIO> <VAL>\n");
+    printf("\t<BBCMD>   : \n\t\tbbget\n\t\tbbset\n\t\tbbtoggle\n");
+    printf("\t<GPIO>    : \n\t\tBeagleBone sysfs GPIO number (bank * 32 + pin), must be exported\n");
+    printf("\t<VAL>     : \n\t\t0 or 1 for bbset, how many times to toggle for bbtoggle\n");
 }
 
 void printPin(i2c_settings *dev, uint8_t pin) {
@@ -53,11 +62,47 @@ int parseCommand(char *cmd, int argc) {
             exit(-1);
         }
         return SET;
+    } else if (strcmp(cmd, "bbget") == 0 || strcmp(cmd, "bbset") == 0 ||
+            strcmp(cmd, "bbtoggle") == 0) {
+        if (argc != (cmd[2] == 'g' ? 3 : 4)) {
+            fprintf(stderr, "Invalid number of arguements for a %s command\n", cmd);
+            printUsage();
+            exit(-1);
+        }
+        return cmd[2] == 'g' ? BBGET : cmd[2] == 's' ? BBSET : BBTOGGLE;
     } else {
         return -1;
     }
 }
 
+/* The on board GPIOs, through a handle that keeps the value file open */
+int bbCommand(int cmd, char *argv[]) {
+    bbGpioPin_t pin;
+    uint64_t start, elapsed;
+    int val, i, n;
+
+    if (bbGpioPinOpen(&pin, atoi(argv[2])) != 0) return -1;
+    if (cmd == BBGET) {
+        val = bbGpioPinGet(&pin);
+        if (val < 0) return -1;
+        printf("GPIO %u\n\tstate = %d\n\tdir = %s\n", pin.gpio, val, bbGpioGetDir(pin.gpio));
+    } else if (cmd == BBSET) {
+        if (bbGpioPinSet(&pin, atoi(argv[3])) != 0) return -1;
+        printf("Success\n");
+    } else {
+        /* Handy with a scope on the pin to see how fast it can go */
+        n = atoi(argv[3]);
+        start = getuSTimestamp();
+        for (i = 0; i < n; i++) {
+            if (bbGpioPinSet(&pin, i & 1) != 0) return -1;
+        }
+        elapsed = getuSTimestamp() - start;
+        printf("%d toggles in %llu uS, %.0f toggles/s\n", n, (unsigned long long) elapsed,
+                elapsed ? n * 1000000.0 / elapsed : 0);
+    }
+    return 0;
+}
+
 void printAllDevs(void) {
     int addr = 0x20;
     FILE *fp = fopen("/dev/null", "w");
@@ -96,6 +141,14 @@ int main(int argc, char *argv[]) {
         return 0;
     }
 
+    if (cmd == BBGET || cmd == BBSET || cmd == BBTOGGLE) {
+        if (bbCommand(cmd, argv) != 0) {
+            fprintf(stderr, "Error, exiting\n");
+            exit(-1);
+        }
+        return 0;
+    }
+
     int addr = atoi(argv[2]);
 
     if (addr < 0x20 || addr > 0x27) {
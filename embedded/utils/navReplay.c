@@ -0,0 +1,212 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include "navKalman.h"
+
+/* Runs nav's Kalman filter offline so it can be tuned without the pod.
+ *
+ * Given a log (build with NAVLOG=1 and save what nav prints), it replays every
+ * tick and strip through the filter. With no log it makes up a run: speed
+ * up, coast, brake hard, with a noisy and biased IMU and a strip every 10 ft.
+ * It knows the truth for that one, so it prints how far off the filter and
+ * the old strip-only estimate were, and how long each took to notice the
+ * brakes. */
+
+#define STRIP_DISTANCE  (10 * 0.3048)   /* m */
+#define TICK_US         10000
+
+/* The made up run */
+#define SIM_ACCEL       5.0     /* m/s/s for SIM_ACCEL_S */
+#define SIM_ACCEL_S     4.0
+#define SIM_COAST_S     2.0
+#define SIM_BRAKE       -9.8
+#define SIM_IMU_BIAS    0.2     /* m/s/s */
+#define SIM_IMU_NOISE   0.3
+#define BRAKE_NOTICED   1.0     /* m/s slower than when braking started */
+
+typedef struct stats_t {
+    double posSq, velSq;
+    uint64_t n;
+    double brakeVel;            /* What it thought the speed was when the brakes went on */
+    double noticed;             /* S after braking started, <0 if never */
+} stats_t;
+
+static FILE *out = NULL;
+
+void printUsage(void) {
+    printf("USAGE: navReplay [-a accelNoise] [-b biasDrift] [-s stripNoise] [-i initBias]\n"
+           "                 [-n] [-o out.csv] [log.csv]\n");
+    printf("\t-a -b -s -i : Filter parameters, see navKalman.h\n");
+    printf("\t-n          : No IMU, use the NAV_KF_NO_IMU defaults and ignore acceleration\n");
+    printf("\t-o          : Write time,pos,vel,accel,bias for every tick\n");
+    printf("\tlog.csv     : time,accel,retroCount,lastRetro lines from nav with DEBUG_NAV.\n"
+           "\t              Without one, a made up run is used\n");
+}
+
+static void writeTick(const navKf_t *kf) {
+    if (out) {
+        fprintf(out, "%llu,%f,%f,%f,%f\n", (unsigned long long) kf->time, kf->x[NAV_KF_POS],
+                kf->x[NAV_KF_VEL], kf->accel, kf->x[NAV_KF_BIAS]);
+    }
+}
+
+static int replay(navKf_t *kf, FILE *log, int noImu) {
+    unsigned long long time, lastRetro;
+    double accel;
+    int count, lastCount = 0, ticks = 0, strips = 0;
+    char line[256];
+    double worst = 0, innov;
+
+    while (fgets(line, sizeof(line), log)) {
+        /* Skips headers and anything else nav printed */
+        if (sscanf(line, "%llu,%lf,%d,%llu", &time, &accel, &count, &lastRetro) != 4) continue;
+        if (noImu) accel = 0;
+        if (count != lastCount) {
+            innov = navKfCorrect(kf, lastRetro, count * STRIP_DISTANCE);
+            if (fabs(innov) > fabs(worst)) worst = innov;
+            strips++;
+        }
+        lastCount = count;
+        navKfPredict(kf, time, accel);
+        writeTick(kf);
+        ticks++;
+    }
+    printf("%d ticks, %d strips, worst correction %.3f m\n", ticks, strips, worst);
+    printf("ended at %.2f m, %.2f m/s, bias %.3f m/s/s\n", kf->x[NAV_KF_POS],
+            kf->x[NAV_KF_VEL], kf->x[NAV_KF_BIAS]);
+    return 0;
+}
+
+/* Standard normal, Box-Muller. Seeded so every run is the same */
+static double gaussian() {
+    double u1 = (rand() + 1.0) / (RAND_MAX + 2.0);
+    double u2 = (rand() + 1.0) / (RAND_MAX + 2.0);
+    return sqrt(-2 * log(u1)) * cos(2 * M_PI * u2);
+}
+
+static void track(stats_t *s, double pos, double vel, double truePos, double trueVel,
+        double brakeT, double t) {
+    s->posSq += (pos - truePos) * (pos - truePos);
+    s->velSq += (vel - trueVel) * (vel - trueVel);
+    s->n++;
+    if (t <= brakeT) {
+        s->brakeVel = vel;
+    } else if (s->noticed < 0 && vel < s->brakeVel - BRAKE_NOTICED) {
+        s->noticed = t - brakeT;
+    }
+}
+
+static void showStats(const char *name, const stats_t *s) {
+    printf("%-12s pos %6.3f m RMS, vel %6.3f m/s RMS, ", name,
+            sqrt(s->posSq / s->n), sqrt(s->velSq / s->n));
+    if (s->noticed < 0) {
+        printf("never noticed braking\n");
+    } else {
+        printf("noticed braking after %.0f mS\n", s->noticed * 1000);
+    }
+}
+
+static int simulate(navKf_t *kf, int noImu) {
+    double brakeT = 1 + SIM_ACCEL_S + SIM_COAST_S;
+    double t = 0, dt = TICK_US / 1000000.0, a, pos = 0, vel = 0, imu;
+    double oldPos = 0, oldVel = 0, lastStripT = 0, prevPos, prevT, stripT;
+    int count = 0, tick = 0;
+    uint64_t now;
+    stats_t kfStats = { 0, 0, 0, 0, -1 }, oldStats = { 0, 0, 0, 0, -1 };
+
+    srand(1);
+    while (tick < 2 / dt || vel > 0) {
+        /* Truth for the next tick */
+        if (t < 1) a = 0;
+        else if (t < 1 + SIM_ACCEL_S) a = SIM_ACCEL;
+        else if (t < brakeT) a = 0;
+        else a = SIM_BRAKE;
+        prevPos = pos;
+        prevT = t;
+        vel += a * dt;
+        if (vel < 0) vel = 0;
+        pos += vel * dt;
+        t = ++tick * dt;
+        now = (uint64_t) (t * 1000000 + 0.5);
+        imu = noImu ? 0 : a + SIM_IMU_BIAS + SIM_IMU_NOISE * gaussian();
+
+        /* A strip somewhere in this tick, the retro is stamped when it passed */
+        if (pos >= (count + 1) * STRIP_DISTANCE) {
+            count++;
+            stripT = prevT + dt * ((count * STRIP_DISTANCE - prevPos) / (pos - prevPos));
+            navKfCorrect(kf, (uint64_t) (stripT * 1000000), count * STRIP_DISTANCE);
+
+            /* What FILTER_NONE does, differences between strips */
+            oldVel = (count * STRIP_DISTANCE - oldPos) / (stripT - lastStripT);
+            oldPos = count * STRIP_DISTANCE;
+            lastStripT = stripT;
+        }
+        navKfPredict(kf, now, imu);
+        writeTick(kf);
+
+        track(&kfStats, kf->x[NAV_KF_POS], kf->x[NAV_KF_VEL], pos, vel, brakeT, t);
+        track(&oldStats, oldPos, oldVel, pos, vel, brakeT, t);
+    }
+
+    printf("made up run: %.1f S, %.1f m, %d strips, top speed %.1f m/s\n", t, pos, count,
+            SIM_ACCEL * SIM_ACCEL_S);
+    showStats("kalman", &kfStats);
+    showStats("strips only", &oldStats);
+    if (!noImu) printf("bias estimate %.3f m/s/s, really %.3f\n", kf->x[NAV_KF_BIAS], SIM_IMU_BIAS);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    navKfParams_t withImu = NAV_KF_DEFAULTS, noImuParams = NAV_KF_NO_IMU, params;
+    navKfParams_t given = { -1, -1, -1, -1 };
+    navKf_t kf;
+    FILE *log;
+    int opt, noImu = 0, ret;
+
+    while ((opt = getopt(argc, argv, "a:b:s:i:no:h")) != -1) {
+        switch (opt) {
+            case 'a': given.accelNoise = atof(optarg); break;
+            case 'b': given.biasDrift = atof(optarg); break;
+            case 's': given.stripNoise = atof(optarg); break;
+            case 'i': given.initBias = atof(optarg); break;
+            case 'n': noImu = 1; break;
+            case 'o':
+                out = fopen(optarg, "w");
+                if (out == NULL) {
+                    perror("navReplay");
+                    return -1;
+                }
+                fprintf(out, "time,pos,vel,accel,bias\n");
+                break;
+            default:
+                printUsage();
+                return -1;
+        }
+    }
+
+    params = noImu ? noImuParams : withImu;
+    if (given.accelNoise >= 0) params.accelNoise = given.accelNoise;
+    if (given.biasDrift >= 0) params.biasDrift = given.biasDrift;
+    if (given.stripNoise >= 0) params.stripNoise = given.stripNoise;
+    if (given.initBias >= 0) params.initBias = given.initBias;
+    printf("accelNoise %g, biasDrift %g, stripNoise %g, initBias %g\n", params.accelNoise,
+            params.biasDrift, params.stripNoise, params.initBias);
+    navKfInit(&kf, &params);
+
+    if (optind < argc) {
+        log = fopen(argv[optind], "r");
+        if (log == NULL) {
+            perror("navReplay");
+            return -1;
+        }
+        ret = replay(&kf, log, noImu);
+        fclose(log);
+    } else {
+        ret = simulate(&kf, noImu);
+    }
+    if (out) fclose(out);
+    return ret;
+}
@@ -0,0 +1,123 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "HVTCPSocket.h"
+#include "LVTCPSocket.h"
+#include "check.h"
+
+extern "C" {
+	#include "data.h"
+	#include "connStat.h"
+	#include "i2c.h"
+	#include "mcp23017.h"
+	#include "lv_iox.h"
+	#include "fakeMcp.h"
+}
+
+/* Times a brake command from HV to the solenoid write on LV's expander, over
+ * loopback, with LV's real servers and a made up MCP23017 on bus 2. First the
+ * old way, a new connection to LV_SERVER_PORT per command, then signalLV()
+ * over the connection it keeps open to LV_CMD_PORT. Loopback has no wire
+ * delay, so the difference is all handshakes, teardowns and accept()s, which
+ * a real link only makes worse. */
+
+#define NUM_CMDS        200
+#define MAX_WAIT_US     100000
+
+static fakeMcp_t iox;
+
+/* What signalLV() used to do */
+static void connectPerCommand(char *cmd) {
+	struct sockaddr_in addr;
+	int fd = socket(AF_INET, SOCK_STREAM, 0);
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+	addr.sin_port = htons(LV_SERVER_PORT);
+	if (connect(fd, (struct sockaddr *) &addr, sizeof(addr)) == 0) {
+		write(fd, cmd, strlen(cmd));
+	}
+	close(fd);
+}
+
+typedef struct result_t {
+	double avg;
+	uint64_t worst;
+	int missed;
+} result_t;
+
+static result_t run(void (*sender)(char *)) {
+	result_t r = { 0, 0, 0 };
+	uint64_t start, written, latency = 0, total = 0;
+	int i, wait;
+
+	for (i = 0; i < NUM_CMDS; i++) {
+		written = fakeMcpOlatbChanged(&iox);
+		start = getuSTimestamp();
+		/* The solenoids start off, which is already actuated */
+		sender((char *) ((i & 1) ? "primBrakeOn" : "primBrakeOff"));
+		for (wait = 0; wait < MAX_WAIT_US / 10; wait++) {
+			latency = fakeMcpOlatbChanged(&iox);
+			if (latency != written) break;
+			usleep(10);
+		}
+		if (latency == written) {
+			r.missed++;
+			continue;
+		}
+		latency -= start;
+		total += latency;
+		if (latency > r.worst) r.worst = latency;
+	}
+	if (r.missed < NUM_CMDS) r.avg = (double) total / (NUM_CMDS - r.missed);
+	return r;
+}
+
+int main() {
+	result_t before, after, during;
+	uint64_t start;
+
+	initData();
+	if (fakeMcpStart(&iox, 2, NULL) != 0) return -1;
+	CHECK("LV iox", initLVIox(true) == 0);
+
+	SetupLVTCPServer();
+	setLVCommandTarget("127.0.0.1", LV_CMD_PORT);
+	usleep(100000);
+
+	before = run(connectPerCommand);
+	after = run(signalLV);
+	printf("connection per command: avg %6.1f uS, worst %5llu uS, %d missed\n",
+			before.avg, (unsigned long long) before.worst, before.missed);
+	printf("persistent connection:  avg %6.1f uS, worst %5llu uS, %d missed\n",
+			after.avg, (unsigned long long) after.worst, after.missed);
+
+	CHECK("every old style command arrived", before.missed == 0);
+	CHECK("every command arrived", after.missed == 0);
+	CHECK("persistent is faster", after.avg < before.avg);
+
+	/* A dashboard brake holds its server for half a second, HV's commands
+	 * get through on their own one */
+	connectPerCommand((char *) "brake");
+	usleep(20000);
+	during = run(signalLV);
+	printf("during a dashboard brake: avg %6.1f uS, worst %5llu uS, %d missed\n",
+			during.avg, (unsigned long long) during.worst, during.missed);
+	CHECK("dashboard brake doesn't hold up HV", during.missed == 0 && during.worst < 50000);
+
+	/* Nothing listening, signalLV() gives up without holding up HV's loop */
+	setLVCommandTarget("127.0.0.1", LV_CMD_PORT + 100);
+	start = getuSTimestamp();
+	signalLV((char *) "brake");
+	signalLV((char *) "brake");
+	CHECK("no LV doesn't stall", getuSTimestamp() - start < 250000);
+
+	return checkResult();
+}
@@ -0,0 +1,233 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include "CmdServer.h"
+#include "check.h"
+
+extern "C" {
+	#include "data.h"
+}
+
+/* Compares the old command server, which accepted a connection, did one read
+ * and closed it, against runCmdServer() over loopback: ping round trips, a
+ * burst of commands, and what each does with commands that arrive
+ * together or split up. Also checks an old style client still gets its
+ * pong. Loopback has no wire delay, so on the pod every handshake saved is
+ * worth more. */
+
+#define OLD_PORT        9191
+#define NEW_PORT        9192
+#define NUM_PINGS       500
+#define NUM_BURST       500
+#define WAIT_US         1000000
+
+
+static int numCmds = 0;
+
+static void handler(const char *cmd, int replyFd) {
+	__atomic_fetch_add(&numCmds, 1, __ATOMIC_RELAXED);
+	if (!strcmp(cmd, "ping")) send(replyFd, (char *) "pong", 4, 0);
+}
+
+/* The loop TCPLoop and LVTCPLoop used to run */
+static void *oldServer(void *arg) {
+	(void) arg;
+	struct sockaddr_in address;
+	int server_fd, new_socket, opt = 1;
+
+	server_fd = socket(AF_INET, SOCK_STREAM, 0);
+	setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR | SO_REUSEPORT, &opt, sizeof(opt));
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = INADDR_ANY;
+	address.sin_port = htons(OLD_PORT);
+	if (bind(server_fd, (struct sockaddr *) &address, sizeof(address)) < 0 ||
+			listen(server_fd, 3) < 0) {
+		fprintf(stderr, "Error binding port %d\n", OLD_PORT);
+		return NULL;
+	}
+	while (1) {
+		char buffer[1024] = {0};
+		if ((new_socket = accept(server_fd, NULL, NULL)) < 0) continue;
+		read(new_socket, buffer, 1024);
+		handler(buffer, new_socket);
+		close(new_socket);
+	}
+	return NULL;
+}
+
+static void *newServer(void *arg) {
+	(void) arg;
+	int ports[] = { NEW_PORT };
+	runCmdServer(ports, 1, handler);
+	fprintf(stderr, "Error starting command server\n");
+	return NULL;
+}
+
+static int connectTo(int port) {
+	struct sockaddr_in addr;
+	int fd = socket(AF_INET, SOCK_STREAM, 0), opt = 1;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+	addr.sin_port = htons(port);
+	if (connect(fd, (struct sockaddr *) &addr, sizeof(addr)) != 0) {
+		close(fd);
+		return -1;
+	}
+	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+	return fd;
+}
+
+static bool sendAll(int fd, const char *buf, int len) {
+	int n;
+	while (len > 0) {
+		if ((n = write(fd, buf, len)) <= 0) return false;
+		buf += n;
+		len -= n;
+	}
+	return true;
+}
+
+static bool gotPong(int fd) {
+	char reply[8];
+	return read(fd, reply, sizeof(reply)) == 4 && !strncmp(reply, "pong", 4);
+}
+
+/* Waits for the servers to have run n commands since reset() */
+static bool waitFor(int n) {
+	int i;
+	for (i = 0; i < WAIT_US / 10; i++) {
+		if (__atomic_load_n(&numCmds, __ATOMIC_RELAXED) >= n) return true;
+		usleep(10);
+	}
+	return false;
+}
+
+static void reset() {
+	usleep(10000);
+	__atomic_store_n(&numCmds, 0, __ATOMIC_RELAXED);
+}
+
+static void testPings() {
+	uint64_t start, oldUs, newUs;
+	int i, fd, oldOk = 0, newOk = 0;
+
+	start = getuSTimestamp();
+	for (i = 0; i < NUM_PINGS; i++) {
+		if ((fd = connectTo(OLD_PORT)) < 0) continue;
+		if (sendAll(fd, "ping", 4) && gotPong(fd)) oldOk++;
+		close(fd);
+	}
+	oldUs = getuSTimestamp() - start;
+
+	fd = connectTo(NEW_PORT);
+	start = getuSTimestamp();
+	for (i = 0; i < NUM_PINGS; i++) {
+		if (sendAll(fd, "ping\n", 5) && gotPong(fd)) newOk++;
+	}
+	newUs = getuSTimestamp() - start;
+	close(fd);
+
+	printf("ping round trip:   old %6.1f uS, new %6.1f uS\n",
+			(double) oldUs / NUM_PINGS, (double) newUs / NUM_PINGS);
+	CHECK("old pongs", oldOk == NUM_PINGS);
+	CHECK("new pongs", newOk == NUM_PINGS);
+	CHECK("new pings faster", newUs < oldUs);
+}
+
+static void testBurst() {
+	static char burst[NUM_BURST * 10];
+	uint64_t start, oldUs, newUs;
+	int i, fd, len = 0;
+
+	/* The old server's backlog of 3 fills up, and a dropped connect
+	 * waits a second before it tries again */
+	reset();
+	start = getuSTimestamp();
+	for (i = 0; i < NUM_BURST; i++) {
+		if ((fd = connectTo(OLD_PORT)) < 0) continue;
+		sendAll(fd, "readyPump", 9);
+		close(fd);
+	}
+	CHECK("old burst all run", waitFor(NUM_BURST));
+	oldUs = getuSTimestamp() - start;
+
+	reset();
+	for (i = 0; i < NUM_BURST; i++) len += sprintf(burst + len, "readyPump\n");
+	fd = connectTo(NEW_PORT);
+	start = getuSTimestamp();
+	sendAll(fd, burst, len);
+	CHECK("new burst all run", waitFor(NUM_BURST));
+	newUs = getuSTimestamp() - start;
+	close(fd);
+
+	printf("%d commands:     old %6.0f per S, new %8.0f per S\n", NUM_BURST,
+			NUM_BURST * 1e6 / oldUs, NUM_BURST * 1e6 / newUs);
+	CHECK("new burst faster", newUs < oldUs);
+}
+
+static void testFraming() {
+	int fd, oldRun;
+
+	/* Three commands that arrive in one read */
+	reset();
+	fd = connectTo(OLD_PORT);
+	sendAll(fd, "propulse\npropulse\npropulse\n", 27);
+	close(fd);
+	waitFor(3);
+	oldRun = __atomic_load_n(&numCmds, __ATOMIC_RELAXED);
+
+	reset();
+	fd = connectTo(NEW_PORT);
+	sendAll(fd, "propulse\npropulse\npropulse\n", 27);
+	CHECK("coalesced all run", waitFor(3));
+	printf("3 in one read:     old ran %d, new ran %d\n", oldRun,
+			__atomic_load_n(&numCmds, __ATOMIC_RELAXED));
+
+	/* And one split in two */
+	sendAll(fd, "pi", 2);
+	usleep(10000);
+	sendAll(fd, "ng\r\n", 4);
+	CHECK("split put back together", gotPong(fd));
+	close(fd);
+
+	/* Old clients still get answered, and can leave the connection open */
+	fd = connectTo(NEW_PORT);
+	sendAll(fd, "ping", 4);
+	CHECK("unframed ping", gotPong(fd));
+	sendAll(fd, "ping", 4);
+	CHECK("unframed ping again", gotPong(fd));
+	close(fd);
+
+	/* A last command with no newline runs when the client closes */
+	reset();
+	fd = connectTo(NEW_PORT);
+	sendAll(fd, "propulse\nprop", 13);
+	usleep(10000);
+	sendAll(fd, "ulse", 4);
+	close(fd);
+	CHECK("last command on close", waitFor(2));
+}
+
+int main() {
+	pthread_t oldThread, newThread;
+
+	pthread_create(&oldThread, NULL, oldServer, NULL);
+	pthread_create(&newThread, NULL, newServer, NULL);
+	usleep(100000);
+
+	testPings();
+	testBurst();
+	testFraming();
+
+	return checkResult();
+}
@@ -0,0 +1,130 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "CmdTable.h"
+#include "check.h"
+
+extern "C" {
+	#include "data.h"
+}
+
+/* Builds a table like HV's and checks commands reach the right handler with
+ * the right argument, and that anything else is answered and not run. Then
+ * times dispatch against the strncmp chain TCPLoop used to run, which
+ * compared every command against every name. */
+
+#define NUM_DISPATCHES  1000000
+
+static const char *lastRun;
+static long lastNum;
+static const char *lastStr;
+static volatile int runs;
+
+static void noArg(const cmdArgs_t *args) {
+	(void) args;
+	lastRun = "noArg";
+	runs++;
+}
+
+static void intArg(const cmdArgs_t *args) {
+	lastRun = "intArg";
+	lastNum = args->num;
+	runs++;
+}
+
+static void strArg(const cmdArgs_t *args) {
+	lastRun = "strArg";
+	lastStr = args->str;
+	runs++;
+}
+
+static void ping(const cmdArgs_t *args) {
+	send(args->replyFd, "pong", 4, 0);
+	runs++;
+}
+
+static const cmdDef_t defs[] = {
+	{ "readyPump",      CMD_ARG_NONE,   noArg },
+	{ "pumpDown",       CMD_ARG_NONE,   noArg },
+	{ "readyCommand",   CMD_ARG_NONE,   noArg },
+	{ "propulse",       CMD_ARG_NONE,   noArg },
+	{ "emergencyBrake", CMD_ARG_NONE,   noArg },
+	{ "mcuLatchOn",     CMD_ARG_NONE,   noArg },
+	{ "mcuLatchOff",    CMD_ARG_NONE,   noArg },
+	{ "enPrecharge",    CMD_ARG_NONE,   noArg },
+	{ "cmdTorque",      CMD_ARG_NONE,   noArg },
+	{ "hvEnable",       CMD_ARG_NONE,   noArg },
+	{ "hvDisable",      CMD_ARG_NONE,   noArg },
+	{ "power off",      CMD_ARG_NONE,   noArg },
+	{ "state",          CMD_ARG_INT,    intArg },
+	{ "override",       CMD_ARG_STRING, strArg },
+	{ "ping",           CMD_ARG_NONE,   ping },
+};
+#define NUM_DEFS    ((int) (sizeof(defs) / sizeof(defs[0])))
+
+/* What TCPLoop did, every name checked whatever the command was */
+static void strncmpChain(const char *cmd) {
+	int i;
+	for (i = 0; i < NUM_DEFS; i++) {
+		if (defs[i].argType == CMD_ARG_NONE && !strncmp(cmd, defs[i].name, 1024)) runs++;
+		if (defs[i].argType != CMD_ARG_NONE && !strncmp(cmd, defs[i].name, strlen(defs[i].name))) runs++;
+	}
+}
+
+/* Dispatches cmd and returns what came back on the socket, if anything */
+static const char *reply(cmdTable_t *table, const char *cmd, int *ret) {
+	static char buf[128];
+	int sv[2], n;
+
+	socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv);
+	*ret = cmdDispatch(table, cmd, sv[0]);
+	n = recv(sv[1], buf, sizeof(buf) - 1, MSG_DONTWAIT);
+	buf[n > 0 ? n : 0] = '\0';
+	close(sv[0]);
+	close(sv[1]);
+	return buf;
+}
+
+int main() {
+	static cmdTable_t table;
+	cmdDef_t twice[2] = { defs[0], defs[0] };
+	const char *cmds[] = { "propulse", "state 1", "hvDisable", "emergencyBrake" };
+	uint64_t start, chainUs, tableUs;
+	int i, ret;
+
+	CHECK("init", cmdTableInit(&table, defs, NUM_DEFS) == 0);
+	CHECK("same name twice", cmdTableInit(&table, twice, 2) == -1);
+	CHECK("init again", cmdTableInit(&table, defs, NUM_DEFS) == 0);
+
+	CHECK("no arg", cmdDispatch(&table, "propulse", -1) == 0 && !strcmp(lastRun, "noArg"));
+	CHECK("name with a space", cmdDispatch(&table, "power off", -1) == 0);
+	CHECK("int arg", cmdDispatch(&table, "state 1", -1) == 0 && !strcmp(lastRun, "intArg") &&
+			lastNum == 1);
+	CHECK("string arg", cmdDispatch(&table, "override idle", -1) == 0 &&
+			!strcmp(lastRun, "strArg") && !strcmp(lastStr, "idle"));
+	CHECK("ping", !strcmp(reply(&table, "ping", &ret), "pong") && ret == 0);
+
+	runs = 0;
+	CHECK("unknown", !strcmp(reply(&table, "pingg", &ret), "unknown: pingg") && ret == -1);
+	CHECK("prefix isn't a match", !strcmp(reply(&table, "pin", &ret), "unknown: pin"));
+	CHECK("unexpected arg", !strcmp(reply(&table, "propulse now", &ret), "bad argument: propulse now"));
+	CHECK("missing arg", !strcmp(reply(&table, "override", &ret), "bad argument: override"));
+	CHECK("empty arg", !strcmp(reply(&table, "override ", &ret), "bad argument: override "));
+	CHECK("not a number", !strcmp(reply(&table, "state 1x", &ret), "bad argument: state 1x"));
+	CHECK("old state format", !strcmp(reply(&table, "state1", &ret), "unknown: state1"));
+	CHECK("nothing rejected ran", runs == 0);
+
+	start = getuSTimestamp();
+	for (i = 0; i < NUM_DISPATCHES; i++) strncmpChain(cmds[i & 3]);
+	chainUs = getuSTimestamp() - start;
+	start = getuSTimestamp();
+	for (i = 0; i < NUM_DISPATCHES; i++) cmdDispatch(&table, cmds[i & 3], -1);
+	tableUs = getuSTimestamp() - start;
+	printf("%d commands: strncmp chain %.1f nS, table %.1f nS each\n", NUM_DEFS,
+			chainUs * 1000.0 / NUM_DISPATCHES, tableUs * 1000.0 / NUM_DISPATCHES);
+
+	return checkResult();
+}
@@ -0,0 +1,312 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "TelemSchema.h"
+#include "HV_Telem_Recv.h"
+#include "document.h"
+#include "writer.h"
+
+extern "C" {
+	#include "data.h"
+}
+
+/* Compares the old DOM way of building the HV telemetry packet against the
+ * SAX serializer HVTelemetryLoop uses now and the binary format, then
+ * simulates a second of the field schedule to see how much it saves over
+ * sending everything, and times HV_Telem_Recv decoding an LV packet in both
+ * formats. Runs anywhere, no sockets or hardware are touched. */
+
+#define NUM_PACKETS 200000
+#define SIM_TICKS   (1000000 / TELEM_TICK_US)
+#define ALL_FIELDS  (~0ULL)
+
+using namespace rapidjson;
+
+extern data_t *data;
+
+/* Counts every heap allocation (malloc, new, rapidjson's allocators) by
+ * wrapping glibc's malloc */
+extern "C" {
+	extern void *__libc_malloc(size_t size);
+	extern void *__libc_calloc(size_t n, size_t size);
+	extern void *__libc_realloc(void *ptr, size_t size);
+}
+static volatile uint64_t numAllocs = 0;
+
+extern "C" void *malloc(size_t size) {
+	numAllocs++;
+	return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t n, size_t size) {
+	numAllocs++;
+	return __libc_calloc(n, size);
+}
+
+extern "C" void *realloc(void *ptr, size_t size) {
+	numAllocs++;
+	return __libc_realloc(ptr, size);
+}
+
+/* Same Documents, Values and Writer that HVTelemetryLoop used to build, with
+ * time moved up next to id where the field tables put it */
+static size_t domPacket(char *out, uint64_t id, uint64_t timeMs, int imdStatus) {
+	Document document;
+	document.SetObject();
+	Value packet_id;
+	packet_id.SetUint64(id);
+	Value age;
+	age.SetUint64(timeMs);
+	Value state;
+	state.SetInt(data->state);
+	Value packV, packC, packSOC, packAH, cellMaxV, cellMinV;
+	packV.SetFloat(data->bms->packVoltage);
+	packC.SetFloat(data->bms->packCurrent);
+	packSOC.SetUint(data->bms->Soc);
+	packAH.SetUint(data->bms->packAh);
+	cellMaxV.SetFloat(data->bms->cellMaxVoltage);
+	cellMinV.SetFloat(data->bms->cellMinVoltage);
+	Value maxCellTemp, minCellTemp, avgCellTemp;
+	maxCellTemp.SetUint(data->bms->highTemp);
+	minCellTemp.SetUint(data->bms->lowTemp);
+	avgCellTemp.SetUint(data->bms->avgTemp);
+	Value igbtT, gateDrvTemp, cntrlBoardTemp, motorTemp, motorSpeed;
+	igbtT.SetUint(data->rms->igbtTemp);
+	gateDrvTemp.SetUint(data->rms->gateDriverBoardTemp);
+	cntrlBoardTemp.SetUint(data->rms->controlBoardTemp);
+	motorTemp.SetUint(data->rms->motorTemp);
+	motorSpeed.SetInt(data->rms->motorSpeed);
+	Value phaseACurrent, busCurrent, busV, cmdT, torqueFdbk, imd;
+	phaseACurrent.SetInt(data->rms->phaseACurrent);
+	busCurrent.SetInt(data->rms->dcBusCurrent);
+	busV.SetInt(data->rms->dcBusVoltage);
+	cmdT.SetInt(data->rms->commandedTorque);
+	torqueFdbk.SetInt(data->rms->actualTorque);
+	imd.SetInt(imdStatus);
+
+	document.AddMember("id", packet_id, document.GetAllocator());
+	document.AddMember("time", age, document.GetAllocator());
+	Document batteryDoc;
+	batteryDoc.SetObject();
+	batteryDoc.AddMember("packVoltage", packV, batteryDoc.GetAllocator());
+	batteryDoc.AddMember("packCurrent", packC, batteryDoc.GetAllocator());
+	batteryDoc.AddMember("packSOC", packSOC, batteryDoc.GetAllocator());
+	batteryDoc.AddMember("packAH", packAH, batteryDoc.GetAllocator());
+	batteryDoc.AddMember("cellMaxVoltage", cellMaxV, batteryDoc.GetAllocator());
+	batteryDoc.AddMember("cellMinVoltage", cellMinV, batteryDoc.GetAllocator());
+	batteryDoc.AddMember("imdStatus", imd, batteryDoc.GetAllocator());
+	batteryDoc.AddMember("maxCellTemp", maxCellTemp, batteryDoc.GetAllocator());
+	batteryDoc.AddMember("minCellTemp", minCellTemp, batteryDoc.GetAllocator());
+	batteryDoc.AddMember("avgCellTemp", avgCellTemp, batteryDoc.GetAllocator());
+	Document motorDoc;
+	motorDoc.SetObject();
+	motorDoc.AddMember("phaseAIGBTTemp", igbtT, motorDoc.GetAllocator());
+	motorDoc.AddMember("gateDriverBoardTemp", gateDrvTemp, motorDoc.GetAllocator());
+	motorDoc.AddMember("controlBoardTemp", cntrlBoardTemp, motorDoc.GetAllocator());
+	motorDoc.AddMember("motorTemp", motorTemp, motorDoc.GetAllocator());
+	motorDoc.AddMember("motorSpeed", motorSpeed, motorDoc.GetAllocator());
+	motorDoc.AddMember("phaseACurrent", phaseACurrent, motorDoc.GetAllocator());
+	motorDoc.AddMember("busCurrent", busCurrent, motorDoc.GetAllocator());
+	motorDoc.AddMember("busVoltage", busV, motorDoc.GetAllocator());
+	motorDoc.AddMember("commandTorque", cmdT, motorDoc.GetAllocator());
+	motorDoc.AddMember("torqueFeedback", torqueFdbk, motorDoc.GetAllocator());
+	document.AddMember("motor", motorDoc, document.GetAllocator());
+	document.AddMember("battery", batteryDoc, document.GetAllocator());
+	document.AddMember("state", state, document.GetAllocator());
+
+	StringBuffer sb;
+	Writer<StringBuffer> writer(sb);
+	document.Accept(writer);
+	size_t len = strlen(sb.GetString());
+	memcpy(out, sb.GetString(), len);
+	return len;
+}
+
+/* Changes a few values every packet so neither path gets to cache anything */
+static void updateData(uint64_t i) {
+	data->bms->packVoltage = 270.0 + (i % 100) / 10.0;
+	data->bms->packCurrent = (i % 2650) / 10.0;
+	data->bms->cellMaxVoltage = 4.1 - (i % 7) / 1000.0;
+	data->rms->motorSpeed = i % 6000;
+	data->rms->dcBusCurrent = -(int16_t)(i % 300);
+}
+
+static void report(const char *name, uint64_t start, uint64_t end, uint64_t allocs, size_t bytes) {
+	printf("%-5s: %9.0f packets/s, %6.2f allocs/packet, %zu bytes\n", name,
+			NUM_PACKETS / ((end - start) / 1000000.0),
+			allocs / (double) NUM_PACKETS, bytes);
+}
+
+/* Runs the HV and LV schedules for a second of simulated time, pod moving
+ * the whole time, against sending every field every tick */
+static int simulateSchedule(const char *name, const telemField_t *fields, int n, uint8_t type) {
+	static char binOut[TELEM_MAX_PACKET];
+	telemFieldState_t state[TELEM_MAX_FIELDS] = {};
+	telemSnapshot_t snap;
+	TelemBuffer buf;
+	TelemWriter writer(buf);
+	uint64_t now = 1000000;
+	size_t jsonBytes = 0, binBytes = 0, fullJson = 0, fullBin = 0;
+	int packets = 0, numSent = 0;
+	int i, j;
+
+	for (i = 0; i < SIM_TICKS; i++, now += TELEM_TICK_US) {
+		updateData(i);
+		data->motion->pos += 0.5;
+		data->motion->vel = 50 + i / 10.0;
+		telemTakeSnapshot(&snap);
+		uint64_t mask = telemDueFields(fields, state, n, &snap, now);
+		if (mask != 0) {
+			jsonBytes += telemJsonPacket(fields, n, mask, &snap, writer, buf, i, now / 1000);
+			binBytes += telemBinPacket(fields, n, mask, &snap, type, binOut, i, now / 1000);
+			packets++;
+			for (j = 0; j < n; j++) if (mask & (1ULL << j)) numSent++;
+		}
+		fullJson += telemJsonPacket(fields, n, ALL_FIELDS, &snap, writer, buf, i, now / 1000);
+		fullBin += telemBinPacket(fields, n, ALL_FIELDS, &snap, type, binOut, i, now / 1000);
+	}
+	printf("%s: %d packets, %.1f fields/packet, JSON %zu B/s (all fields %zu B/s), "
+			"BIN %zu B/s (all fields %zu B/s)\n", name, packets,
+			packets ? numSent / (double) packets : 0.0, jsonBytes, fullJson, binBytes, fullBin);
+	return packets == SIM_TICKS ? 0 : 1;
+}
+
+/* Decodes a full LV packet, then the same packet with only position in it,
+ * which must not touch anything else */
+static int checkDecode(char *pkt, size_t len) {
+	static char partial[TELEM_MAX_PACKET + 1];
+	telemSnapshot_t snap;
+	TelemBuffer buf;
+	TelemWriter writer(buf);
+	uint64_t lastId = 1;
+	size_t partialLen;
+
+	data->motion->vel = 0;
+	data->pressure->primTank = 0;
+	if (HVTelemParse(pkt, len, &lastId) != 0) return 1;
+	if (data->motion->vel != 12.5 || data->pressure->primTank != 801.25) return 1;
+
+	data->motion->pos = 99;
+	telemTakeSnapshot(&snap);
+	if (telemIsBinary(pkt, len)) {
+		partialLen = telemBinPacket(lvTelemFields, numLvTelemFields, 1ULL << 1, &snap, TELEM_PKT_LV,
+				partial, 7, 0);
+	} else {
+		partialLen = telemJsonPacket(lvTelemFields, numLvTelemFields, 1ULL << 1, &snap, writer, buf, 7, 0);
+		memcpy(partial, buf.GetString(), partialLen);
+	}
+	partial[partialLen] = '\0';
+	data->motion->pos = 0;
+	if (HVTelemParse(partial, partialLen, &lastId) != 0) return 1;
+	return data->motion->pos != 99 || data->motion->vel != 12.5;
+}
+
+int main() {
+	static char domOut[TELEM_MAX_PACKET];
+	static char binOut[TELEM_MAX_PACKET];
+	static char jsonIn[TELEM_MAX_PACKET + 1];
+	TelemBuffer buf;
+	TelemWriter writer(buf);
+	telemSnapshot_t snap;
+	uint64_t start, end, allocs;
+	size_t domLen = 0, saxLen = 0, binLen = 0;
+	uint64_t lastId;
+	uint64_t i;
+
+	initData();
+	data->state = 3;
+	data->bms->Soc = 95;
+	data->rms->igbtTemp = 40;
+	telemIo.imdStatus = 1;
+
+	/* Both paths have to produce the exact same bytes */
+	updateData(1);
+	domLen = domPacket(domOut, 1, 1234567890123ULL, 1);
+	telemTakeSnapshot(&snap);
+	saxLen = telemJsonPacket(hvTelemFields, numHvTelemFields, ALL_FIELDS, &snap, writer, buf,
+			1, 1234567890123ULL);
+	if (domLen != saxLen || memcmp(domOut, buf.GetString(), domLen) != 0) {
+		fprintf(stderr, "Packets differ:\n  DOM: %.*s\n  SAX: %.*s\n", (int) domLen,
+				domOut, (int) saxLen, buf.GetString());
+		return 1;
+	}
+	printf("---Begin HV telemetry serializer benchmark, %d packets---\n", NUM_PACKETS);
+
+	allocs = numAllocs;
+	start = getuSTimestamp();
+	for (i = 0; i < NUM_PACKETS; i++) {
+		updateData(i);
+		domLen = domPacket(domOut, i, 1234567890123ULL + i, 1);
+	}
+	end = getuSTimestamp();
+	report("DOM", start, end, numAllocs - allocs, domLen);
+
+	allocs = numAllocs;
+	start = getuSTimestamp();
+	for (i = 0; i < NUM_PACKETS; i++) {
+		updateData(i);
+		telemTakeSnapshot(&snap);
+		saxLen = telemJsonPacket(hvTelemFields, numHvTelemFields, ALL_FIELDS, &snap, writer, buf,
+				i, 1234567890123ULL + i);
+	}
+	end = getuSTimestamp();
+	report("SAX", start, end, numAllocs - allocs, saxLen);
+	if (numAllocs != allocs) return 1;
+
+	allocs = numAllocs;
+	start = getuSTimestamp();
+	for (i = 0; i < NUM_PACKETS; i++) {
+		updateData(i);
+		telemTakeSnapshot(&snap);
+		binLen = telemBinPacket(hvTelemFields, numHvTelemFields, ALL_FIELDS, &snap, TELEM_PKT_HV,
+				binOut, i, 1234567890123ULL + i);
+	}
+	end = getuSTimestamp();
+	report("BIN", start, end, numAllocs - allocs, binLen);
+	printf("---End HV telemetry serializer benchmark---\n");
+
+	printf("---Begin telemetry schedule simulation, %d ticks---\n", SIM_TICKS);
+	if (simulateSchedule("HV", hvTelemFields, numHvTelemFields, TELEM_PKT_HV) != 0) return 1;
+	if (simulateSchedule("LV", lvTelemFields, numLvTelemFields, TELEM_PKT_LV) != 0) return 1;
+	printf("---End telemetry schedule simulation---\n");
+
+	/* Receiving side, the same LV packet as JSON and as binary */
+	printf("---Begin LV telemetry decode benchmark, %d packets---\n", NUM_PACKETS);
+	telemIo.primBrake = 1;
+	telemIo.secBrake = 1;
+	data->motion->vel = 12.5;
+	data->pressure->primTank = 801.25;
+	telemTakeSnapshot(&snap);
+	saxLen = telemJsonPacket(lvTelemFields, numLvTelemFields, ALL_FIELDS, &snap, writer, buf,
+			0, 1234567890123ULL);
+	memcpy(jsonIn, buf.GetString(), saxLen);
+	jsonIn[saxLen] = '\0';
+	binLen = telemBinPacket(lvTelemFields, numLvTelemFields, ALL_FIELDS, &snap, TELEM_PKT_LV,
+			binOut, 0, 1234567890123ULL);
+
+	if (checkDecode(jsonIn, saxLen) != 0 || checkDecode(binOut, binLen) != 0) {
+		fprintf(stderr, "LV packet did not decode to what was sent\n");
+		return 1;
+	}
+
+	allocs = numAllocs;
+	start = getuSTimestamp();
+	for (i = 0; i < NUM_PACKETS; i++) {
+		lastId = i + 1;
+		if (HVTelemParse(jsonIn, saxLen, &lastId) != 0) return 1;
+	}
+	end = getuSTimestamp();
+	report("JSON", start, end, numAllocs - allocs, saxLen);
+
+	allocs = numAllocs;
+	start = getuSTimestamp();
+	for (i = 0; i < NUM_PACKETS; i++) {
+		lastId = i + 1;
+		if (HVTelemParse(binOut, binLen, &lastId) != 0) return 1;
+	}
+	end = getuSTimestamp();
+	report("BIN", start, end, numAllocs - allocs, binLen);
+	printf("---End LV telemetry decode benchmark---\n");
+	return 0;
+}
@@ -0,0 +1,33 @@
+#ifndef CMD_SERVER_H
+#define CMD_SERVER_H
+
+#ifndef MAX_COMMAND_SIZE
+#define MAX_COMMAND_SIZE 1024
+#endif
+
+/***
+ * Command server
+ *
+ * One thread serves every command connection to a board with epoll. Clients
+ * can stay connected as long as they like and send one command per line,
+ * ending in "\n" or "\r\n". Every line in a read is run, in order, and a line
+ * split across reads is put back together first.
+ *
+ * Old clients connect, write one command with no newline and close. Until a
+ * connection has sent a newline each read is taken as one whole command like
+ * it used to be, so those keep working, and can still read a reply before
+ * they close. Whatever is left when a client closes is run as a command too.
+ *
+ * Replies go back on the connection the command came in on.
+ */
+
+#define CMD_MAX_CONNS   16      /* Connections open at once, more are turned away */
+
+/* Runs one command, with its newline taken off */
+typedef void (*cmdHandler_t)(const char *cmd, int replyFd);
+
+/* Listens on every port and runs handler for each command. Only returns,
+ * with -1, if it couldn't start */
+int runCmdServer(const int *ports, int numPorts, cmdHandler_t handler);
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef CMD_TABLE_H
+#define CMD_TABLE_H
+
+#include <stdint.h>
+
+/***
+ * Command tables
+ *
+ * Each board lists its commands in a cmdDef_t array and builds a cmdTable_t
+ * from it once. cmdDispatch() then finds a command with one hash and one
+ * compare, however many there are. The hash is FNV-1a from a seed
+ * cmdTableInit() picks so that no two of the board's commands land in the
+ * same slot.
+ *
+ * A command is its name, or its name, a space and an argument. argType says
+ * what the argument has to be, and it is checked before the handler runs.
+ * Anything else is answered on replyFd with "unknown: <cmd>" or
+ * "bad argument: <cmd>" and not run.
+ */
+
+#define CMD_TABLE_BITS  8
+#define CMD_TABLE_SIZE  (1 << CMD_TABLE_BITS)
+
+/* What follows the name */
+enum {
+	CMD_ARG_NONE,
+	CMD_ARG_INT,        /* A whole decimal number, in num */
+	CMD_ARG_STRING      /* Anything but empty, in str */
+};
+
+typedef struct cmdArgs_t {
+	long num;
+	const char *str;
+	int replyFd;        /* Where the command came from */
+} cmdArgs_t;
+
+typedef void (*cmdFunc_t)(const cmdArgs_t *args);
+
+typedef struct cmdDef_t {
+	const char *name;
+	int argType;
+	cmdFunc_t func;
+} cmdDef_t;
+
+typedef struct cmdTable_t {
+	uint32_t seed;
+	const cmdDef_t *slots[CMD_TABLE_SIZE];
+} cmdTable_t;
+
+/* -1 if two commands have the same name, or no seed separates them */
+int cmdTableInit(cmdTable_t *table, const cmdDef_t *defs, int numDefs);
+
+/* Runs cmd's handler, -1 if it was rejected */
+int cmdDispatch(const cmdTable_t *table, const char *cmd, int replyFd);
+
+#endif
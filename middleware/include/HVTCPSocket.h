@@ -7,6 +7,10 @@
 
 void SetupHVTCPServer();
 void *TCPLoop(void *arg);
+void handleHVCommand(const char *cmd, int replyFd);
 void signalLV(char *cmd);
 
+/* Where signalLV() connects, LV_SERVER_IP:LV_CMD_PORT unless changed */
+void setLVCommandTarget(const char *ip, int port);
+
 #endif
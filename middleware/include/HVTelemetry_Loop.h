@@ -1,12 +1,17 @@
 #ifndef HVTELEMETRY_SENDER_H
 #define HVTELEMETRY_SENDER_H
 
+#include <stdint.h>
+#include "TelemBinary.h"
+
 void *HVTelemetryLoop(void *arg);
-void SetupHVTelemetry(char* ip, int port);
+/* format is TELEM_JSON or TELEM_BINARY, picked per destination */
+void SetupHVTelemetry(char* ip, int port, int format = TELEM_JSON);
 
 typedef struct HVTelemArgs{
 	char *ipaddr;
 	int port;
+	int format;
 } HVTelemArgs;
 
 #endif
\ No newline at end of file
@@ -1,11 +1,14 @@
 #ifndef HV_TELEM_RECV_H
 #define HV_TELEM_RECV_H
 
+#include <stdint.h>
+
 #ifndef MAX_TLM_HV_RECV
 #define MAX_TLM_HV_RECV 4096
 #endif
 
 void SetupHVTelemRecv();
 void *HVTelemRecv(void *arg);
+int HVTelemParse(char *buf, int len, uint64_t *lastId);
 
 #endif
@@ -8,5 +8,11 @@
 void SetupLVTCPServer();
 void *LVTCPLoop(void *arg);
 
+/* Serves the persistent command connection from HV on LV_CMD_PORT, one
+ * command per line */
+void *LVCmdLoop(void *arg);
+
+void handleLVCommand(const char *cmd, int replyFd);
+
 
 #endif
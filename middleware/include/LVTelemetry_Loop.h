@@ -1,12 +1,19 @@
 #ifndef LVTELEMETRY_SENDER_H
 #define LVTELEMETRY_SENDER_H
 
+#include <stdint.h>
+#include "TelemBinary.h"
+
 void *LVTelemetryLoop(void *arg);
-void SetupLVTelemetry(char* ip, int port);
+/* Every packet goes to the dashboard at ip:port and to HV_Telem_Recv on the
+ * HV board, each in its own format (TELEM_JSON or TELEM_BINARY) */
+void SetupLVTelemetry(char* ip, int port, int format = TELEM_JSON, int hvFormat = TELEM_JSON);
 
 typedef struct LVTelemArgs{
 	char *ipaddr;
 	int port;
+	int format;
+	int hvFormat;
 } LVTelemArgs;
 
 #endif
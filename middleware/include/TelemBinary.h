@@ -0,0 +1,77 @@
+#ifndef TELEM_BINARY_H
+#define TELEM_BINARY_H
+
+#include <stdint.h>
+#include <string.h>
+
+/***
+ * Binary telemetry wire format
+ *
+ * A compact alternative to the JSON packets, for destinations that can read
+ * it. Every packet is a telemBinHeader_t followed by the payload:
+ *
+ *      uint64_t mask   - bit i set if field i of the packet type's field
+ *                        table (see TelemSchema.h) is in this packet
+ *      values          - each field that is present, in table order, packed
+ *                        at the size of its type
+ *
+ * Everything is little endian (native on the BeagleBone and on x86), floats
+ * are IEEE 754. The first byte of a binary packet is never '{', so a
+ * receiver can accept both formats on the same port. Bump TELEM_BIN_VERSION
+ * whenever a field table changes, receivers drop versions they don't know.
+ */
+
+#define TELEM_JSON          0
+#define TELEM_BINARY        1
+
+#define TELEM_BIN_MAGIC     0x4C42      /* "BL" on the wire */
+#define TELEM_BIN_VERSION   3
+
+#define TELEM_PKT_HV        1
+#define TELEM_PKT_LV        2
+
+typedef struct __attribute__((packed)) telemBinHeader_t {
+	uint16_t magic;
+	uint8_t  version;
+	uint8_t  type;          /* TELEM_PKT_* */
+	uint16_t length;        /* Payload bytes following the header */
+	uint64_t id;            /* Packet counter */
+	uint64_t timeMs;        /* Wall clock time it was sent */
+} telemBinHeader_t;
+
+static inline void telemBinSetHeader(telemBinHeader_t *hdr, uint8_t type,
+		uint16_t length, uint64_t id, uint64_t timeMs) {
+	hdr->magic = TELEM_BIN_MAGIC;
+	hdr->version = TELEM_BIN_VERSION;
+	hdr->type = type;
+	hdr->length = length;
+	hdr->id = id;
+	hdr->timeMs = timeMs;
+}
+
+/***
+ * telemBinGetHeader - Checks that buf holds a complete binary packet of the
+ *  given type and current version
+ *
+ * RETURNS: 0 on success, -1 if it isn't a binary packet we can read
+ */
+static inline int telemBinGetHeader(const char *buf, int len, uint8_t type,
+		telemBinHeader_t *hdr) {
+	if (len < (int) sizeof(telemBinHeader_t)) return -1;
+	memcpy(hdr, buf, sizeof(telemBinHeader_t));
+	if (hdr->magic != TELEM_BIN_MAGIC || hdr->version != TELEM_BIN_VERSION ||
+			hdr->type != type ||
+			len < (int) (sizeof(telemBinHeader_t) + hdr->length)) {
+		return -1;
+	}
+	return 0;
+}
+
+static inline bool telemIsBinary(const char *buf, int len) {
+	uint16_t magic;
+	if (len < (int) sizeof(magic)) return false;
+	memcpy(&magic, buf, sizeof(magic));
+	return magic == TELEM_BIN_MAGIC;
+}
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef TELEM_BUFFER_H
+#define TELEM_BUFFER_H
+
+#include <stddef.h>
+#include "writer.h"
+
+/* Biggest packet we will build, keeps a packet inside one ethernet frame */
+#define TELEM_MAX_PACKET 1400
+
+/***
+ * TelemBuffer - Fixed size output stream for rapidjson's Writer
+ *
+ * Meant to be created once per telemetry thread along with a TelemWriter and
+ * reused for every packet, so building a packet never touches the heap.
+ * Anything past TELEM_MAX_PACKET is dropped and the packet marked overflowed.
+ */
+class TelemBuffer {
+public:
+	typedef char Ch;
+
+	TelemBuffer() : len(0), overflow(false) {}
+
+	void Put(char c) {
+		if (len < TELEM_MAX_PACKET) buf[len++] = c;
+		else overflow = true;
+	}
+	void Flush() {}
+	void Clear() { len = 0; overflow = false; }
+
+	const char *GetString() const { return buf; }
+	size_t GetSize() const { return len; }
+	bool Overflowed() const { return overflow; }
+
+private:
+	char buf[TELEM_MAX_PACKET];
+	size_t len;
+	bool overflow;
+};
+
+typedef rapidjson::Writer<TelemBuffer> TelemWriter;
+
+/* Writes a key from a string literal without a strlen */
+#define TELEM_KEY(writer, key) ((writer).Key((key), sizeof(key) - 1))
+
+#endif
@@ -0,0 +1,119 @@
+#ifndef TELEM_SCHEMA_H
+#define TELEM_SCHEMA_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "TelemBuffer.h"
+#include "TelemBinary.h"
+#include "document.h"
+
+extern "C" {
+#include "data.h"
+}
+
+/***
+ * Telemetry field tables
+ *
+ * Every value the HV and LV boards send is one entry in hvTelemFields or
+ * lvTelemFields (TelemSchema.cpp). The same table builds the JSON and binary
+ * packets and is used by the receiver to decode them.
+ *
+ * Each field is sent at its own rate. Every TELEM_TICK_US the telemetry loop
+ * asks which fields are due and sends a packet with only those, or nothing
+ * at all if none are. A field is due once periodUs has passed since it was
+ * last sent. If it has a deadband, it is then only sent when it has moved
+ * more than that since last time (0.5 for integer fields means any change),
+ * or TELEM_REFRESH_US has passed so receivers that just started get it.
+ *
+ * Fields of the same JSON group have to be next to each other in a table,
+ * and a table can hold at most 64 fields.
+ */
+
+#define TELEM_TICK_US       10000       /* 100 Hz, fastest any field can go */
+#define TELEM_REFRESH_US    1000000     /* Longest a deadbanded field goes unsent */
+#define TELEM_IO_PERIOD_US  50000       /* How often the loops poll the IO expanders */
+#define TELEM_MAX_FIELDS    64
+
+/* C type of the field, also how it is packed in binary packets */
+enum {
+	TELEM_NULL,         /* Not implemented yet, always null */
+	TELEM_FLOAT,
+	TELEM_DOUBLE,
+	TELEM_INT,
+	TELEM_INT16,
+	TELEM_UINT8,
+	TELEM_UINT16,
+	TELEM_UINT64,
+	TELEM_BOOL
+};
+
+/* Which struct the field lives in */
+enum {
+	TELEM_SRC_NONE,
+	TELEM_SRC_DATA,
+	TELEM_SRC_BMS,
+	TELEM_SRC_RMS,
+	TELEM_SRC_MOTION,
+	TELEM_SRC_PRESSURE,
+	TELEM_SRC_TIMERS,
+	TELEM_SRC_FLAGS,
+	TELEM_SRC_IO
+};
+
+/* Values read straight off the IO expanders by the telemetry loops */
+typedef struct telemIo_t {
+	int imdStatus;
+	int primBrake;
+	int secBrake;
+} telemIo_t;
+
+typedef struct telemField_t {
+	const char *group;      /* JSON object the key goes in, NULL for top level */
+	const char *key;
+	uint8_t type;
+	uint8_t src;
+	uint16_t offset;        /* Of the field in its src struct */
+	uint32_t periodUs;      /* 0 to send it every tick */
+	float deadband;         /* 0 to send it every period regardless */
+} telemField_t;
+
+#define TELEM_FIELD(group, key, type, src, strct, member, periodUs, deadband) \
+	{ group, key, type, src, offsetof(strct, member), periodUs, deadband }
+
+#define TELEM_NULL_FIELD(group, key, periodUs) \
+	{ group, key, TELEM_NULL, TELEM_SRC_NONE, 0, periodUs, 0 }
+
+/* Consistent copy of every struct with a seqlock, taken by the loops once a
+ * tick. Fields from the other sources are read straight from data */
+typedef struct telemSnapshot_t {
+	bms_t bms;
+	rms_t rms;
+	motion_t motion;
+	pressure_t pressure;
+} telemSnapshot_t;
+
+/* What each loop keeps per field to schedule it */
+typedef struct telemFieldState_t {
+	uint64_t lastSent;
+	double lastValue;
+	bool sent;
+} telemFieldState_t;
+
+extern const telemField_t hvTelemFields[];
+extern const int numHvTelemFields;
+extern const telemField_t lvTelemFields[];
+extern const int numLvTelemFields;
+extern telemIo_t telemIo;
+
+void telemTakeSnapshot(telemSnapshot_t *snap);
+uint64_t telemDueFields(const telemField_t *fields, telemFieldState_t *state, int n,
+		const telemSnapshot_t *snap, uint64_t now);
+size_t telemJsonPacket(const telemField_t *fields, int n, uint64_t mask,
+		const telemSnapshot_t *snap, TelemWriter &writer, TelemBuffer &buf, uint64_t id,
+		uint64_t timeMs);
+size_t telemBinPacket(const telemField_t *fields, int n, uint64_t mask,
+		const telemSnapshot_t *snap, uint8_t type, char *buf, uint64_t id, uint64_t timeMs);
+int telemJsonApply(const telemField_t *fields, int n, const rapidjson::Value &doc);
+int telemBinApply(const telemField_t *fields, int n, const char *payload, int len);
+
+#endif
@@ -18,6 +18,9 @@
 #define HV_TELEM_RECV_PORT 9093
 #define HV_TCP_PORT_RECV   9094
 
+/* HV to LV commands, over one connection HV keeps open */
+#define LV_CMD_PORT        9095
+
 void *connStatTCPLoop(void *timestamp);
 void *connStatUDPLoop(void *timestamp);
 void *connStatTCPLoopHV(void *timestamp);
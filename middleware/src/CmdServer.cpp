@@ -0,0 +1,172 @@
+#include <unistd.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#include "CmdServer.h"
+
+#define MAX_PORTS       4
+#define MAX_EVENTS      16
+
+/* epoll data for a listening socket, anything less is a connection */
+#define LISTEN_TAG      0x10000
+
+typedef struct cmdConn_t {
+	int fd;                             /* -1 when the slot is free */
+	int len;                            /* Bytes of an unfinished line in buf */
+	bool framed;                        /* Has sent a newline */
+	char buf[MAX_COMMAND_SIZE + 1];
+} cmdConn_t;
+
+typedef struct cmdServer_t {
+	int epfd;
+	int listenFds[MAX_PORTS];
+	int numPorts;
+	cmdHandler_t handler;
+	cmdConn_t conns[CMD_MAX_CONNS];
+} cmdServer_t;
+
+/* Opens a listening TCP socket on port, -1 on error */
+static int listenOn(int port) {
+	int fd, opt = 1;
+	struct sockaddr_in address;
+
+	if ((fd = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
+		fprintf(stderr, "Error creating socket FD\n");
+		return -1;
+	}
+	if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR | SO_REUSEPORT, &opt, sizeof(opt))) {
+		fprintf(stderr, "Error attaching socket\n");
+		close(fd);
+		return -1;
+	}
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = INADDR_ANY;
+	address.sin_port = htons(port);
+	if (bind(fd, (struct sockaddr *) &address, sizeof(address)) < 0 || listen(fd, CMD_MAX_CONNS) < 0) {
+		fprintf(stderr, "Error binding port %d\n", port);
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+static void acceptConn(cmdServer_t *s, int listenFd) {
+	struct epoll_event ev;
+	int fd, i, opt = 1;
+
+	if ((fd = accept(listenFd, NULL, NULL)) < 0) {
+		fprintf(stderr, "Error accepting a connection\n");
+		return;
+	}
+	for (i = 0; i < CMD_MAX_CONNS && s->conns[i].fd >= 0; i++);
+	if (i == CMD_MAX_CONNS) {
+		fprintf(stderr, "Too many command connections\n");
+		close(fd);
+		return;
+	}
+	/* Replies like pong shouldn't wait on Nagle */
+	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+	ev.events = EPOLLIN | EPOLLRDHUP;
+	ev.data.u32 = i;
+	if (epoll_ctl(s->epfd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+		close(fd);
+		return;
+	}
+	s->conns[i].fd = fd;
+	s->conns[i].len = 0;
+	s->conns[i].framed = false;
+}
+
+static void runCmd(cmdServer_t *s, cmdConn_t *c, char *cmd, char *end) {
+	*end = '\0';
+	if (end > cmd && end[-1] == '\r') end[-1] = '\0';
+	if (*cmd) s->handler(cmd, c->fd);
+}
+
+static void closeConn(cmdServer_t *s, cmdConn_t *c) {
+	/* A last command without a newline, from a client that closed after it */
+	if (c->len) runCmd(s, c, c->buf, c->buf + c->len);
+	epoll_ctl(s->epfd, EPOLL_CTL_DEL, c->fd, NULL);
+	close(c->fd);
+	c->fd = -1;
+	c->len = 0;
+}
+
+/* Runs every whole line in the buffer, then keeps what's left of a partial
+ * one for the next read */
+static void readConn(cmdServer_t *s, cmdConn_t *c) {
+	char *line, *end;
+	int n;
+
+	n = read(c->fd, c->buf + c->len, MAX_COMMAND_SIZE - c->len);
+	if (n <= 0) {
+		closeConn(s, c);
+		return;
+	}
+	c->len += n;
+
+	line = c->buf;
+	while ((end = (char *) memchr(line, '\n', c->len - (line - c->buf))) != NULL) {
+		c->framed = true;
+		runCmd(s, c, line, end);
+		line = end + 1;
+	}
+	c->len -= line - c->buf;
+	memmove(c->buf, line, c->len);
+
+	if (c->len && !c->framed) {
+		/* An old client, the read was the command */
+		runCmd(s, c, c->buf, c->buf + c->len);
+		c->len = 0;
+	} else if (c->len == MAX_COMMAND_SIZE) {
+		fprintf(stderr, "Command too long, dropped\n");
+		c->len = 0;
+	}
+}
+
+int runCmdServer(const int *ports, int numPorts, cmdHandler_t handler) {
+	struct epoll_event ev, events[MAX_EVENTS];
+	cmdServer_t *s;
+	int i, n;
+
+	if (numPorts < 1 || numPorts > MAX_PORTS) return -1;
+	s = (cmdServer_t *) malloc(sizeof(cmdServer_t));
+	if (s == NULL || (s->epfd = epoll_create1(0)) < 0) {
+		fprintf(stderr, "Error creating command server\n");
+		free(s);
+		return -1;
+	}
+	s->handler = handler;
+	s->numPorts = numPorts;
+	for (i = 0; i < CMD_MAX_CONNS; i++) s->conns[i].fd = -1;
+	for (i = 0; i < numPorts; i++) {
+		if ((s->listenFds[i] = listenOn(ports[i])) < 0) {
+			while (i--) close(s->listenFds[i]);
+			close(s->epfd);
+			free(s);
+			return -1;
+		}
+		ev.events = EPOLLIN;
+		ev.data.u32 = LISTEN_TAG | i;
+		epoll_ctl(s->epfd, EPOLL_CTL_ADD, s->listenFds[i], &ev);
+	}
+
+	while (1) {
+		n = epoll_wait(s->epfd, events, MAX_EVENTS, -1);
+		for (i = 0; i < n; i++) {
+			if (events[i].data.u32 & LISTEN_TAG) {
+				acceptConn(s, s->listenFds[events[i].data.u32 & ~LISTEN_TAG]);
+			} else if (s->conns[events[i].data.u32].fd >= 0) {
+				readConn(s, &s->conns[events[i].data.u32]);
+			}
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,98 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+
+#include "CmdTable.h"
+
+#define MAX_SEEDS       10000
+#define MAX_REPLY       64
+
+static uint32_t hashName(uint32_t seed, const char *name, size_t len) {
+	uint32_t h = 2166136261u ^ seed;
+	size_t i;
+	for (i = 0; i < len; i++) {
+		h ^= (uint8_t) name[i];
+		h *= 16777619u;
+	}
+	/* The top bits are the best mixed */
+	return h >> (32 - CMD_TABLE_BITS);
+}
+
+int cmdTableInit(cmdTable_t *table, const cmdDef_t *defs, int numDefs) {
+	uint32_t seed, slot;
+	int i, j;
+
+	for (i = 0; i < numDefs; i++) {
+		for (j = 0; j < i; j++) {
+			if (!strcmp(defs[i].name, defs[j].name)) {
+				fprintf(stderr, "Command %s is in the table twice\n", defs[i].name);
+				return -1;
+			}
+		}
+	}
+	for (seed = 0; seed < MAX_SEEDS; seed++) {
+		memset(table->slots, 0, sizeof(table->slots));
+		for (i = 0; i < numDefs; i++) {
+			slot = hashName(seed, defs[i].name, strlen(defs[i].name));
+			if (table->slots[slot]) break;
+			table->slots[slot] = &defs[i];
+		}
+		if (i == numDefs) {
+			table->seed = seed;
+			return 0;
+		}
+	}
+	memset(table->slots, 0, sizeof(table->slots));
+	fprintf(stderr, "No hash fits %d commands, raise CMD_TABLE_BITS\n", numDefs);
+	return -1;
+}
+
+static const cmdDef_t *lookup(const cmdTable_t *table, const char *name, size_t len) {
+	const cmdDef_t *def = table->slots[hashName(table->seed, name, len)];
+	if (def == NULL || strncmp(def->name, name, len) || def->name[len]) return NULL;
+	return def;
+}
+
+static int reject(const char *why, const char *cmd, int replyFd) {
+	char reply[MAX_REPLY];
+	int len = snprintf(reply, sizeof(reply), "%s: %s", why, cmd);
+	if (len >= (int) sizeof(reply)) len = sizeof(reply) - 1;
+	fprintf(stderr, "Rejected command, %s\n", reply);
+	send(replyFd, reply, len, MSG_NOSIGNAL);
+	return -1;
+}
+
+int cmdDispatch(const cmdTable_t *table, const char *cmd, int replyFd) {
+	const cmdDef_t *def;
+	const char *space;
+	char *end;
+	cmdArgs_t args = { 0, NULL, replyFd };
+
+	/* Names can have spaces, like "power off" */
+	def = lookup(table, cmd, strlen(cmd));
+	if (def) {
+		if (def->argType != CMD_ARG_NONE) return reject("bad argument", cmd, replyFd);
+		def->func(&args);
+		return 0;
+	}
+
+	space = strrchr(cmd, ' ');
+	if (space == NULL || (def = lookup(table, cmd, space - cmd)) == NULL) {
+		return reject("unknown", cmd, replyFd);
+	}
+	args.str = space + 1;
+	switch (def->argType) {
+		case CMD_ARG_INT:
+			args.num = strtol(args.str, &end, 10);
+			if (*args.str == '\0' || *end != '\0') return reject("bad argument", cmd, replyFd);
+			break;
+		case CMD_ARG_STRING:
+			if (*args.str == '\0') return reject("bad argument", cmd, replyFd);
+			break;
+		default:
+			return reject("bad argument", cmd, replyFd);
+	}
+	def->func(&args);
+	return 0;
+}
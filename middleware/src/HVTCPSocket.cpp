@@ -8,8 +8,14 @@
 #include <unistd.h>
 #include <netdb.h>
 #include "HVTCPSocket.h"
+#include "CmdServer.h"
+#include "CmdTable.h"
 #include <netinet/in.h>
 #include <arpa/inet.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <errno.h>
 #define SA struct sockaddr
 
 extern "C"
@@ -61,177 +67,241 @@ void SetupHVTCPServer(){
 	}
 }
 
-/* Thread Loop */
-void *TCPLoop(void *arg)
+static void readyPump(const cmdArgs_t *args)
 {
+	(void) args;
+	data->flags->readyPump = 1;
+}
 
-	(void)arg;
-    motorIsEnabled = false;
-    noTorqueMode = false;
-	int server_fd, new_socket;
-	int opt = 1;
+static void readyCommand(const cmdArgs_t *args)
+{
+	(void) args;
+	data->flags->readyCommand = 1;
+}
 
-	struct sockaddr_in address;
-	int addrlen = sizeof(address);
+static void propulse(const cmdArgs_t *args)
+{
+	(void) args;
+	data->flags->propulse = 1;
+}
 
-	// Create Server fd
-	if ((server_fd = socket(AF_INET, SOCK_STREAM, 0)) == 0)
-	{
-		fprintf(stderr, "Error creating socket FD\n");
-		exit(EXIT_FAILURE);
-	}
+static void emergencyBrake(const cmdArgs_t *args)
+{
+	(void) args;
+	data->flags->emergencyBrake = 1;
+}
 
-	// Attach Socket
-	if (setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR | SO_REUSEPORT,
-								 &opt, sizeof(opt)))
-	{
-		fprintf(stderr, "Error attaching socket\n");
-		exit(EXIT_FAILURE);
-	}
+static void mcuLatchOn(const cmdArgs_t *args)
+{
+	(void) args;
+	setMCULatch(true);
+}
 
-	address.sin_family = AF_INET;
-	address.sin_addr.s_addr = INADDR_ANY;
-	address.sin_port = htons(HV_TCP_PORT_RECV);
+static void mcuLatchOff(const cmdArgs_t *args)
+{
+	(void) args;
+	setMCULatch(false);
+}
 
-	// Bind Socket
-	if (bind(server_fd, (struct sockaddr *)&address,
-					 sizeof(address)) < 0)
-	{
-		fprintf(stderr, "Error binding port\n");
-		exit(EXIT_FAILURE);
-	}
+static void enPrecharge(const cmdArgs_t *args)
+{
+	(void) args;
+/*	pthread_create(&hbT, NULL, hbLoop, NULL);*/
+	rmsEnHeartbeat();
+	rmsClrFaults();
+	rmsInvDis();
+/*	noTorqueMode = true;*/
+}
+
+static void cmdTorque(const cmdArgs_t *args)
+{
+	(void) args;
+	setMotorEn();
+}
 
-	// Listen on the server
-	if (listen(server_fd, 3) < 0)
-	{
-		fprintf(stderr, "Error listening\n");
-		exit(EXIT_FAILURE);
+static void hvEnable(const cmdArgs_t *args)
+{
+	(void) args;
+	/* Lets add a safety check here */
+	setMCUHVEnabled(true);
+}
+
+static void hvDisable(const cmdArgs_t *args)
+{
+	(void) args;
+	setMCUHVEnabled(false);
+}
+
+/* "override <state>", the state machine takes it on its next run. Only names
+ * of real states get through, which also keeps them inside
+ * overrideStateName */
+static void overrideState(const cmdArgs_t *args)
+{
+	if (findState((char *) args->str) == NULL) {
+		char reply[MAX_COMMAND_SIZE];
+		int len = snprintf(reply, sizeof(reply), "unknown state: %s", args->str);
+		fprintf(stderr, "Override for unknown state: %s\n", args->str);
+		send(args->replyFd, reply, len < (int) sizeof(reply) ? len : sizeof(reply) - 1, MSG_NOSIGNAL);
+		return;
 	}
+	fprintf(stderr, "Override received for state: %s\n", args->str);
+	strcpy(stateMachine.overrideStateName, args->str);
+}
 
-	// Loop
-	while (1)
-	{
+// HEARTBEAT
+static void ping(const cmdArgs_t *args)
+{
+	// Send acknowledge packet back
+	send(args->replyFd, (char *)"pong1", strlen("pong1"), MSG_NOSIGNAL);
+}
 
-		// Character Buffer
-		char buffer[1024] = {0};
+static const cmdDef_t hvCmds[] = {
+	{ "readyPump",      CMD_ARG_NONE,   readyPump },
+	{ "pumpDown",       CMD_ARG_NONE,   readyPump },
+	{ "readyCommand",   CMD_ARG_NONE,   readyCommand },
+	{ "propulse",       CMD_ARG_NONE,   propulse },
+	{ "emergencyBrake", CMD_ARG_NONE,   emergencyBrake },
+	{ "mcuLatchOn",     CMD_ARG_NONE,   mcuLatchOn },
+	{ "mcuLatchOff",    CMD_ARG_NONE,   mcuLatchOff },
+	{ "enPrecharge",    CMD_ARG_NONE,   enPrecharge },
+	{ "cmdTorque",      CMD_ARG_NONE,   cmdTorque },
+	{ "hvEnable",       CMD_ARG_NONE,   hvEnable },
+	{ "hvDisable",      CMD_ARG_NONE,   hvDisable },
+	{ "override",       CMD_ARG_STRING, overrideState },
+	{ "ping",           CMD_ARG_NONE,   ping },
+};
+
+static cmdTable_t hvTable;
+static pthread_once_t hvTableOnce = PTHREAD_ONCE_INIT;
+
+static void initHVTable()
+{
+	if (cmdTableInit(&hvTable, hvCmds, sizeof(hvCmds) / sizeof(hvCmds[0])) != 0) {
+		fprintf(stderr, "Error building HV command table\n");
+	}
+}
 
-		// Read incoming message
-		if ((new_socket = accept(server_fd, (struct sockaddr *)&address,
-														 (socklen_t *)&addrlen)) < 0)
-		{
-			fprintf(stderr, "Error accepting a packet\n");
-			exit(EXIT_FAILURE);
-		}
-    
-    *lastPacket = getuSTimestamp();
-
-    read(new_socket, buffer, 1024); 
-		
-		printf("RECEIVED: %s\n",buffer);  
-		
-		// Do things
-		if (!strncmp(buffer, "readyPump", MAX_COMMAND_SIZE))
-		{
-			data->flags->readyPump = 1;
-		}
+/* Runs one command from the dashboard. Anything sent back goes to replyFd */
+void handleHVCommand(const char *cmd, int replyFd)
+{
+	*lastPacket = getuSTimestamp();
+	printf("RECEIVED: %s\n", cmd);
 
-		if (!strncmp(buffer, "pumpDown", MAX_COMMAND_SIZE))
-		{
-			data->flags->readyPump = 1;
-		}
+	pthread_once(&hvTableOnce, initHVTable);
+	cmdDispatch(&hvTable, cmd, replyFd);
+}
 
-		if (!strncmp(buffer, "readyCommand", MAX_COMMAND_SIZE))
-		{
-			data->flags->readyCommand = 1;
-		}
+/* Thread Loop */
+void *TCPLoop(void *arg)
+{
 
-		if (!strncmp(buffer, "propulse", MAX_COMMAND_SIZE))
-		{
-			data->flags->propulse = 1;
-		}
+	(void)arg;
+    motorIsEnabled = false;
+    noTorqueMode = false;
+	int ports[] = { HV_TCP_PORT_RECV };
 
-		if (!strncmp(buffer, "emergencyBrake", MAX_COMMAND_SIZE))
-		{
-            data->flags->emergencyBrake = 1;
-		}
-        if (!strncmp(buffer, "mcuLatchOn", MAX_COMMAND_SIZE)) {
-            setMCULatch(true);
-        }
-        if (!strncmp(buffer, "mcuLatchOff", MAX_COMMAND_SIZE)) {
-            setMCULatch(false);
-        }
-        if (!strncmp(buffer, "enPrecharge", MAX_COMMAND_SIZE)) {
-/*            pthread_create(&hbT, NULL, hbLoop, NULL);*/
-            rmsEnHeartbeat();
-            rmsClrFaults();
-            rmsInvDis();
-/*            noTorqueMode = true;*/
-        }
-        
-        if(!strncmp(buffer, "cmdTorque", MAX_COMMAND_SIZE)) {
-            setMotorEn();
-        }
-
-		if (!strncmp(buffer, "hvEnable", MAX_COMMAND_SIZE))
-		{
-            /* Lets add a safety check here */
-			setMCUHVEnabled(true);
-		}
-        
-		if (!strncmp(buffer, "hvDisable", MAX_COMMAND_SIZE))
-		{
-			setMCUHVEnabled(false);
-		}
+	runCmdServer(ports, 1, handleHVCommand);
+	fprintf(stderr, "Error starting HV command server\n");
+	exit(EXIT_FAILURE);
+}
 
-		if(!strncmp(buffer,"override", 8)){
-			fprintf(stderr, "Override received for state: %s\n", buffer+9);
-		  sprintf(stateMachine.overrideStateName, "%s%c", buffer+9, '\0');
-        }
-		
-		// HEARTBEAT
-		if (!strncmp(buffer, "ping", MAX_COMMAND_SIZE))
-		{
-			// Send acknowledge packet back
-			send(new_socket, (char *)"pong1", strlen("pong1"), 0);
-		}
+/* LV commands go over one connection that stays open, so a brake is one
+ * segment instead of a handshake, the command and a teardown. TCP_NODELAY
+ * keeps Nagle from holding a command back behind the last one's ack */
+#define LV_CONNECT_TIMEOUT_MS   100
+#define LV_RECONNECT_US         500000
 
-		close(new_socket);
-	}
+static pthread_mutex_t lvLock = PTHREAD_MUTEX_INITIALIZER;
+static int lvFd = -1;
+static uint64_t lvLastTry = 0;
+static char lvIp[INET_ADDRSTRLEN] = LV_SERVER_IP;
+static int lvPort = LV_CMD_PORT;
+
+void setLVCommandTarget(const char *ip, int port)
+{
+	pthread_mutex_lock(&lvLock);
+	snprintf(lvIp, sizeof(lvIp), "%s", ip);
+	lvPort = port;
+	if (lvFd >= 0) close(lvFd);
+	lvFd = -1;
+	lvLastTry = 0;
+	pthread_mutex_unlock(&lvLock);
 }
 
-void signalLV(char *cmd)
+/* Call with lvLock held. Doesn't wait on LV for longer than
+ * LV_CONNECT_TIMEOUT_MS, or try again sooner than LV_RECONNECT_US, so a
+ * missing LV board can't stall the caller */
+static int connectLV()
 {
-	int srvFd;
+	struct sockaddr_in addr;
+	struct pollfd pfd;
+	socklen_t len = sizeof(int);
+	int fd, flags, err = 0, opt = 1;
+	uint64_t now = getuSTimestamp();
 
-	int opt = 1;
+	if (lvLastTry && now - lvLastTry < LV_RECONNECT_US) return -1;
+	lvLastTry = now;
 
-	struct sockaddr_in addr;
-	int addrlen = sizeof(addr);
-    
-	if ((srvFd = socket(AF_INET, SOCK_STREAM, 0)) == 0)
-	{
+	if ((fd = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
 		fprintf(stderr, "Error signalling\n");
-		exit(1);
+		return -1;
 	}
-
-	if (setsockopt(srvFd, SOL_SOCKET, SO_REUSEADDR | SO_REUSEPORT,
-								 &opt, sizeof(opt)))
-	{
-		fprintf(stderr, "Signal error\n");
-		exit(1);
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = inet_addr(lvIp);
+	addr.sin_port = htons(lvPort);
+
+	flags = fcntl(fd, F_GETFL, 0);
+	fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+	if (connect(fd, (SA *) &addr, sizeof(addr)) != 0) {
+		pfd.fd = fd;
+		pfd.events = POLLOUT;
+		if (errno != EINPROGRESS || poll(&pfd, 1, LV_CONNECT_TIMEOUT_MS) != 1 ||
+				getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) != 0 || err != 0) {
+			fprintf(stderr, "Failed to open port\n");
+			close(fd);
+			return -1;
+		}
 	}
-    
-    addr.sin_family = AF_INET;
-    addr.sin_addr.s_addr = inet_addr(LV_SERVER_IP);
-    addr.sin_port = htons(LV_SERVER_PORT);
-    
-    if (connect(srvFd, (SA*)&addr,addrlen) != 0) {
-        fprintf(stderr, "Failed to open port\n");
-        close(srvFd);
-        return;
-    }
+	fcntl(fd, F_SETFL, flags);
+	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+	lvFd = fd;
+	return 0;
+}
 
-	write(srvFd, cmd, strlen(cmd));
+/* Call with lvLock held. LV only writes on this connection to reject a
+ * command, which is dropped here. Anything else readable means it closed or
+ * reset */
+static bool lvAlive()
+{
+	char reply[MAX_COMMAND_SIZE];
+	int n;
+	while ((n = recv(lvFd, reply, sizeof(reply), MSG_DONTWAIT)) > 0);
+	return n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+}
 
-	close(srvFd);
+void signalLV(char *cmd)
+{
+	char line[MAX_COMMAND_SIZE + 1];
+	int len, tries;
+
+	len = snprintf(line, sizeof(line) - 1, "%s", cmd);
+	if (len > MAX_COMMAND_SIZE - 1) len = MAX_COMMAND_SIZE - 1;
+	if (len == 0 || line[len - 1] != '\n') line[len++] = '\n';
+
+	pthread_mutex_lock(&lvLock);
+	if (lvFd >= 0 && !lvAlive()) {
+		close(lvFd);
+		lvFd = -1;
+		lvLastTry = 0;
+	}
+	/* A connection can still die unnoticed, so try a fresh one once */
+	for (tries = 0; tries < 2; tries++) {
+		if (lvFd < 0 && connectLV() != 0) break;
+		if (send(lvFd, line, len, MSG_NOSIGNAL) == len) break;
+		close(lvFd);
+		lvFd = -1;
+		lvLastTry = 0;
+	}
+	pthread_mutex_unlock(&lvLock);
 }
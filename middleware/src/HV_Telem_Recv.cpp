@@ -1,6 +1,7 @@
 #include "HV_Telem_Recv.h"
 #include "PracticalSocket.h"  
 #include "document.h"
+#include "TelemSchema.h"
 #include <iostream>
 #include <cstdlib>
 #include <stdint.h>
@@ -30,6 +31,61 @@ void SetupHVTelemRecv(){
 
 
 
+/* Motion and pressure are written as a whole, so readers never see half a
+ * packet */
+static void applyBegin(){
+	seqWriteBegin(&data->motion->lock);
+	seqWriteBegin(&data->pressure->lock);
+}
+
+static void applyEnd(){
+	seqWriteEnd(&data->pressure->lock);
+	seqWriteEnd(&data->motion->lock);
+}
+
+/* JSON LV packet, parsed into a DOM. Fields it doesn't carry keep their
+ * last value. */
+static int parseJson(char *buf, uint64_t *lastId){
+	Document document;
+	document.Parse(buf);
+	
+	// Get a counter
+	if(!document.IsObject() || !document.HasMember("id") || !document["id"].IsUint64()) return -1;
+	// Make sure it's a new packet
+	if(document["id"].GetUint64() == *lastId) return 1;
+	*lastId = document["id"].GetUint64();
+	
+	applyBegin();
+	int ret = telemJsonApply(lvTelemFields, numLvTelemFields, document);
+	applyEnd();
+	return ret;
+}
+
+/* Binary LV packet, see TelemBinary.h */
+static int parseBinary(const char *buf, int len, uint64_t *lastId){
+	telemBinHeader_t hdr;
+	if (telemBinGetHeader(buf, len, TELEM_PKT_LV, &hdr) != 0) return -1;
+	if (hdr.id == *lastId) return 1;
+	*lastId = hdr.id;
+
+	applyBegin();
+	int ret = telemBinApply(lvTelemFields, numLvTelemFields, buf + sizeof(hdr), hdr.length);
+	applyEnd();
+	return ret;
+}
+
+/***
+ * HVTelemParse - Applies one LV telemetry packet, JSON or binary, to data.
+ *  buf must be null terminated. lastId is the ID of the last packet applied
+ *  and gets updated.
+ *
+ * RETURNS: 0 if applied, 1 if it repeated lastId, -1 if it couldn't be read
+ */
+int HVTelemParse(char *buf, int len, uint64_t *lastId){
+	if (telemIsBinary(buf, len)) return parseBinary(buf, len, lastId);
+	return parseJson(buf, lastId);
+}
+
 void *HVTelemRecv(void *arg){
 	(void) arg;
 	
@@ -49,43 +105,11 @@ void *HVTelemRecv(void *arg){
 			//cout << "Received " << recvString << " from " << sourceAddress << ": "
 			//		 << sourcePort << endl;
 					
-					
-			// Now to try and parse it
-			Document document;
-			document.Parse(recvString);
-			
-			// Get a counter
-			if(document.HasMember("id")){
-				// Make sure it's a new packet
-				if(document["id"].GetUint64() != recentPacketID){
-					recentPacketID = document["id"].GetUint64();
-					
-					// TODO complete as new sensors/etc are added
-   					// Parse data in
-					
-					// MOTION DATA
-					const Value &motion = document["motion"];
-					data->motion->vel = motion["velocity"].GetFloat();
-					data->motion->accel = motion["acceleration"].GetFloat();
-	                data->motion->retroCount = motion["retro"].GetInt();	
-		            data->motion->pos = motion["position"].GetFloat();
-                    data->timers->lastRetro = motion["lastRetro"].GetUint64();
-                    const Value &b = document["braking"];
-                    data->pressure->pv = b["pressureVesselPressure"].GetFloat();
-                    data->pressure->primTank = b["primaryTank"].GetFloat();
-                    data->pressure->primLine = b["primaryLine"].GetFloat();
-                    data->pressure->primAct = b["primaryActuation"].GetFloat();
-
-                    data->pressure->secTank = b["secondaryTank"].GetFloat();
-                    data->pressure->secLine = b["secondaryLine"].GetFloat();
-                    data->pressure->secAct =  b["secondaryActuation"].GetFloat();
-                    data->flags->readyToBrake = b["readyToBrake"].GetInt();
-                    
-				}
-				else{
-					fprintf(stderr, "Encountered total: %i dropped packets due to ID error\n", ++packetErrCounter);
-				}
-			
+			int ret = HVTelemParse(recvString, bytesRcvd, &recentPacketID);
+			if (ret == 1) {
+				fprintf(stderr, "Encountered total: %i dropped packets due to ID error\n", ++packetErrCounter);
+			} else if (ret < 0) {
+				fprintf(stderr, "Unreadable telemetry packet from %s\n", sourceAddress.c_str());
 			}
 		} 
 		catch (SocketException &e) {
@@ -8,6 +8,8 @@
 #include <unistd.h>
 
 #include "LVTCPSocket.h"
+#include "CmdServer.h"
+#include "CmdTable.h"
 #include "data.h"
 
 #define DASH 0
@@ -19,7 +21,7 @@ extern  "C" {
 #include <braking.h>
 }
 
-pthread_t LVTCPThread, lvTcpConT, lvTcpConT2;
+pthread_t LVTCPThread, LVCmdThread, lvTcpConT, lvTcpConT2;
 uint64_t *lastPacket[2];
 
 /* Setup PThread Loop */
@@ -35,115 +37,116 @@ void SetupLVTCPServer(){
 	if (pthread_create(&LVTCPThread, NULL, LVTCPLoop, NULL)){
 		fprintf(stderr, "Error creating LV Telemetry thread\n");
 	}
+	if (pthread_create(&LVCmdThread, NULL, LVCmdLoop, NULL)){
+		fprintf(stderr, "Error creating LV command thread\n");
+	}
 	 
 }
 
-/* Thread Loop */
-void *LVTCPLoop(void *arg){
-	
-	(void) arg;
+static void powerOff(const cmdArgs_t *args) {
+	(void) args;
+	// DO POWER OFF
+}
 
-	int server_fd, new_socket;
-	int opt = 1;
-		
-	struct sockaddr_in address;
-	int addrlen = sizeof(address);
-	
-	// Create Server fd	
-	if((server_fd = socket(AF_INET, SOCK_STREAM, 0)) == 0){ 
-		fprintf(stderr, "Error creating socket FD\n");
-		exit(EXIT_FAILURE); 
-	} 
-		
-	// Attach Socket
-	if(setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR | SO_REUSEPORT, 
-												  &opt, sizeof(opt))){ 
-		fprintf(stderr, "Error attaching socket\n");
-		exit(EXIT_FAILURE); 
-	}
-		
-	address.sin_family = AF_INET; 
-	address.sin_addr.s_addr = INADDR_ANY; 
-	address.sin_port = htons(LV_SERVER_PORT); 
-
-	// Bind Socket
-	if (bind(server_fd, (struct sockaddr *)&address,
-									 sizeof(address))<0) {
-		fprintf(stderr, "Error binding port\n");
-		exit(EXIT_FAILURE); 
-	}
+/* "state <n>" from HV, which also counts as its heartbeat */
+static void stateCmd(const cmdArgs_t *args) {
+	*lastPacket[HV] = getuSTimestamp();
+	data->state = args->num;
+}
+
+static void clrMotion(const cmdArgs_t *args) {
+	(void) args;
+	resetNav();
+	data->flags->readyToBrake = true;
+}
+
+static void brakeCmd(const cmdArgs_t *args) {
+	(void) args;
+/*	data->flags->shouldBrake = true;*/
+	brake();
+}
+
+static void primBrakeOff(const cmdArgs_t *args) {
+	(void) args;
+/*	data->flags->brakePrimRetr = true;*/
+	brakePrimaryUnactuate();
+}
+
+static void primBrakeOn(const cmdArgs_t *args) {
+	(void) args;
+/*	data->flags->brakePrimAct = true;*/
+	brakePrimaryActuate();
+}
+
+static void secBrakeOff(const cmdArgs_t *args) {
+	(void) args;
+/*	data->flags->brakeSecRetr = true;*/
+	brakeSecondaryUnactuate();
+}
 
-	// Listen on the server
-	if (listen(server_fd, 3) < 0){ 
-		fprintf(stderr, "Error listening\n");
-		exit(EXIT_FAILURE); 
+static void secBrakeOn(const cmdArgs_t *args) {
+	(void) args;
+/*	data->flags->brakeSecAct = true;*/
+	brakeSecondaryActuate();
+}
+
+// HEARTBEAT
+static void ping(const cmdArgs_t *args) {
+	// Send acknowledge packet back
+	*lastPacket[DASH] = getuSTimestamp();
+	send(args->replyFd, (char*) "pong2" , strlen("pong2") , MSG_NOSIGNAL);
+}
+
+static const cmdDef_t lvCmds[] = {
+	{ "power off",      CMD_ARG_NONE,   powerOff },
+	{ "state",          CMD_ARG_INT,    stateCmd },
+	{ "clrMotion",      CMD_ARG_NONE,   clrMotion },
+	{ "brake",          CMD_ARG_NONE,   brakeCmd },
+	{ "primBrakeOff",   CMD_ARG_NONE,   primBrakeOff },
+	{ "primBrakeOn",    CMD_ARG_NONE,   primBrakeOn },
+	{ "secBrakeOff",    CMD_ARG_NONE,   secBrakeOff },
+	{ "secBrakeOn",     CMD_ARG_NONE,   secBrakeOn },
+	{ "ping",           CMD_ARG_NONE,   ping },
+};
+
+static cmdTable_t lvTable;
+static pthread_once_t lvTableOnce = PTHREAD_ONCE_INIT;
+
+static void initLVTable() {
+	if (cmdTableInit(&lvTable, lvCmds, sizeof(lvCmds) / sizeof(lvCmds[0])) != 0) {
+		fprintf(stderr, "Error building LV command table\n");
 	}
+}
+
+/* Runs one command, from the dashboard or HV. Anything sent back goes to
+ * replyFd */
+void handleLVCommand(const char *cmd, int replyFd) {
+	printf("RECEIVED: %s\n", cmd);
+
+	pthread_once(&lvTableOnce, initLVTable);
+	cmdDispatch(&lvTable, cmd, replyFd);
+}
+
+/* Thread Loop. The dashboard connects to LV_SERVER_PORT */
+void *LVTCPLoop(void *arg){
 	
-	// Loop
-	while(1){
-		
-		// Character Buffer
-		char buffer[1024] = {0}; 
-		
-		// Read incoming message
-		if ((new_socket = accept(server_fd, (struct sockaddr *)&address,  
-								   (socklen_t*)&addrlen))<0){ 
-			fprintf(stderr, "Error accepting a packet\n"); 
-			exit(EXIT_FAILURE); 
-		}
-		read(new_socket, buffer, 1024); 
-		
-		printf("RECEIVED: %s\n",buffer);  
-		
-		// Do things
-		if(!strncmp(buffer, "power off", MAX_COMMAND_SIZE)){
-			// DO POWER OFF
-		}
-        if (!strncmp(buffer, "state", 5)) {
-            *lastPacket[HV] = getuSTimestamp();
-            data->state = buffer[5] - 0x30;
-        }
-	    
-        if (!strncmp(buffer, "clrMotion", MAX_COMMAND_SIZE)) {
-            resetNav();
-            data->flags->readyToBrake = true;
-        }
-
-        if (!strncmp(buffer, "brake", MAX_COMMAND_SIZE)) {
-/*            data->flags->shouldBrake = true;*/
-            brake();
-        }
-
-		if (!strncmp(buffer, "primBrakeOff", MAX_COMMAND_SIZE))
-		{
-/*			data->flags->brakePrimRetr = true;*/
-                brakePrimaryUnactuate(); 
-		}
-		if (!strncmp(buffer, "primBrakeOn", MAX_COMMAND_SIZE))
-		{
-/*            data->flags->brakePrimAct = true;   */
-	    brakePrimaryActuate();
-		}
-		if (!strncmp(buffer, "secBrakeOff", MAX_COMMAND_SIZE))
-		{
-/*            data->flags->brakeSecRetr = true;*/
-		brakeSecondaryUnactuate();
-		}
-		if (!strncmp(buffer, "secBrakeOn", MAX_COMMAND_SIZE))
-		{
-/*            data->flags->brakeSecAct = true;*/
-		brakeSecondaryActuate();
-		}
-
-		// HEARTBEAT
-		if(!strncmp(buffer, "ping", MAX_COMMAND_SIZE)){
-			// Send acknowledge packet back
-			*lastPacket[DASH] = getuSTimestamp();
-            send(new_socket, (char*) "pong2" , strlen("pong2") , 0 ); 
-		}
-		
-		close(new_socket);
-	}
+	(void) arg;
+	int ports[] = { LV_SERVER_PORT };
+
+	runCmdServer(ports, 1, handleLVCommand);
+	fprintf(stderr, "Error starting LV command server\n");
+	exit(EXIT_FAILURE);
 }
 
+/* HV's connection gets a server of its own. Handlers run on the server's
+ * thread and brake() sleeps for half a second, so a brake from the dashboard
+ * mustn't hold up HV's brakes and heartbeat */
+void *LVCmdLoop(void *arg){
+	
+	(void) arg;
+	int ports[] = { LV_CMD_PORT };
 
+	runCmdServer(ports, 1, handleLVCommand);
+	fprintf(stderr, "Error starting LV command server\n");
+	exit(EXIT_FAILURE);
+}
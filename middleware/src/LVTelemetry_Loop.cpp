@@ -7,8 +7,7 @@
 #include <ctime>
 #include "PracticalSocket.h"
 #include "LVTelemetry_Loop.h"
-#include "document.h"
-#include "writer.h"
+#include "TelemSchema.h"
 #include "connStat.h"
 #include "data.h"
 
@@ -16,6 +15,7 @@
 extern "C" 
 {
     #include "lv_iox.h"
+    #include "periodic.h"
 }
 
 
@@ -24,7 +24,7 @@ using namespace std;
 
 pthread_t LVTelemThread;
 
-void SetupLVTelemetry(char* ip, int port){
+void SetupLVTelemetry(char* ip, int port, int format, int hvFormat){
 	
 	LVTelemArgs *args = (LVTelemArgs*) malloc(sizeof(LVTelemArgs));
 	
@@ -35,6 +35,8 @@ void SetupLVTelemetry(char* ip, int port){
 	
 	args->ipaddr = strdup(ip);
 	args->port = port;
+	args->format = format;
+	args->hvFormat = hvFormat;
 	
 	if (pthread_create(&LVTelemThread, NULL, LVTelemetryLoop, args)){
 		fprintf(stderr, "Error creating LV Telemetry thread\n");
@@ -42,122 +44,64 @@ void SetupLVTelemetry(char* ip, int port){
 }
 
 
+/* Sends a destination the packet in the format it asked for */
+static void sendPacket(UDPSocket &sock, int format, char *ip, int port, TelemBuffer &json,
+		size_t jsonLen, char *bin, size_t binLen){
+	if (format == TELEM_BINARY) {
+		sock.sendTo(bin, binLen, ip, port);
+	} else if (jsonLen > 0) {
+		sock.sendTo(json.GetString(), jsonLen, ip, port);
+	}
+}
+
 void *LVTelemetryLoop(void *arg)
 {
 	LVTelemArgs *sarg = (LVTelemArgs*) arg;
+	/* Reused for every packet */
+	TelemBuffer buf;
+	TelemWriter writer(buf);
+	char binBuf[TELEM_MAX_PACKET];
+	bool wantJson = sarg->format == TELEM_JSON || sarg->hvFormat == TELEM_JSON;
+	bool wantBin = sarg->format == TELEM_BINARY || sarg->hvFormat == TELEM_BINARY;
 	try {
 		// Create socket
 		UDPSocket sock;
 		
 		uint64_t packetCount = 0;
+		telemFieldState_t state[TELEM_MAX_FIELDS] = {};
+		telemSnapshot_t snap;
+		uint64_t lastIo = 0;
+		periodic_t task;
 		
+		periodicInit(&task, "lvTelem", TELEM_TICK_US);
 		while(1){
-		
-			// Create document
-			Document document;
-			document.SetObject();
-			
-			
-			/* SET DATA VALUES */
+			uint64_t now = getuSTimestamp();
+			if (now - lastIo >= TELEM_IO_PERIOD_US) {
+				telemIo.primBrake = limSwitchGet(PRIM_LIM_SWITCH);
+				telemIo.secBrake = limSwitchGet(SEC_LIM_SWITCH);
+				lastIo = now;
+			}
 
-			// PACKET ID
-			Value packet_id;
-			packet_id.SetUint64(packetCount++);
-			
-			// TIME
-			Value age;
-			std::chrono::milliseconds ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-				std::chrono::system_clock::now().time_since_epoch()
-			);
-			age.SetUint64(ms.count());
-			
-			// STOPPING DISTANCE
-			Value stopDistance;
-			stopDistance.SetNull();
-			
-			// POSITION
-			Value pos;
-			pos.SetFloat(data->motion->pos);
-			
-			// RETRO
-			Value retro;
-			retro.SetInt(data->motion->retroCount);
-			
-			// VELOCITY - Change "X" to "Y" if need be
-			Value vel;
-			vel.SetFloat(data->motion->vel);
-	
-			Value lstRet;
-            lstRet.SetUint64(data->timers->lastRetro);
-			// ACCELERATION - Change "X" to "Y" if need be
-			Value accel;
-			accel.SetFloat(data->motion->accel);
+			/* Only the fields that are due go out, nothing at all if none are */
+			telemTakeSnapshot(&snap);
+			uint64_t mask = telemDueFields(lvTelemFields, state, numLvTelemFields, &snap, now);
+			if (mask != 0) {
+				std::chrono::milliseconds ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+					std::chrono::system_clock::now().time_since_epoch()
+				);
+				size_t jsonLen = 0, binLen = 0;
+
+				if (wantJson) jsonLen = telemJsonPacket(lvTelemFields, numLvTelemFields, mask,
+						&snap, writer, buf, packetCount, ms.count());
+				if (wantBin) binLen = telemBinPacket(lvTelemFields, numLvTelemFields, mask,
+						&snap, TELEM_PKT_LV, binBuf, packetCount, ms.count());
+				packetCount++;
 				
-			// PRESSURE VESSEL PRESSURE
-			Value pressureV;
-			pressureV.SetDouble(data->pressure->pv);
-			
-            Value primTank, primLine, primAct;
-            primTank.SetFloat(data->pressure->primTank);
-            primLine.SetFloat(data->pressure->primLine);
-            primAct.SetFloat(data->pressure->primAct);
-            
-            Value secTank, secLine, secAct;
-            secTank.SetFloat(data->pressure->secTank);
-            secLine.SetFloat(data->pressure->secLine);
-            secAct.SetFloat(data->pressure->secAct);
- 
-			// CURRENT PRESSURE
-			Value currP;
-			currP.SetNull();
-			Value missedRetro;
-            missedRetro.SetInt(data->motion->missedRetro);
-            Value primBrake, secBrake;
-            primBrake.SetInt(limSwitchGet(PRIM_LIM_SWITCH));
-            secBrake.SetInt(limSwitchGet(SEC_LIM_SWITCH));
-            Value readyFlag;
-            readyFlag.SetInt(data->flags->readyToBrake);
-			
-			/* INSERT VALUES INTO JSON DOCUMENTS */
-			
-			document.AddMember("id", packet_id, document.GetAllocator());
-			
-			Document motionDoc;
-			motionDoc.SetObject();
-			motionDoc.AddMember("stoppingDistance", stopDistance, motionDoc.GetAllocator());
-			motionDoc.AddMember("position", pos, motionDoc.GetAllocator());
-			motionDoc.AddMember("retro", retro, motionDoc.GetAllocator());
-			motionDoc.AddMember("velocity", vel, motionDoc.GetAllocator());
-			motionDoc.AddMember("acceleration", accel, motionDoc.GetAllocator());
-			motionDoc.AddMember("lastRetro", lstRet, motionDoc.GetAllocator());
-			Document brakingDoc;
-			brakingDoc.SetObject();
-			brakingDoc.AddMember("pressureVesselPressure", pressureV, brakingDoc.GetAllocator());
-			brakingDoc.AddMember("currentPressure", currP, brakingDoc.GetAllocator());
-			brakingDoc.AddMember("primBrake", primBrake, brakingDoc.GetAllocator());
-            brakingDoc.AddMember("secBrake", secBrake, brakingDoc.GetAllocator());
-            brakingDoc.AddMember("primaryTank", primTank, brakingDoc.GetAllocator()); 
-            brakingDoc.AddMember("primaryLine", primLine, brakingDoc.GetAllocator()); 
-            brakingDoc.AddMember("primaryActuation", primAct, brakingDoc.GetAllocator()); 
-            brakingDoc.AddMember("secondaryTank", secTank, brakingDoc.GetAllocator()); 
-            brakingDoc.AddMember("secondaryLine", secLine, brakingDoc.GetAllocator()); 
-            brakingDoc.AddMember("secondaryActuation", secAct, brakingDoc.GetAllocator()); 
-            brakingDoc.AddMember("readyToBrake", readyFlag, brakingDoc.GetAllocator());
-			/* ADD DOCUMENTS TO MAIN JSON DOCUMENT */
-			
-			document.AddMember("time", age, document.GetAllocator());
-			document.AddMember("motion", motionDoc, document.GetAllocator());
-			document.AddMember("braking", brakingDoc, document.GetAllocator());
-			
-			StringBuffer sb;
-			Writer<StringBuffer> writer(sb); // PrettyWriter<StringBuffer> writer(sb); for debugging, don't forget to change header too
-			document.Accept(writer);
-			
-			// Repeatedly send the string (not including \0) to the servers
-		
-			sock.sendTo(sb.GetString(), strlen(sb.GetString()), sarg->ipaddr, sarg->port);
-			sock.sendTo(sb.GetString(), strlen(sb.GetString()), HV_SERVER_IP, HV_TELEM_RECV_PORT);
-			usleep(30000);
+				// Send to the dashboard and to the HV board
+				sendPacket(sock, sarg->format, sarg->ipaddr, sarg->port, buf, jsonLen, binBuf, binLen);
+				sendPacket(sock, sarg->hvFormat, (char *) HV_SERVER_IP, HV_TELEM_RECV_PORT, buf, jsonLen, binBuf, binLen);
+			}
+			periodicWait(&task);
 		}
 	} 
 	catch (SocketException &e) {
@@ -0,0 +1,316 @@
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include "TelemSchema.h"
+
+using namespace rapidjson;
+
+extern data_t *data;
+
+telemIo_t telemIo;
+
+/***
+ * HV packet - BMS and RMS data
+ *
+ * Motor speed, currents and torques are what the dashboard graphs during a
+ * run, so they go every tick. Temperatures and pack state barely move.
+ */
+const telemField_t hvTelemFields[] = {
+	TELEM_FIELD("motor",   "phaseAIGBTTemp",      TELEM_UINT16, TELEM_SRC_RMS,  rms_t, igbtTemp,            500000, 0.5),
+	TELEM_FIELD("motor",   "gateDriverBoardTemp", TELEM_UINT16, TELEM_SRC_RMS,  rms_t, gateDriverBoardTemp, 500000, 0.5),
+	TELEM_FIELD("motor",   "controlBoardTemp",    TELEM_UINT16, TELEM_SRC_RMS,  rms_t, controlBoardTemp,    500000, 0.5),
+	TELEM_FIELD("motor",   "motorTemp",           TELEM_UINT16, TELEM_SRC_RMS,  rms_t, motorTemp,           500000, 0.5),
+	TELEM_FIELD("motor",   "motorSpeed",          TELEM_INT16,  TELEM_SRC_RMS,  rms_t, motorSpeed,          0,      0),
+	TELEM_FIELD("motor",   "phaseACurrent",       TELEM_INT16,  TELEM_SRC_RMS,  rms_t, phaseACurrent,       0,      0),
+	TELEM_FIELD("motor",   "busCurrent",          TELEM_INT16,  TELEM_SRC_RMS,  rms_t, dcBusCurrent,        0,      0),
+	TELEM_FIELD("motor",   "busVoltage",          TELEM_INT16,  TELEM_SRC_RMS,  rms_t, dcBusVoltage,        50000,  0),
+	TELEM_FIELD("motor",   "commandTorque",       TELEM_INT16,  TELEM_SRC_RMS,  rms_t, commandedTorque,     0,      0),
+	TELEM_FIELD("motor",   "torqueFeedback",      TELEM_INT16,  TELEM_SRC_RMS,  rms_t, actualTorque,        0,      0),
+	TELEM_FIELD("battery", "packVoltage",         TELEM_FLOAT,  TELEM_SRC_BMS,  bms_t, packVoltage,         50000,  0),
+	TELEM_FIELD("battery", "packCurrent",         TELEM_FLOAT,  TELEM_SRC_BMS,  bms_t, packCurrent,         50000,  0),
+	TELEM_FIELD("battery", "packSOC",             TELEM_UINT8,  TELEM_SRC_BMS,  bms_t, Soc,                 1000000, 0.5),
+	TELEM_FIELD("battery", "packAH",              TELEM_UINT16, TELEM_SRC_BMS,  bms_t, packAh,              1000000, 0.5),
+	TELEM_FIELD("battery", "cellMaxVoltage",      TELEM_FLOAT,  TELEM_SRC_BMS,  bms_t, cellMaxVoltage,      100000, 0.001),
+	TELEM_FIELD("battery", "cellMinVoltage",      TELEM_FLOAT,  TELEM_SRC_BMS,  bms_t, cellMinVoltage,      100000, 0.001),
+	TELEM_FIELD("battery", "imdStatus",           TELEM_INT,    TELEM_SRC_IO,   telemIo_t, imdStatus,       TELEM_IO_PERIOD_US, 0),
+	TELEM_FIELD("battery", "maxCellTemp",         TELEM_UINT8,  TELEM_SRC_BMS,  bms_t, highTemp,            500000, 0.5),
+	TELEM_FIELD("battery", "minCellTemp",         TELEM_UINT8,  TELEM_SRC_BMS,  bms_t, lowTemp,             500000, 0.5),
+	TELEM_FIELD("battery", "avgCellTemp",         TELEM_UINT8,  TELEM_SRC_BMS,  bms_t, avgTemp,             500000, 0.5),
+	TELEM_FIELD(NULL,      "state",               TELEM_INT,    TELEM_SRC_DATA, data_t, state,              0,      0.5),
+};
+const int numHvTelemFields = sizeof(hvTelemFields) / sizeof(hvTelemFields[0]);
+
+/***
+ * LV packet - Navigation and braking, also what HV_Telem_Recv reads
+ *
+ * Pressures feed the HV board's brake fault checks, so they are never
+ * deadbanded.
+ */
+const telemField_t lvTelemFields[] = {
+	TELEM_NULL_FIELD("motion", "stoppingDistance", 1000000),
+	TELEM_FIELD("motion",  "position",               TELEM_FLOAT,  TELEM_SRC_MOTION,   motion_t,   pos,        0,     0),
+	TELEM_FIELD("motion",  "retro",                  TELEM_INT,    TELEM_SRC_MOTION,   motion_t,   retroCount, 0,     0.5),
+	TELEM_FIELD("motion",  "velocity",               TELEM_FLOAT,  TELEM_SRC_MOTION,   motion_t,   vel,        0,     0),
+	TELEM_FIELD("motion",  "acceleration",           TELEM_FLOAT,  TELEM_SRC_MOTION,   motion_t,   accel,      0,     0),
+	TELEM_FIELD("motion",  "lastRetro",              TELEM_UINT64, TELEM_SRC_TIMERS,   timers_t,   lastRetro,  0,     0.5),
+	TELEM_FIELD("motion",  "retroFault",             TELEM_BOOL,   TELEM_SRC_FLAGS,    flags_t,    retroFault, 0,     0.5),
+	TELEM_FIELD("braking", "pressureVesselPressure", TELEM_DOUBLE, TELEM_SRC_PRESSURE, pressure_t, pv,         50000, 0),
+	TELEM_NULL_FIELD("braking", "currentPressure", 1000000),
+	TELEM_FIELD("braking", "primBrake",              TELEM_INT,    TELEM_SRC_IO,       telemIo_t,  primBrake,  0,     0.5),
+	TELEM_FIELD("braking", "secBrake",               TELEM_INT,    TELEM_SRC_IO,       telemIo_t,  secBrake,   0,     0.5),
+	TELEM_FIELD("braking", "primaryTank",            TELEM_DOUBLE, TELEM_SRC_PRESSURE, pressure_t, primTank,   50000, 0),
+	TELEM_FIELD("braking", "primaryLine",            TELEM_DOUBLE, TELEM_SRC_PRESSURE, pressure_t, primLine,   50000, 0),
+	TELEM_FIELD("braking", "primaryActuation",       TELEM_DOUBLE, TELEM_SRC_PRESSURE, pressure_t, primAct,    50000, 0),
+	TELEM_FIELD("braking", "secondaryTank",          TELEM_DOUBLE, TELEM_SRC_PRESSURE, pressure_t, secTank,    50000, 0),
+	TELEM_FIELD("braking", "secondaryLine",          TELEM_DOUBLE, TELEM_SRC_PRESSURE, pressure_t, secLine,    50000, 0),
+	TELEM_FIELD("braking", "secondaryActuation",     TELEM_DOUBLE, TELEM_SRC_PRESSURE, pressure_t, secAct,     50000, 0),
+	TELEM_FIELD("braking", "readyToBrake",           TELEM_BOOL,   TELEM_SRC_FLAGS,    flags_t,    readyToBrake, 0,   0.5),
+};
+const int numLvTelemFields = sizeof(lvTelemFields) / sizeof(lvTelemFields[0]);
+
+static const uint8_t typeSize[] = {
+	0,                  /* TELEM_NULL */
+	sizeof(float),
+	sizeof(double),
+	sizeof(int),
+	sizeof(int16_t),
+	sizeof(uint8_t),
+	sizeof(uint16_t),
+	sizeof(uint64_t),
+	sizeof(bool)
+};
+
+static void *fieldPtr(const telemField_t *f) {
+	char *base;
+	switch (f->src) {
+		case TELEM_SRC_DATA:        base = (char *) data; break;
+		case TELEM_SRC_BMS:         base = (char *) data->bms; break;
+		case TELEM_SRC_RMS:         base = (char *) data->rms; break;
+		case TELEM_SRC_MOTION:      base = (char *) data->motion; break;
+		case TELEM_SRC_PRESSURE:    base = (char *) data->pressure; break;
+		case TELEM_SRC_TIMERS:      base = (char *) data->timers; break;
+		case TELEM_SRC_FLAGS:       base = (char *) data->flags; break;
+		case TELEM_SRC_IO:          base = (char *) &telemIo; break;
+		default:                    return NULL;
+	}
+	return base + f->offset;
+}
+
+/* Where to read a field from, the snapshot if its struct has one */
+static const void *readPtr(const telemField_t *f, const telemSnapshot_t *snap) {
+	switch (f->src) {
+		case TELEM_SRC_BMS:         return (const char *) &snap->bms + f->offset;
+		case TELEM_SRC_RMS:         return (const char *) &snap->rms + f->offset;
+		case TELEM_SRC_MOTION:      return (const char *) &snap->motion + f->offset;
+		case TELEM_SRC_PRESSURE:    return (const char *) &snap->pressure + f->offset;
+		default:                    return fieldPtr(f);
+	}
+}
+
+/***
+ * telemTakeSnapshot - Copies everything the packets read from data under its
+ *  seqlocks, so one packet never mixes two updates of the same struct
+ */
+void telemTakeSnapshot(telemSnapshot_t *snap) {
+	getBmsSnapshot(&snap->bms);
+	getRmsSnapshot(&snap->rms);
+	getMotionSnapshot(&snap->motion);
+	getPressureSnapshot(&snap->pressure);
+}
+
+/* Current value of a field, only used to compare against the deadband */
+static double fieldValue(const telemField_t *f, const telemSnapshot_t *snap) {
+	const void *p = readPtr(f, snap);
+	switch (f->type) {
+		case TELEM_FLOAT:   return *(const float *) p;
+		case TELEM_DOUBLE:  return *(const double *) p;
+		case TELEM_INT:     return *(const int *) p;
+		case TELEM_INT16:   return *(const int16_t *) p;
+		case TELEM_UINT8:   return *(const uint8_t *) p;
+		case TELEM_UINT16:  return *(const uint16_t *) p;
+		case TELEM_UINT64:  return (double) *(const uint64_t *) p;
+		case TELEM_BOOL:    return *(const bool *) p;
+		default:            return 0;
+	}
+}
+
+/***
+ * telemDueFields - Works out which fields go in the packet sent at now (uS)
+ *  and marks them as sent
+ *
+ * RETURNS: Bit i set if fields[i] is due, 0 if there is nothing to send
+ */
+uint64_t telemDueFields(const telemField_t *fields, telemFieldState_t *state, int n,
+		const telemSnapshot_t *snap, uint64_t now) {
+	uint64_t mask = 0;
+	int i;
+	for (i = 0; i < n && i < TELEM_MAX_FIELDS; i++) {
+		const telemField_t *f = &fields[i];
+		telemFieldState_t *s = &state[i];
+		uint64_t since = now - s->lastSent;
+		double val = 0;
+
+		if (s->sent && since < f->periodUs) continue;
+		if (f->deadband > 0) {
+			val = fieldValue(f, snap);
+			if (s->sent && since < TELEM_REFRESH_US && fabs(val - s->lastValue) <= f->deadband) {
+				continue;
+			}
+		}
+		s->lastSent = now;
+		s->lastValue = val;
+		s->sent = true;
+		mask |= 1ULL << i;
+	}
+	return mask;
+}
+
+static void writeJsonValue(const telemField_t *f, const telemSnapshot_t *snap,
+		TelemWriter &writer) {
+	const void *p = readPtr(f, snap);
+	double d;
+	switch (f->type) {
+		case TELEM_FLOAT:
+		case TELEM_DOUBLE:
+			d = f->type == TELEM_FLOAT ? *(const float *) p : *(const double *) p;
+			/* The Writer can't print NaN or inf, and would leave the key hanging */
+			if (std::isfinite(d)) writer.Double(d);
+			else writer.Null();
+			break;
+		case TELEM_INT:     writer.Int(*(const int *) p); break;
+		case TELEM_INT16:   writer.Int(*(const int16_t *) p); break;
+		case TELEM_UINT8:   writer.Uint(*(const uint8_t *) p); break;
+		case TELEM_UINT16:  writer.Uint(*(const uint16_t *) p); break;
+		case TELEM_UINT64:  writer.Uint64(*(const uint64_t *) p); break;
+		case TELEM_BOOL:    writer.Int(*(const bool *) p); break;
+		default:            writer.Null(); break;
+	}
+}
+
+static bool sameGroup(const char *a, const char *b) {
+	if (a == NULL || b == NULL) return a == b;
+	return strcmp(a, b) == 0;
+}
+
+/***
+ * telemJsonPacket - Serializes the fields in mask into buf through writer,
+ *  nested in their groups, with the SAX API so nothing is allocated
+ *
+ * RETURNS: Length of the packet, 0 if it did not fit in buf
+ */
+size_t telemJsonPacket(const telemField_t *fields, int n, uint64_t mask,
+		const telemSnapshot_t *snap, TelemWriter &writer, TelemBuffer &buf, uint64_t id,
+		uint64_t timeMs) {
+	const char *openGroup = NULL;
+	int i;
+
+	buf.Clear();
+	writer.Reset(buf);
+
+	writer.StartObject();
+	TELEM_KEY(writer, "id"); writer.Uint64(id);
+	TELEM_KEY(writer, "time"); writer.Uint64(timeMs);
+	for (i = 0; i < n && i < TELEM_MAX_FIELDS; i++) {
+		if (!(mask & (1ULL << i))) continue;
+		const telemField_t *f = &fields[i];
+		if (!sameGroup(f->group, openGroup)) {
+			if (openGroup != NULL) writer.EndObject();
+			if (f->group != NULL) {
+				writer.Key(f->group);
+				writer.StartObject();
+			}
+			openGroup = f->group;
+		}
+		writer.Key(f->key);
+		writeJsonValue(f, snap, writer);
+	}
+	if (openGroup != NULL) writer.EndObject();
+	writer.EndObject();
+
+	if (buf.Overflowed()) {
+		fprintf(stderr, "Telemetry packet too big, dropped\n");
+		return 0;
+	}
+	return buf.GetSize();
+}
+
+/***
+ * telemBinPacket - Packs the fields in mask into buf in the binary format
+ *  from TelemBinary.h. buf has to hold TELEM_MAX_PACKET bytes.
+ *
+ * RETURNS: Length of the packet
+ */
+size_t telemBinPacket(const telemField_t *fields, int n, uint64_t mask,
+		const telemSnapshot_t *snap, uint8_t type, char *buf, uint64_t id, uint64_t timeMs) {
+	telemBinHeader_t hdr;
+	size_t len = sizeof(hdr);
+	int i;
+
+	memcpy(buf + len, &mask, sizeof(mask));
+	len += sizeof(mask);
+	for (i = 0; i < n && i < TELEM_MAX_FIELDS; i++) {
+		if (!(mask & (1ULL << i)) || fields[i].type == TELEM_NULL) continue;
+		memcpy(buf + len, readPtr(&fields[i], snap), typeSize[fields[i].type]);
+		len += typeSize[fields[i].type];
+	}
+	telemBinSetHeader(&hdr, type, len - sizeof(hdr), id, timeMs);
+	memcpy(buf, &hdr, sizeof(hdr));
+	return len;
+}
+
+static void readJsonValue(const telemField_t *f, const Value &v) {
+	void *p = fieldPtr(f);
+	if (p == NULL || !v.IsNumber()) return;
+	switch (f->type) {
+		case TELEM_FLOAT:   *(float *) p = v.GetFloat(); break;
+		case TELEM_DOUBLE:  *(double *) p = v.GetDouble(); break;
+		case TELEM_INT:     if (v.IsInt()) *(int *) p = v.GetInt(); break;
+		case TELEM_INT16:   if (v.IsInt()) *(int16_t *) p = v.GetInt(); break;
+		case TELEM_UINT8:   if (v.IsUint()) *(uint8_t *) p = v.GetUint(); break;
+		case TELEM_UINT16:  if (v.IsUint()) *(uint16_t *) p = v.GetUint(); break;
+		case TELEM_UINT64:  if (v.IsUint64()) *(uint64_t *) p = v.GetUint64(); break;
+		case TELEM_BOOL:    if (v.IsInt()) *(bool *) p = v.GetInt() != 0; break;
+		default:            break;
+	}
+}
+
+/***
+ * telemJsonApply - Copies every field found in a parsed JSON packet into
+ *  data, fields that aren't in the packet keep their last value
+ *
+ * RETURNS: 0 on success, -1 if doc isn't a packet
+ */
+int telemJsonApply(const telemField_t *fields, int n, const Value &doc) {
+	int i;
+	if (!doc.IsObject()) return -1;
+	for (i = 0; i < n; i++) {
+		const Value *obj = &doc;
+		if (fields[i].group != NULL) {
+			Value::ConstMemberIterator g = doc.FindMember(fields[i].group);
+			if (g == doc.MemberEnd() || !g->value.IsObject()) continue;
+			obj = &g->value;
+		}
+		Value::ConstMemberIterator m = obj->FindMember(fields[i].key);
+		if (m != obj->MemberEnd()) readJsonValue(&fields[i], m->value);
+	}
+	return 0;
+}
+
+/***
+ * telemBinApply - Copies every field in a binary payload into data
+ *
+ * RETURNS: 0 on success, -1 if the payload is short
+ */
+int telemBinApply(const telemField_t *fields, int n, const char *payload, int len) {
+	uint64_t mask;
+	int pos = sizeof(mask), i;
+	if (len < (int) sizeof(mask)) return -1;
+	memcpy(&mask, payload, sizeof(mask));
+	for (i = 0; i < n && i < TELEM_MAX_FIELDS; i++) {
+		if (!(mask & (1ULL << i)) || fields[i].type == TELEM_NULL) continue;
+		if (pos + typeSize[fields[i].type] > len) return -1;
+		memcpy(fieldPtr(&fields[i]), payload + pos, typeSize[fields[i].type]);
+		pos += typeSize[fields[i].type];
+	}
+	return 0;
+}
@@ -4,6 +4,7 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include <connStat.h>
+#include <periodic.h>
 
 #define HB_DELAY 2000000
 #define SLP      100000
@@ -26,7 +27,9 @@ bool checkTCPStatHV() {
 
 void *connStatUDPLoop(void *timestamp) {
     uint64_t *lastPacket = (uint64_t *) timestamp;
+    periodic_t task;
 
+    periodicInit(&task, "connStatUDP", SLP);
     while(1)
     {
     if ((getuSTimestamp() - *lastPacket) > HB_DELAY) {
@@ -34,32 +37,36 @@ void *connStatUDPLoop(void *timestamp) {
     } else {
         udpStat = true;
     }
-    usleep(SLP);
+    periodicWait(&task);
     }
 }
 
 void *connStatTCPLoop(void *timestamp) {
     uint64_t *lastPacket = (uint64_t *) timestamp;
+    periodic_t task;
 
+    periodicInit(&task, "connStatTCP", SLP);
     while (1) {
         if ((getuSTimestamp() - *lastPacket) > HB_DELAY) {
             tcpStat = false;
         } else {
             tcpStat = true;
         }
-        usleep(SLP);
+        periodicWait(&task);
     }
 }
 
 void *connStatTCPLoopHV(void *timestamp) {
     uint64_t *lastPacket = (uint64_t *) timestamp;
+    periodic_t task;
 
+    periodicInit(&task, "connStatHV", SLP);
     while (1) {
         if ((getuSTimestamp() - *lastPacket) > HB_DELAY) {
             tcpStatHV = false;
         } else {
             tcpStatHV = true;
         }
-        usleep(SLP);
+        periodicWait(&task);
     }
 }